@@ -8,9 +8,59 @@
 	void wg_mutex_lock(void *mtx){if (mtx) WaitForSingleObject(mtx,INFINITE);}
 	void wg_mutex_unlock(void *mtx){if (mtx) ReleaseMutex(mtx);}
 
+	struct wg_thread {
+		void *(*entry)(void *);
+		void *arg;
+		HANDLE handle;
+	};
+
+	static DWORD WINAPI wg_thread_entry(LPVOID param)
+	{
+		struct wg_thread *thread = param;
+		thread->entry(thread->arg);
+		return 0;
+	}
+
+	void *wg_thread_create(void *(*entry)(void *),void *arg)
+	{
+		struct wg_thread *thread = malloc(sizeof(struct wg_thread));
+		if (thread != NULL) {
+			thread->entry = entry;
+			thread->arg = arg;
+			thread->handle = CreateThread(NULL,0,wg_thread_entry,thread,0,NULL);
+			if (!thread->handle) {
+				free(thread);
+				thread = NULL;
+			}
+		}
+		return thread;
+	}
+
+	void wg_thread_join(void *thread)
+	{
+		struct wg_thread *t = thread;
+		WaitForSingleObject(t->handle,INFINITE);
+		CloseHandle(t->handle);
+		free(t);
+	}
+
+	int wg_cpu_count(void)
+	{
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+	}
+
+	long long wg_time_ms(void)
+	{
+		return (long long)GetTickCount64();
+	}
+
 #else
 
 #include <pthread.h>
+#include <unistd.h>
+#include <time.h>
 
 
 void *wg_mutex_create(void)
@@ -37,4 +87,34 @@ void wg_mutex_unlock(void *mutex)
 {
 	pthread_mutex_unlock(mutex);
 }
+
+void *wg_thread_create(void *(*entry)(void *),void *arg)
+{
+	pthread_t *thread;
+	thread = malloc(sizeof(pthread_t));
+	if (thread != NULL && pthread_create(thread,NULL,entry,arg)) {
+		free(thread);
+		thread = NULL;
+	}
+	return thread;
+}
+
+void wg_thread_join(void *thread)
+{
+	pthread_join(*(pthread_t *)thread,NULL);
+	free(thread);
+}
+
+int wg_cpu_count(void)
+{
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	return cpus > 0 ? (int)cpus : 1;
+}
+
+long long wg_time_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
 #endif
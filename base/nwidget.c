@@ -854,6 +854,23 @@ static int do_redraw(struct nwidget *widget)
 }
 
 
+/**
+  * @brief    执行桌面上控件的定时任务
+  * @param    widget : 控件
+  * @return   成功返回 0
+*/
+static int do_tick(struct nwidget *widget)
+{
+	struct nwidget *wg;
+	if (widget->tick)
+		widget->tick(widget);
+	for (wg = widget->sub; wg; wg = wg->next){
+		do_tick(wg);
+	}
+	return 0;
+}
+
+
 /**
   * @brief    接收输入，交由 curses 托管
   * @return   0 
@@ -871,6 +888,7 @@ int desktop_editing(void)
 		if (key > 0 && desktop_keyboard(key) < 0)
 			break;
 
+		do_tick(&desktop);
 		if (desktop.editing > 1) {
 			/* 需要执行刷新操作 */
 			desktop.editing = 1;
@@ -0,0 +1,169 @@
+/**
+  ******************************************************************************
+  * @file
+  * @author      GoodMorning
+  * @brief       分块内存池
+  ******************************************************************************
+  *
+  * COPYRIGHT(c) GoodMorning
+  *
+  ******************************************************************************
+  */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdlib.h>
+#include "wg_arena.h"
+
+/* Private macro ------------------------------------------------------------*/
+
+/* 分配的内存按此对齐 */
+#define ARENA_ALIGN (sizeof(void *) * 2)
+#define ARENA_ROUND(x) (((x) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+/* Private types ------------------------------------------------------------*/
+
+/** 内存块 */
+struct arena_chunk {
+	struct wg_list node;/**< 必须为第一个成员 */
+	size_t size;/**< 块的总大小 */
+	size_t used;/**< 已分配的字节数，含块头 */
+	size_t count;/**< 块内仍在使用的分配数 */
+};
+
+/** 每次分配的头部，记录所属的块以便释放 */
+struct arena_block {
+	struct arena_chunk *chunk;
+	size_t size;
+};
+
+#define CHUNK_HEAD ARENA_ROUND(sizeof(struct arena_chunk))
+#define BLOCK_HEAD ARENA_ROUND(sizeof(struct arena_block))
+
+/* Private variables --------------------------------------------------------*/
+/* Global  variables --------------------------------------------------------*/
+/* Private function prototypes ----------------------------------------------*/
+/* Gorgeous Split-line ------------------------------------------------------*/
+
+/**
+  * @brief    初始化内存池
+  * @param    chunk_size : 块大小，为 0 时使用 WG_ARENA_CHUNK
+*/
+void wg_arena_init(struct wg_arena *arena,size_t chunk_size)
+{
+	wg_list_init(&arena->chunks);
+	arena->chunk_size = chunk_size ? chunk_size : WG_ARENA_CHUNK;
+	arena->reserved = 0;
+	arena->live = 0;
+}
+
+
+/**
+  * @brief    从内存池中分配内存
+  * @return   成功返回内存，否则返回 NULL
+*/
+void *wg_arena_alloc(struct wg_arena *arena,size_t size)
+{
+	struct arena_chunk *chunk = NULL;
+	struct arena_block *block;
+	size_t need = BLOCK_HEAD + ARENA_ROUND(size);
+
+	if (arena->chunks.prev != &arena->chunks) {
+		chunk = (struct arena_chunk *)arena->chunks.prev;
+		if (chunk->used + need > chunk->size)
+			chunk = NULL;
+	}
+
+	/* 当前块空间不足，申请新块 */
+	if (!chunk) {
+		size_t chunk_size = CHUNK_HEAD + need;
+		if (chunk_size < arena->chunk_size)
+			chunk_size = arena->chunk_size;
+		if (NULL == (chunk = malloc(chunk_size))) {
+			return NULL;
+		}
+		chunk->size = chunk_size;
+		chunk->used = CHUNK_HEAD;
+		chunk->count = 0;
+		wg_list_add_tail(&chunk->node,&arena->chunks);
+		arena->reserved += chunk_size;
+	}
+
+	block = (struct arena_block *)((char *)chunk + chunk->used);
+	block->chunk = chunk;
+	block->size = need;
+	chunk->used += need;
+	chunk->count++;
+	arena->live += need;
+	return (char *)block + BLOCK_HEAD;
+}
+
+
+/**
+  * @brief    释放一块由 wg_arena_alloc() 分配的内存
+  * @note     块内的内存全部释放后该块归还系统
+*/
+void wg_arena_free(struct wg_arena *arena,void *ptr)
+{
+	struct arena_block *block;
+	struct arena_chunk *chunk;
+
+	if (!ptr) {
+		return;
+	}
+
+	block = (struct arena_block *)((char *)ptr - BLOCK_HEAD);
+	chunk = block->chunk;
+	arena->live -= block->size;
+	if (--chunk->count) {
+		return;
+	}
+
+	/* 当前分配的块只重置，其余空块归还系统 */
+	if (chunk->node.next == &arena->chunks) {
+		chunk->used = CHUNK_HEAD;
+	} else {
+		wg_list_del(&chunk->node);
+		arena->reserved -= chunk->size;
+		free(chunk);
+	}
+}
+
+
+/**
+  * @brief    获取一块由 wg_arena_alloc() 分配的内存的可用大小，不小于申请的大小
+*/
+size_t wg_arena_size(void *ptr)
+{
+	struct arena_block *block = (struct arena_block *)((char *)ptr - BLOCK_HEAD);
+	return block->size - BLOCK_HEAD;
+}
+
+
+/**
+  * @brief    将所有块移交给 dst，arena 变为空池
+*/
+void wg_arena_move(struct wg_arena *dst,struct wg_arena *arena)
+{
+	*dst = *arena;
+	if (wg_list_empty(&arena->chunks)) {
+		wg_list_init(&dst->chunks);
+	} else {
+		dst->chunks.next->prev = &dst->chunks;
+		dst->chunks.prev->next = &dst->chunks;
+	}
+	wg_arena_init(arena,arena->chunk_size);
+}
+
+
+/**
+  * @brief    释放内存池中的所有内存，耗时只与块数有关
+*/
+void wg_arena_release(struct wg_arena *arena)
+{
+	struct wg_list *node,*next;
+	for (node = arena->chunks.next; node != &arena->chunks; node = next) {
+		next = node->next;
+		free(node);
+	}
+	wg_arena_init(arena,arena->chunk_size);
+}
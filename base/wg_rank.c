@@ -0,0 +1,360 @@
+/**
+  ******************************************************************************
+  * @file
+  * @author      GoodMorning
+  * @brief       带序号索引的平衡树(treap)
+  ******************************************************************************
+  *
+  * COPYRIGHT(c) GoodMorning
+  *
+  ******************************************************************************
+  */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stddef.h>
+#include "wg_rank.h"
+
+/* Private macro ------------------------------------------------------------*/
+
+/* 重建树时按深度分段分配优先级，保证父节点优先级高于子节点 */
+#define BUILD_BAND_BITS 26
+
+/* Private types ------------------------------------------------------------*/
+/* Private variables --------------------------------------------------------*/
+/* Global  variables --------------------------------------------------------*/
+/* Private function prototypes ----------------------------------------------*/
+/* Gorgeous Split-line ------------------------------------------------------*/
+
+static inline unsigned int node_size(const struct wg_rank_node *node)
+{
+	return node ? node->size : 0;
+}
+
+
+/**
+  * @brief    xorshift 伪随机数，生成 treap 优先级
+*/
+static unsigned int rank_random(struct wg_rank_tree *tree)
+{
+	unsigned int x = tree->seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	tree->seed = x;
+	return x;
+}
+
+
+/**
+  * @brief    用 child 替换 node 在其父节点中的位置
+*/
+static void rank_replace(struct wg_rank_tree *tree,struct wg_rank_node *node,struct wg_rank_node *child)
+{
+	struct wg_rank_node *parent = node->parent;
+	if (!parent)
+		tree->root = child;
+	else if (parent->left == node)
+		parent->left = child;
+	else
+		parent->right = child;
+	if (child)
+		child->parent = parent;
+}
+
+
+/**
+  * @brief    左旋，node 的右子节点上升为 node 的父节点
+*/
+static void rank_rotate_left(struct wg_rank_tree *tree,struct wg_rank_node *node)
+{
+	struct wg_rank_node *up = node->right;
+
+	node->right = up->left;
+	if (up->left)
+		up->left->parent = node;
+	rank_replace(tree,node,up);
+	up->left = node;
+	node->parent = up;
+
+	up->size = node->size;
+	node->size = 1 + node_size(node->left) + node_size(node->right);
+}
+
+
+/**
+  * @brief    右旋，node 的左子节点上升为 node 的父节点
+*/
+static void rank_rotate_right(struct wg_rank_tree *tree,struct wg_rank_node *node)
+{
+	struct wg_rank_node *up = node->left;
+
+	node->left = up->right;
+	if (up->right)
+		up->right->parent = node;
+	rank_replace(tree,node,up);
+	up->right = node;
+	node->parent = up;
+
+	up->size = node->size;
+	node->size = 1 + node_size(node->left) + node_size(node->right);
+}
+
+
+/**
+  * @brief    新插入的叶子节点按优先级上浮
+*/
+static void rank_sift_up(struct wg_rank_tree *tree,struct wg_rank_node *node)
+{
+	while (node->parent && node->prio > node->parent->prio) {
+		if (node->parent->left == node)
+			rank_rotate_right(tree,node->parent);
+		else
+			rank_rotate_left(tree,node->parent);
+	}
+}
+
+
+/**
+  * @brief    获取第 index 个节点
+  * @return   成功返回节点，越界返回 NULL
+*/
+struct wg_rank_node *wg_rank_at(const struct wg_rank_tree *tree,int index)
+{
+	struct wg_rank_node *node = tree->root;
+	unsigned int left;
+
+	if (index < 0 || index >= wg_rank_count(tree)) {
+		return NULL;
+	}
+
+	while (node) {
+		left = node_size(node->left);
+		if ((unsigned int)index < left) {
+			node = node->left;
+		} else if ((unsigned int)index == left) {
+			break;
+		} else {
+			index -= left + 1;
+			node = node->right;
+		}
+	}
+	return node;
+}
+
+
+/**
+  * @brief    获取节点在树中的序号
+  * @return   节点序号，从 0 开始
+*/
+int wg_rank_of(const struct wg_rank_node *node)
+{
+	int index = node_size(node->left);
+	for ( ; node->parent ; node = node->parent) {
+		if (node->parent->right == node)
+			index += node_size(node->parent->left) + 1;
+	}
+	return index;
+}
+
+
+/**
+  * @brief    插入节点，使之成为树的第 index 个节点
+  * @note     index 大于等于节点总数时插入至末尾
+*/
+void wg_rank_insert_at(struct wg_rank_tree *tree,struct wg_rank_node *node,int index)
+{
+	struct wg_rank_node *cur = tree->root;
+	unsigned int left;
+
+	node->left = node->right = NULL;
+	node->size = 1;
+	node->prio = rank_random(tree);
+	if (!cur) {
+		node->parent = NULL;
+		tree->root = node;
+		return;
+	}
+
+	if (index < 0)
+		index = 0;
+
+	for (;;) {
+		cur->size++;
+		left = node_size(cur->left);
+		if ((unsigned int)index <= left) {
+			if (!cur->left) {
+				cur->left = node;
+				break;
+			}
+			cur = cur->left;
+		} else {
+			index -= left + 1;
+			if (!cur->right) {
+				cur->right = node;
+				break;
+			}
+			cur = cur->right;
+		}
+	}
+
+	node->parent = cur;
+	rank_sift_up(tree,node);
+}
+
+
+/**
+  * @brief    按比较函数有序插入节点，相等的节点插入至其后
+  * @return   节点插入后的序号
+*/
+int wg_rank_insert(struct wg_rank_tree *tree,struct wg_rank_node *node,wg_rank_cmp_t cmp,void *arg)
+{
+	struct wg_rank_node *cur = tree->root;
+	int index = 0;
+
+	node->left = node->right = NULL;
+	node->size = 1;
+	node->prio = rank_random(tree);
+	if (!cur) {
+		node->parent = NULL;
+		tree->root = node;
+		return 0;
+	}
+
+	for (;;) {
+		cur->size++;
+		if (cmp(node,cur,arg) < 0) {
+			if (!cur->left) {
+				cur->left = node;
+				break;
+			}
+			cur = cur->left;
+		} else {
+			index += node_size(cur->left) + 1;
+			if (!cur->right) {
+				cur->right = node;
+				break;
+			}
+			cur = cur->right;
+		}
+	}
+
+	node->parent = cur;
+	rank_sift_up(tree,node);
+	return index;
+}
+
+
+/**
+  * @brief    从树中删除节点
+*/
+void wg_rank_erase(struct wg_rank_tree *tree,struct wg_rank_node *node)
+{
+	struct wg_rank_node *child,*parent;
+
+	/* 将节点旋转至最多只有一个子节点的位置 */
+	while (node->left && node->right) {
+		if (node->left->prio > node->right->prio)
+			rank_rotate_right(tree,node);
+		else
+			rank_rotate_left(tree,node);
+	}
+
+	child = node->left ? node->left : node->right;
+	parent = node->parent;
+	rank_replace(tree,node,child);
+	for ( ; parent ; parent = parent->parent) {
+		parent->size--;
+	}
+
+	node->parent = node->left = node->right = NULL;
+	node->size = 0;
+}
+
+
+/**
+  * @brief    递归构建完全平衡的子树
+*/
+static struct wg_rank_node *rank_build(struct wg_rank_tree *tree,
+	struct wg_rank_node **nodes,int n,int depth,struct wg_rank_node *parent)
+{
+	struct wg_rank_node *node;
+	unsigned int band;
+	int mid;
+
+	if (n < 1) {
+		return NULL;
+	}
+
+	mid = n / 2;
+	node = nodes[mid];
+	node->parent = parent;
+	node->size = n;
+
+	/* 每层占用一段优先级区间，越深的节点优先级越低 */
+	band = depth < 63 ? (unsigned int)depth : 63;
+	node->prio = 0xffffffffu - (band << BUILD_BAND_BITS) -
+		(rank_random(tree) & ((1u << BUILD_BAND_BITS) - 1));
+
+	node->left = rank_build(tree,nodes,mid,depth+1,node);
+	node->right = rank_build(tree,nodes + mid + 1,n - mid - 1,depth+1,node);
+	return node;
+}
+
+
+/**
+  * @brief    以已排好序的节点数组重建整棵树，O(n)
+  * @param    nodes : 节点数组
+  * @param    n : 节点数
+*/
+void wg_rank_build(struct wg_rank_tree *tree,struct wg_rank_node **nodes,int n)
+{
+	tree->root = rank_build(tree,nodes,n,0,NULL);
+}
+
+
+struct wg_rank_node *wg_rank_first(const struct wg_rank_tree *tree)
+{
+	struct wg_rank_node *node = tree->root;
+	while (node && node->left)
+		node = node->left;
+	return node;
+}
+
+
+struct wg_rank_node *wg_rank_last(const struct wg_rank_tree *tree)
+{
+	struct wg_rank_node *node = tree->root;
+	while (node && node->right)
+		node = node->right;
+	return node;
+}
+
+
+struct wg_rank_node *wg_rank_next(const struct wg_rank_node *node)
+{
+	if (node->right) {
+		node = node->right;
+		while (node->left)
+			node = node->left;
+		return (struct wg_rank_node *)node;
+	}
+
+	while (node->parent && node->parent->right == node)
+		node = node->parent;
+	return node->parent;
+}
+
+
+struct wg_rank_node *wg_rank_prev(const struct wg_rank_node *node)
+{
+	if (node->left) {
+		node = node->left;
+		while (node->right)
+			node = node->right;
+		return (struct wg_rank_node *)node;
+	}
+
+	while (node->parent && node->parent->left == node)
+		node = node->parent;
+	return node->parent;
+}
@@ -0,0 +1,316 @@
+/**
+  ******************************************************************************
+  * @file
+  * @author      GoodMorning
+  * @brief       检索相关：向量化子串查找，多线程分段执行
+  ******************************************************************************
+  *
+  * COPYRIGHT(c) GoodMorning
+  *
+  ******************************************************************************
+  */
+
+/* Includes -----------------------------------------------------------------*/
+#include <string.h>
+#include "wg_mutex.h"
+#include "wg_search.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define SEARCH_X86 1
+	#include <immintrin.h>
+#endif
+
+/* Private macro ------------------------------------------------------------*/
+/* Private types ------------------------------------------------------------*/
+
+typedef const char *(*memmem_t)(const char *,size_t,const char *,size_t);
+typedef const char *(*memchr3_t)(const char *,size_t,int,int,int);
+
+/** wg_parallel_for() 的一个分段 */
+struct parallel_task {
+	void (*func)(void *arg,int start,int end);
+	void *arg;
+	int start,end;
+};
+
+/* Private variables --------------------------------------------------------*/
+static memmem_t memmem_impl = NULL;
+static memchr3_t memchr3_impl = NULL;
+static const char *memmem_name = "scalar";
+
+/* Global  variables --------------------------------------------------------*/
+/* Private function prototypes ----------------------------------------------*/
+/* Gorgeous Split-line ------------------------------------------------------*/
+
+/**
+  * @brief    标量实现，memchr 定位首字符后比较
+*/
+static const char *memmem_scalar(const char *haystack,size_t hlen,const char *needle,size_t nlen)
+{
+	const char *end,*ptr = haystack;
+
+	if (nlen == 0) {
+		return haystack;
+	}
+	if (nlen > hlen) {
+		return NULL;
+	}
+
+	end = haystack + hlen - nlen;
+	while (ptr <= end) {
+		ptr = memchr(ptr,needle[0],end - ptr + 1);
+		if (!ptr) {
+			return NULL;
+		}
+		if (!memcmp(ptr + 1,needle + 1,nlen - 1)) {
+			return ptr;
+		}
+		ptr++;
+	}
+	return NULL;
+}
+
+
+/**
+  * @brief    标量实现，逐字节查找三个字符中的任意一个
+*/
+static const char *memchr3_scalar(const char *s,size_t len,int a,int b,int c)
+{
+	for (const char *end = s + len; s < end; s++) {
+		if (*s == (char)a || *s == (char)b || *s == (char)c)
+			return s;
+	}
+	return NULL;
+}
+
+
+#ifdef SEARCH_X86
+/**
+  * @brief    SSE2 实现：每次比较 16 个字节
+*/
+__attribute__((target("sse2")))
+static const char *memchr3_sse2(const char *s,size_t len,int a,int b,int c)
+{
+	__m128i va = _mm_set1_epi8(a),vb = _mm_set1_epi8(b),vc = _mm_set1_epi8(c),block;
+	unsigned int mask;
+	size_t i = 0;
+
+	for ( ; i + 16 <= len; i += 16) {
+		block = _mm_loadu_si128((const __m128i *)(s + i));
+		mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block,va),
+			_mm_or_si128(_mm_cmpeq_epi8(block,vb),_mm_cmpeq_epi8(block,vc))));
+		if (mask)
+			return s + i + __builtin_ctz(mask);
+	}
+	return memchr3_scalar(s + i,len - i,a,b,c);
+}
+
+
+/**
+  * @brief    AVX2 实现：每次比较 32 个字节
+*/
+__attribute__((target("avx2")))
+static const char *memchr3_avx2(const char *s,size_t len,int a,int b,int c)
+{
+	__m256i va = _mm256_set1_epi8(a),vb = _mm256_set1_epi8(b),vc = _mm256_set1_epi8(c),block;
+	unsigned int mask;
+	size_t i = 0;
+
+	for ( ; i + 32 <= len; i += 32) {
+		block = _mm256_loadu_si256((const __m256i *)(s + i));
+		mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block,va),
+			_mm256_or_si256(_mm256_cmpeq_epi8(block,vb),_mm256_cmpeq_epi8(block,vc))));
+		if (mask)
+			return s + i + __builtin_ctz(mask);
+	}
+	return memchr3_sse2(s + i,len - i,a,b,c);
+}
+
+
+/**
+  * @brief    SSE2 实现：同时比较子串首尾字符，每次检查 16 个候选位置
+*/
+__attribute__((target("sse2")))
+static const char *memmem_sse2(const char *haystack,size_t hlen,const char *needle,size_t nlen)
+{
+	__m128i first,last,block_first,block_last;
+	unsigned int mask;
+	size_t i = 0;
+
+	if (nlen < 2) {
+		return nlen ? memchr(haystack,needle[0],hlen) : haystack;
+	}
+
+	first = _mm_set1_epi8(needle[0]);
+	last = _mm_set1_epi8(needle[nlen-1]);
+	for ( ; i + nlen - 1 + 16 <= hlen; i += 16) {
+		block_first = _mm_loadu_si128((const __m128i *)(haystack + i));
+		block_last = _mm_loadu_si128((const __m128i *)(haystack + i + nlen - 1));
+		mask = _mm_movemask_epi8(_mm_and_si128(
+			_mm_cmpeq_epi8(first,block_first),_mm_cmpeq_epi8(last,block_last)));
+		while (mask) {
+			int bit = __builtin_ctz(mask);
+			if (!memcmp(haystack + i + bit + 1,needle + 1,nlen - 2))
+				return haystack + i + bit;
+			mask &= mask - 1;
+		}
+	}
+
+	/* 不足一个块的剩余部分 */
+	return memmem_scalar(haystack + i,hlen - i,needle,nlen);
+}
+
+
+/**
+  * @brief    AVX2 实现：每次检查 32 个候选位置
+*/
+__attribute__((target("avx2")))
+static const char *memmem_avx2(const char *haystack,size_t hlen,const char *needle,size_t nlen)
+{
+	__m256i first,last,block_first,block_last;
+	unsigned int mask;
+	size_t i = 0;
+
+	if (nlen < 2) {
+		return nlen ? memchr(haystack,needle[0],hlen) : haystack;
+	}
+
+	first = _mm256_set1_epi8(needle[0]);
+	last = _mm256_set1_epi8(needle[nlen-1]);
+	for ( ; i + nlen - 1 + 32 <= hlen; i += 32) {
+		block_first = _mm256_loadu_si256((const __m256i *)(haystack + i));
+		block_last = _mm256_loadu_si256((const __m256i *)(haystack + i + nlen - 1));
+		mask = _mm256_movemask_epi8(_mm256_and_si256(
+			_mm256_cmpeq_epi8(first,block_first),_mm256_cmpeq_epi8(last,block_last)));
+		while (mask) {
+			int bit = __builtin_ctz(mask);
+			if (!memcmp(haystack + i + bit + 1,needle + 1,nlen - 2))
+				return haystack + i + bit;
+			mask &= mask - 1;
+		}
+	}
+
+	return memmem_sse2(haystack + i,hlen - i,needle,nlen);
+}
+#endif
+
+
+/**
+  * @brief    根据 CPU 特性选择实现
+*/
+static memmem_t memmem_select(void)
+{
+	memmem_t impl = memmem_scalar;
+	memchr3_t chr3 = memchr3_scalar;
+	#ifdef SEARCH_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		impl = memmem_avx2;
+		chr3 = memchr3_avx2;
+		memmem_name = "avx2";
+	} else if (__builtin_cpu_supports("sse2")) {
+		impl = memmem_sse2;
+		chr3 = memchr3_sse2;
+		memmem_name = "sse2";
+	}
+	#endif
+	memchr3_impl = chr3;
+	memmem_impl = impl;
+	return impl;
+}
+
+
+/**
+  * @brief    在 haystack 中查找子串 needle
+  * @return   找到返回子串在 haystack 中的位置，否则返回 NULL
+*/
+const char *wg_memmem(const char *haystack,size_t hlen,const char *needle,size_t nlen)
+{
+	memmem_t impl = memmem_impl;
+	if (!impl) {
+		impl = memmem_select();
+	}
+	return impl(haystack,hlen,needle,nlen);
+}
+
+
+/**
+  * @brief    查找 a,b,c 三个字符中最先出现的一个
+  * @return   找到返回其位置，否则返回 NULL
+*/
+const char *wg_memchr3(const char *s,size_t len,int a,int b,int c)
+{
+	if (!memchr3_impl) {
+		memmem_select();
+	}
+	return memchr3_impl(s,len,a,b,c);
+}
+
+
+/**
+  * @brief    当前 wg_memmem() 所使用的实现
+*/
+const char *wg_memmem_impl(void)
+{
+	if (!memmem_impl) {
+		memmem_select();
+	}
+	return memmem_name;
+}
+
+
+static void *parallel_entry(void *arg)
+{
+	struct parallel_task *task = arg;
+	task->func(task->arg,task->start,task->end);
+	return NULL;
+}
+
+
+/**
+  * @brief    将 [0,count) 分段交由多个线程并行执行，返回时所有分段已执行完毕
+  * @param    count : 总数
+  * @param    min_chunk : 每个线程最少处理的数目，总数较少时只在当前线程执行
+  * @param    func : 分段处理函数，处理 [start,end)
+  * @param    arg : func 的参数
+*/
+void wg_parallel_for(int count,int min_chunk,void (*func)(void *arg,int start,int end),void *arg)
+{
+	struct parallel_task task[WG_PARALLEL_MAX];
+	void *thread[WG_PARALLEL_MAX];
+	int threads,chunk,start = 0;
+
+	threads = wg_cpu_count();
+	if (threads > WG_PARALLEL_MAX)
+		threads = WG_PARALLEL_MAX;
+	if (min_chunk < 1)
+		min_chunk = 1;
+	if (threads > count / min_chunk)
+		threads = count / min_chunk;
+
+	if (threads < 2) {
+		if (count > 0)
+			func(arg,0,count);
+		return;
+	}
+
+	/* 最后一段在当前线程执行 */
+	chunk = (count + threads - 1) / threads;
+	for (int i = 0; i < threads; i++) {
+		task[i].func = func;
+		task[i].arg = arg;
+		task[i].start = start;
+		task[i].end = (start + chunk < count) ? start + chunk : count;
+		start = task[i].end;
+		thread[i] = NULL;
+		if (i < threads - 1)
+			thread[i] = wg_thread_create(parallel_entry,&task[i]);
+		if (!thread[i])
+			func(arg,task[i].start,task[i].end);
+	}
+
+	for (int i = 0; i < threads - 1; i++) {
+		if (thread[i])
+			wg_thread_join(thread[i]);
+	}
+}
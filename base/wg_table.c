@@ -15,8 +15,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+	#include <poll.h>
+	#include <sys/mman.h>
+#endif
 #include "wg_mutex.h"
 #include "wg_table.h"
+#include "wg_search.h"
+#include "wg_pinyin.h"
 #include "stringw.h"
 
 /* Private macro ------------------------------------------------------------*/
@@ -24,10 +36,375 @@
 #define A_UNFOCUS A_BOLD
 #define A_FOCUS A_REVERSE
 
+/* 过滤检索时每个线程最少处理的行数，行数较少时不开启多线程 */
+#define TABLE_SCAN_CHUNK 16384
+
+/* 后台加载时每批加入表格的行数 */
+#define TABLE_LOAD_BATCH 4096
+
+/* 从管道/fd 加载时的初始读缓冲大小，单条记录超过时扩容 */
+#define TABLE_LOAD_BUFFER (1024 * 1024)
+
+/* 第 i 个可视列在重绘位图中的位，第 31 列及之后的可视列共用最高位 @see table_draw_cells() */
+#define TABLE_CELL_BIT(i) (1u << ((i) < 31 ? (i) : 31))
+
+/* 条件过滤程序的求值栈深度，及每批求值的行数 @see table_where_eval() */
+#define TABLE_WHERE_STACK 16
+#define TABLE_WHERE_BATCH 256
+
+/* 模糊匹配每段的行数，各段分别保留前 K 个候选，段与段之间检查是否被取消 */
+#define TABLE_FUZZY_SLICE 4096
+
+/* 模糊匹配时一行文本的最大长度，各列以 '\t' 连接 */
+#define TABLE_FUZZY_TEXT 512
+
+/* 模糊匹配的计分，与 fzf 相近 @see table_fuzzy_score() */
+#define TABLE_FUZZY_MATCH 16
+#define TABLE_FUZZY_GAP_START 3
+#define TABLE_FUZZY_GAP_EXTENSION 1
+#define TABLE_FUZZY_BOUNDARY 8
+#define TABLE_FUZZY_CAMEL 7
+#define TABLE_FUZZY_CONSECUTIVE 4
+
+/* table_aggs_item() 所更新的聚合 */
+#define TABLE_AGGS_ALL 0x01
+#define TABLE_AGGS_VIEW 0x02
+
 /* Private types ------------------------------------------------------------*/
+
+/** 虚拟表格的一行缓存 */
+struct table_vrow {
+	int line;/**< 所缓存的行号，-1 为空 */
+	int pending;/**< 仍在等待数据源异步填充的单元格数 */
+	unsigned char *state;/**< 每个单元格是否在等待填充 */
+	char *values[1];
+};
+
+/** 虚拟表格的行缓存，按行号直接映射 */
+struct table_vcache {
+	int rows;/**< 缓存行数，不小于可视行数的 4 倍，保证可视页与预取页不冲突 */
+	int cols;
+	int size;/**< 每个单元格的缓冲大小 */
+	int last_start;/**< 上一次显示的起始行，用于判断滚动方向 */
+	struct table_vrow *slot[1];
+};
+
+/** 一行的显示缓存，各可视列截断后的内容依次存放于 text[] */
+struct table_rline {
+	const struct table_item *item;/**< 所缓存的行，NULL 为空 */
+	unsigned int seq;/**< 行的插入序号，防止行被释放后地址被复用 */
+	unsigned int layout;/**< 生成时的 table->layout */
+	short *len;/**< 各可视列的内容长度，存放于 text[] 之后 */
+	char text[1];
+};
+
+/** 行显示缓存，按插入序号直接映射 */
+struct table_rcache {
+	int rows;
+	int size;/**< 每行 text[] 的大小 */
+	int cols;/**< 每行 len[] 的大小，可视列数不超过控件宽度 */
+	struct table_rline *slot[1];
+};
+
+/** 多线程检索任务，每个线程检索 items[start,end) 并将结果写入 match[] */
+struct table_match_job {
+	struct table *table;
+	struct table_item **items;
+	unsigned char *match;
+	const char *keyword;
+	size_t len;
+};
+
+/** 排序键的快照值 */
+union table_sort_value {
+	long long i;
+	double f;
+	const char *s;
+};
+
+/** 后台排序任务，排序线程只访问快照，不访问表格行的内容 */
+struct table_sort_job {
+	struct table *table;
+	int generation;/**< 发起排序时的 table->sort_generation */
+	volatile int cancel;
+	unsigned int seq;/**< 快照时的 table->seq，此后新增的行在替换时有序插入 */
+	int nkeys;
+	struct table_sort_key keys[TABLE_SORT_KEYS];
+	int count;
+	struct table_item **items;/**< 快照时按插入顺序排列的行，仅作标识 */
+	union table_sort_value *values;/**< 每行 nkeys 个排序键 */
+	char *strings;/**< 字符串排序键的副本 */
+	int *order;/**< 排序结果，items[] 的下标 */
+};
+
+/** 后台归并排序的一趟，每个线程归并若干对相邻的有序段 */
+struct table_sort_pass {
+	struct table_sort_job *job;
+	int *src,*dst;
+	int width;
+};
+
+/** 后台加载任务，解析出的一批行先存放于 cells，再整批加入表格 */
+struct table_loader {
+	struct table *table;
+	void *thread;
+	volatile int cancel;
+	int running;/**< 加载中，页脚显示进度 */
+	int fd;
+	int close_fd;/**< fd 由加载任务打开，结束时关闭 */
+	const char *map;/**< mmap 的文件内容，为 NULL 时从 fd 读取 */
+	size_t map_size;
+	int delim;/**< 字段分隔符 */
+	int flags;/**< @see enum table_load_flags */
+	int first;/**< 尚未处理首行 */
+	int rows;/**< 已加入表格的行数 */
+	long long done;/**< 已解析的字节数 */
+	long long total;/**< 总字节数，未知时为 0 */
+
+	char *cells;/**< 当前批次的字段内容，以 '\0' 分隔 */
+	size_t cells_used,cells_size;
+	int *fields;/**< 各字段在 cells 中的偏移 */
+	int nfields,fields_size;
+	int *records;/**< 各行第一个字段在 fields 中的序号，records[nrecords] 为 nfields */
+	int nrecords,records_size;
+};
+
+/** 一层过滤结果缓存 */
+struct table_filter_level {
+	char keyword[128];
+	int lines;/**< 生成结果时表格的总行数，此后追加的行需另行检索 */
+	int count;/**< 检出行数 */
+	int size;/**< items[] 容量 */
+	struct table_item *items[1];/**< 按显示顺序排列的检出行 */
+};
+
+/** 字典列的字典，各行只存放字符串的编码 */
+struct table_dict {
+	char **words;/**< 以编码为下标的各个不同字符串 */
+	int count;
+	int size;/**< words[] 的容量 */
+	int *hash;/**< 开放寻址的哈希表，存放编码 + 1，0 为空位 */
+	int hash_size;/**< 为 2 的幂，不小于 count 的 2 倍 */
+	unsigned char *match;/**< 各字符串是否包含 keyword @see table_dict_match() */
+	int matched;/**< match[] 已计算的字符串数 */
+	char keyword[128];
+	unsigned int resets;/**< 被清空的次数，清空后原有的编码失效 */
+};
+
+/** 字典列排序时的一个字符串 */
+struct table_dict_word {
+	const char *word;
+	int code;
+};
+
+/** 一个类型列 */
+struct table_type {
+	int type;/**< @see enum table_column_type，TABLE_COL_STRING 为普通列 */
+	table_format_t format;
+	void *arg;
+	struct table_dict *dict;/**< TABLE_COL_DICT 的字典 */
+	union table_value *data;/**< 各行的值，以 table_item->slot 为下标 */
+};
+
+/** 表格的类型列，值按列存放，各行以 table_item->slot 为下标 */
+struct table_types {
+	int slots;/**< 已使用的下标数 */
+	int size;/**< 各列 data[] 的容量 */
+	int *free_slots;/**< 已释放待复用的下标 */
+	int free_count;
+	char buf[64];/**< wg_table_value() 格式化类型列的缓冲 */
+	int cols;/**< col[] 的列数，之后的列均为普通列 */
+	struct table_type col[1];
+};
+
+/** 最小/最大值聚合中的一个不同数值及其单元格数 */
+struct table_agg_node {
+	struct wg_rank_node rank;/**< 按数值排序 */
+	double value;
+	long long n;
+};
+
+/** 一列聚合的一组状态，增删改行时增量更新 */
+struct table_agg_state {
+	long long count;/**< 非空单元格数 */
+	long long n;/**< 数值单元格数 */
+	double sum;
+	struct wg_rank_tree values;/**< 最小/最大值聚合时各个不同数值，按值排序 @see struct table_agg_node */
+};
+
+/** 一列的页脚聚合 */
+struct table_agg {
+	int agg;/**< @see enum table_aggregate */
+	struct table_agg_state all;/**< 全部行 */
+	struct table_agg_state view;/**< 过滤视图中的行 */
+};
+
+/** 表格的页脚聚合 @see wg_table_aggregate() */
+struct table_aggs {
+	int count;/**< 设置了聚合的列数 */
+	int cols;
+	struct table_agg col[1];
+};
+
+/** 一个分面列的各个不同值及其行数 @see wg_table_facet() */
+struct table_facet {
+	struct table_dict dict;/**< 各个不同的值，行数降为 0 的值留待压缩时移出 */
+	long long *counts;/**< 以编码为下标的行数 */
+	int size;/**< counts[] 的容量 */
+	int dead;/**< 行数为 0 的值的个数 */
+};
+
+/** 分面弹框中的一个值 */
+struct table_facet_entry {
+	const char *word;
+	long long count;
+};
+
+/** 表格的分面列 @see wg_table_facet() */
+struct table_facets {
+	int count;/**< 设置了分面的列数 */
+	int cols;
+	int popup;/**< 弹框中列出的列 @see table_facet_popup() */
+	struct table_facet *col[1];/**< 未设置分面的列为 NULL */
+};
+
+/** 检索索引列 @see wg_table_column_search() */
+struct table_search {
+	int count;/**< 建立了索引的列数 */
+	int cols;
+	int fold;/**< 关键词含大写字母，keyword[] 与原关键词不同 */
+	char keyword[128];/**< 小写的关键词 @see table_search_prepare() */
+	unsigned char col[1];/**< 各列是否建立索引 */
+};
+
+/** 条件过滤程序的指令，叶子按一列的值求值并压栈 */
+enum table_pred_op {
+	TABLE_PRED_EQ = 1,
+	TABLE_PRED_NE,
+	TABLE_PRED_LT,
+	TABLE_PRED_LE,
+	TABLE_PRED_GT,
+	TABLE_PRED_GE,
+	TABLE_PRED_IN,/**< 等于若干值之一，以上为叶子 */
+	TABLE_PRED_AND,
+	TABLE_PRED_OR,
+	TABLE_PRED_NOT,
+};
+
+/** 条件过滤的比较值 */
+struct table_pred_value {
+	const char *str;/**< 位于 table_where->text */
+	double num;
+};
+
+/** 条件过滤程序的一条指令 */
+struct table_pred {
+	int op;/**< @see enum table_pred_op */
+	int col;/**< 叶子所比较的列 */
+	int numeric;/**< 各比较值均为数值，按数值比较 */
+	int count;/**< 比较值的个数 */
+	struct table_pred_value *values;
+	unsigned char *codes;/**< 字典列各编码的比较结果 @see table_where_prepare() */
+	int known;/**< codes[] 已计算的编码数 */
+	unsigned int resets;/**< 计算 codes[] 时字典的 table_dict->resets */
+};
+
+/** 编译后的条件过滤程序，后缀形式 @see wg_table_where() */
+struct table_where {
+	char *text;/**< 表达式中各单词和字符串的副本 */
+	int count;
+	int size;
+	struct table_pred *code;
+};
+
+/** 条件表达式的编译状态 */
+struct table_where_parser {
+	struct table *table;
+	struct table_where *where;
+	const char *pos;/**< 下一个记号的位置 */
+	char *pool;/**< 下一个单词的存放位置，位于 where->text */
+	int token;/**< 当前记号 @see table_where_next() */
+	char *word;/**< 当前单词或字符串 */
+	int depth;/**< 求值栈深度 */
+	int nest;/**< 括号层数 */
+};
+
+/** 模糊匹配时的字符类别 */
+enum table_fuzzy_class {
+	TABLE_FUZZY_NONWORD = 0,
+	TABLE_FUZZY_LOWER,
+	TABLE_FUZZY_UPPER,
+	TABLE_FUZZY_DIGIT,
+};
+
+/** 模糊匹配的一个候选，得分相同时 index 小者优先 */
+struct table_fuzzy_hit {
+	int score;
+	int index;/**< 在 table_fuzzy_snap->items 中的下标 */
+};
+
+/** 模糊匹配的候选行快照，过滤条件和显示顺序不变时各次匹配共用，随表格内容增量维护 */
+struct table_fuzzy_snap {
+	int refs;/**< 引用数，表格加锁时修改 */
+	unsigned int seq;/**< 已收入快照的行均早于此 table->seq，此后新增的行在替换结果时计分 */
+	int count;
+	int size;/**< items[] 和 offset[] 的容量 */
+	int dead;/**< 快照中被修改或删除的行数，计分时多保留同样多的候选 */
+	struct table_item **items;/**< 按显示顺序排列的候选行，新增的行追加在末尾，仅作标识 */
+	int *offset;/**< 各行文本在 text 中的位置，共 count + 1 个 */
+	char *text;/**< 各行文本的副本 @see table_fuzzy_text() */
+	size_t text_size;/**< text 的容量 */
+};
+
+/** 后台模糊匹配任务，计分线程只访问快照，不访问表格行的内容 */
+struct table_fuzzy_job {
+	struct table *table;
+	int generation;/**< 发起检索时的 table_fuzzy->generation */
+	volatile int cancel;
+	char pattern[128];
+	int plen;
+	int exact;/**< 区分大小写 */
+	int top_k;
+	struct table_fuzzy_snap *snap;
+	int slice_k;/**< 每段保留的候选数 */
+	int *found;/**< 各段的候选数 */
+	struct table_fuzzy_hit *hits;/**< 各段的候选堆，每段 slice_k 个 */
+	int results;
+	struct table_fuzzy_hit *result;/**< 合并后的前 K 个候选，按得分从高到低排列 */
+};
+
+/** 模糊匹配状态，过滤视图即按得分从高到低排列的 items[] @see wg_table_fuzzy() */
+struct table_fuzzy {
+	char pattern[128];/**< 匹配串 */
+	int plen;
+	int exact;/**< 匹配串含大写字母时区分大小写 */
+	int top_k;
+	int generation;/**< 每次发起检索时递增，用于丢弃过期的结果 */
+	int busy;/**< 后台检索进行中，快照仍引用表格行 */
+	struct table_fuzzy_snap *snap;/**< 候选行快照，过滤条件或显示顺序改变、过半的行失效时丢弃 */
+	struct table_item **changed;/**< 快照生成后被修改的行 @see TABLE_ITEM_CHANGED */
+	int changed_count;
+	int changed_size;
+	struct table_fuzzy_job *job;/**< 进行中的后台检索 */
+	void *thread;
+	int count;
+	struct table_item **items;/**< 过滤视图中的行，共 top_k 个空间 */
+	int *scores;/**< items[] 各行的得分 */
+};
+
+/** 键列的哈希索引，同一桶的行以 table_item->key_next 链接 */
+struct table_keys {
+	int col;/**< 键列 */
+	int count;/**< 索引中的行数 */
+	int size;/**< 桶数，为 2 的幂 */
+	struct table_item *bucket[1];
+};
+
 /* Private variables --------------------------------------------------------*/
 /* Global  variables --------------------------------------------------------*/
 /* Private function prototypes ----------------------------------------------*/
+static int table_load_finish(struct table *table,int cancel);
+static int table_tick(struct nwidget *wg);
 /* Gorgeous Split-line ------------------------------------------------------*/
 
 #ifdef VISIBLE_PANEL
@@ -121,960 +498,5079 @@ static void table_scrollbar_update(struct table *table)
 
 
 /**
-  * @brief    获取表格行数据
-  * @param    table : 目标表格
-  * @param    line : 指定行
-  * @return   行数据，如 values[0] 为指定行第一列数据
+  * @brief    是否处于过滤视图，关键词过滤、条件过滤和模糊匹配任一生效时为过滤视图
 */
-char **wg_table_values(struct table *table,int line)
+static inline int table_filtering(struct table *table)
 {
-	int lines;
-	struct table_item *item = NULL;
-	struct wg_list *node;
-	assert(table);
-	NWIDGET_MUTEX_LOCK(table->mutex);
-	lines = table->keyword[0] ? table->filter : table->lines;
-	if (line < 0 || line >= lines) {
-		goto unlock;
-	}
-
-	if (table->keyword[0]) {
-		node = table->filter_items.next;
-		for (int i = 0; i < line; i++) {
-			node = node->next;
-		}
-		item = container_of(node,struct table_item,filter);
-	} else {
-		node = table->items.next;
-		for (int i = 0; i < line; i++) {
-			node = node->next;
-		}
-		item = container_of(node,struct table_item,node);
-	}
-unlock:
-	NWIDGET_MUTEX_UNLOCK(table->mutex);
-	return item ? item->values : NULL;
+	return table->keyword[0] || table->where || table->fuzzy;
 }
 
 
 /**
-  * @brief    获取表格指定单元格数据
-  * @param    table   : 目标表格
-  * @param    line    : 指定行
-  * @param    column  : 指定列
-  * @return   单元数据
+  * @brief    模糊匹配的快照或后台检索是否仍引用表格行，此时删除的行需待快照丢弃后释放
 */
-char *wg_table_value(struct table *table,int line,int column)
+static inline int table_fuzzy_busy(struct table *table)
 {
-	char **row;
-	assert(table);
-	if (column < 0 || column >= table->cols) {
-		return NULL;
-	}
-
-	row = wg_table_values(table,line);
-	return row ? row[column] : NULL;
+	return table->fuzzy && (table->fuzzy->busy || table->fuzzy->snap);
 }
 
 
 /**
-  * @brief    删除表格的子面板和子窗口
+  * @brief    获取当前视图(过滤/未过滤)下指定行的数据，O(log n)
   * @param    table : 目标表格
   * @param    line : 指定行
-  * @param    column : 指定列
-  * @return   0
+  * @return   行数据，越界返回 NULL
 */
-static int visible_column_cleanup(struct table *table)
+static struct table_item *table_item_at(struct table *table,int line)
 {
-	struct table_column **column = table->visible;
-	for (int i = 0; i < table->visible_cols ; i++) {
-		column[i]->display_width = 0;
-		column[i] = NULL;
+	struct wg_rank_node *node;
+	if (table_filtering(table)) {
+		node = wg_rank_at(&table->filter_index,line);
+		return node ? container_of(node,struct table_item,filter_rank) : NULL;
 	}
-	table->visible_cols = 0;
-	return 0;
+	node = wg_rank_at(&table->index,line);
+	return node ? container_of(node,struct table_item,rank) : NULL;
 }
 
 
 /**
-  * @brief    检出可显示的列至 table->visible
+  * @brief    获取当前视图下指定行的下一行
   * @param    table : 目标表格
-  * @param    start_col : 从第几列开始展示
-  * @note     即 start_col 以下的列将折叠到左侧不被展示
-  * @return   0
+  * @param    item : 指定行
+  * @return   下一行数据，已是最后一行返回 NULL
 */
-static int visible_column_checkout(struct table *table,int start_col)
+static struct table_item *table_item_next(struct table *table,struct table_item *item)
 {
-	int has_next_column = 0;
-	int width,x,visible_cols = 0;
-	struct table_column *column;
-	struct wg_list *node = table->column.next;
-
-	/* 查找第 start_col 列可显示的列 */
-	for (x = 0; node != &table->column; node = node->next) {
-		column = container_of(node,struct table_column,node);
-		if (!column->hide && ++x > start_col)
-			break;
+	struct wg_rank_node *node;
+	if (table_filtering(table)) {
+		node = wg_rank_next(&item->filter_rank);
+		return node ? container_of(node,struct table_item,filter_rank) : NULL;
 	}
+	node = wg_rank_next(&item->rank);
+	return node ? container_of(node,struct table_item,rank) : NULL;
+}
 
-	if (node == &table->column) {
-		goto cleanup;
+
+/**
+  * @brief    获取行在当前视图下的行号
+  * @param    table : 目标表格
+  * @param    item : 指定行
+  * @return   行号，不在当前视图中返回 -1
+*/
+static int table_item_line(struct table *table,struct table_item *item)
+{
+	if (table_filtering(table)) {
+		if (!wg_rank_linked(&item->filter_rank))
+			return -1;
+		return wg_rank_of(&item->filter_rank);
 	}
+	return wg_rank_of(&item->rank);
+}
 
-	/* 除去边框为表格的有效显示宽度 */
-	width = table->wg.width - table->show_border;
 
-	/* 将当前窗口可显示的列计入 visible[] 中 */
-	visible_cols = 0;
-	while (visible_cols < TAB_MAX_COL && node != &table->column) {
-		column = container_of(node,struct table_column,node);
-		node = node->next;
-		if (!column->hide) {
-			if (width > column->width){
-				column->display_width = column->width;
-			} else {
-				column->display_width = width;
-			}
-			table->visible[visible_cols++] = column;
+/**
+  * @brief    类型列的默认格式
+*/
+static int table_format_int(char *buf,int size,union table_value value,void *arg)
+{
+	return snprintf(buf,size,"%lld",value.i);
+}
 
-			/* 剩余空间不足 3 列或已遍历完所有节点，跳出 */
-			width -= column->display_width;
-			if (width < 3) {
-				break;
-			}
-		}
-	}
 
-	if (!visible_cols) {
-		goto cleanup;
-	}
+static int table_format_double(char *buf,int size,union table_value value,void *arg)
+{
+	return snprintf(buf,size,"%g",value.f);
+}
 
-	/* 判断当前表格窗口右侧是否仍有未显示完全的内容 */
-	column = table->visible[visible_cols - 1];
-	has_next_column = (column->display_width < column->width - 1);
-	while (!has_next_column && node != &table->column) {
-		column = container_of(node,struct table_column,node);
-		node = node->next;
-		has_next_column = !column->hide;
-	}
 
-	/* 如果显示完所有列后仍有剩余空间，均匀分配至各列 */
-	for (int i = 0 ; i < width ; i++) {
-		table->visible[i%visible_cols]->display_width++;
+static int table_format_time(char *buf,int size,union table_value value,void *arg)
+{
+	struct tm tm;
+	time_t t = (time_t)value.i;
+	#ifdef _WIN32
+		localtime_s(&tm,&t);
+	#else
+		localtime_r(&t,&tm);
+	#endif
+	return (int)strftime(buf,size,"%Y-%m-%d %H:%M:%S",&tm);
+}
+
+
+static int table_format_enum(char *buf,int size,union table_value value,void *arg)
+{
+	const char *const *names = arg;
+	for (long long i = 0; names && names[i]; i++) {
+		if (i == value.i)
+			return snprintf(buf,size,"%s",names[i]);
 	}
+	return snprintf(buf,size,"%lld",value.i);
+}
 
-cleanup:
-	table->visible_cols = visible_cols;
-	table->has_prev_column = table->start_col = start_col;
-	table->has_next_column = has_next_column;
-	return 0;
+
+/**
+  * @brief    获取第 col 列的类型，普通列返回 NULL
+*/
+static inline struct table_type *table_col_type(struct table *table,int col)
+{
+	struct table_types *types = table->types;
+	if (!types || col >= types->cols || types->col[col].type == TABLE_COL_STRING)
+		return NULL;
+	return &types->col[col];
 }
 
 
 /**
-  * @brief    表格重新绘制列标题
-  * @param    table : 目标表格
-  * @param    draw_hline : 是否绘制水平分割线
-  * @return   0
+  * @brief    一列是否建立了检索索引
 */
-static void table_column_title(struct table *table,int draw_hline)
+static inline int table_col_search(struct table *table,int col)
 {
-	char value[256];
-	int col,y,x,width;
-	struct table_column **column = table->visible;
+	return table->search && col < table->search->cols && table->search->col[col];
+}
 
-	y = x = table->show_border ? 1 : 0;
-	width = table->wg.width - x * 2;
 
-	mvwhline(table->wg.win,y,x,' ',width);
-	if (draw_hline){
-		chtype hline = table->ts ? table->ts : ACS_HLINE;
-		mvwhline(table->wg.win,y+1,x,hline,width);
-	}
+/**
+  * @brief    检索索引列的单元格的检索键，紧随单元格内容存放 @see wg_pinyin_key()
+*/
+static inline const char *table_cell_key(struct table_item *item,int col)
+{
+	return item->values[col] + strlen(item->values[col]) + 1;
+}
 
-	for (col = 0; col < table->visible_cols; col++) {
-		width = column[col]->display_width;
-		wstrncpy(value,column[col]->title,width);
-		mvwaddstr(table->wg.win,y,x,value);
-		x += width;
-	}
-	desktop_refresh();
+
+/**
+  * @brief    单元格内容在行中占用的存储，检索索引列包括其后的检索键
+*/
+static size_t table_cell_space(struct table *table,int col,const char *value)
+{
+	size_t size = strlen(value) + 1;
+	if (table_col_search(table,col))
+		size += wg_pinyin_key(value,NULL,0) + 1;
+	return size;
 }
 
+
 /**
-  * @brief    表格页脚刷新
-  * @param    table : 目标表格
+  * @brief    键的哈希值，FNV-1a
 */
-static void table_footer(struct table *table)
+static unsigned int table_key_hash(const char *key)
 {
-	char value[13];
-	int x,y,lines;
+	unsigned int hash = 2166136261u;
+	while (*key)
+		hash = (hash ^ (unsigned char)*key++) * 16777619u;
+	return hash;
+}
 
-	y = table->wg.height - 1;
-	x = table->wg.width - 2;
-	lines = table->keyword[0] ? table->filter : table->lines;
 
-	mvwhline(table->wg.win,y,1,table->bs,x);
-	if (table->current_line > -1) {
-		value[12] = '\0';
-		snprintf(value,12,"%d/%d",table->current_line,lines);
-		mvwaddstr(table->wg.win,y,1,value);
+/**
+  * @brief    在字典中查找字符串的编码
+  * @param    dict   : 字典
+  * @param    str    : 字符串
+  * @param    insert : 不存在时是否加入字典
+  * @return   编码，不存在或内存不足返回 -1
+*/
+static int table_dict_code(struct table_dict *dict,const char *str,int insert)
+{
+	unsigned int mask,h;
+	char **words,*word;
+	int *hash,size,code;
+	size_t len;
+
+	if (dict->hash_size) {
+		mask = dict->hash_size - 1;
+		for (h = table_key_hash(str) & mask; dict->hash[h]; h = (h + 1) & mask) {
+			if (!strcmp(dict->words[dict->hash[h] - 1],str))
+				return dict->hash[h] - 1;
+		}
+	}
+	if (!insert) {
+		return -1;
 	}
 
-	if (table->has_prev_column || table->has_next_column) {
-		char *stat = "";
-		x = table->wg.width-1-7;
-		mvwaddch(table->wg.win,y,x,ACS_RTEE);
-		mvwaddch(table->wg.win,y,x+6,ACS_LTEE);
-		if (!table->has_prev_column)
-			stat = "===  ";
-		else if (!table->has_next_column)
-			stat = "  ===";
-		else
-			stat = " === ";
-		mvwaddstr(table->wg.win,y,x+1,stat);
+	/* 哈希表的装载因子不超过 1/2 */
+	if ((dict->count + 1) * 2 > dict->hash_size) {
+		size = dict->hash_size ? dict->hash_size * 2 : 64;
+		if (NULL == (hash = calloc(size,sizeof(int)))) {
+			return -1;
+		}
+		for (int i = 0; i < dict->count; i++) {
+			for (h = table_key_hash(dict->words[i]) & (size - 1); hash[h]; h = (h + 1) & (size - 1));
+			hash[h] = i + 1;
+		}
+		free(dict->hash);
+		dict->hash = hash;
+		dict->hash_size = size;
+	}
+	if (dict->count == dict->size) {
+		size = dict->size * 2 + 16;
+		if (NULL == (words = realloc(dict->words,sizeof(char *) * size))) {
+			return -1;
+		}
+		dict->words = words;
+		dict->size = size;
+	}
+
+	len = strlen(str) + 1;
+	if (NULL == (word = malloc(len))) {
+		return -1;
 	}
+	memcpy(word,str,len);
+	code = dict->count++;
+	dict->words[code] = word;
+	mask = dict->hash_size - 1;
+	for (h = table_key_hash(str) & mask; dict->hash[h]; h = (h + 1) & mask);
+	dict->hash[h] = code + 1;
+	return code;
 }
 
+
 /**
-  * @brief    刷新显示一个表格
-  * @param    table : 目标表格
-  * @param    refresh_title : 是否刷新标题栏
-  * @param    refresh_each_row : 每行刷新强制输出
-  * @return   0
+  * @brief    获取字典列第 slot 行的字符串
 */
-static int table_refresh_raw(struct table *table,int refresh_title,int refresh_each_row)
+static inline const char *table_dict_word(struct table_type *type,int slot)
 {
-	char value[256];
-	int display,width,height,lines,cols,x,y,i;
-	long attr;
-	struct table_item *item ;
-	struct wg_list *node;
-	struct table_column **column = table->visible;
-	WINDOW *win = table->window;
+	long long code = type->data[slot].i;
+	return code < 0 ? "" : type->dict->words[code];
+}
 
-	if (!table->wg.win) { /* 未放置的控件 */
-		return -1;
-	}
 
-	if ( (cols = table->visible_cols) < 0) {
-		return 0;
+/**
+  * @brief    清空字典，表格被清空时调用
+*/
+static void table_dict_reset(struct table_dict *dict)
+{
+	if (!dict) {
+		return;
 	}
+	for (int i = 0; i < dict->count; i++)
+		free(dict->words[i]);
+	if (dict->hash)
+		memset(dict->hash,0,sizeof(int) * dict->hash_size);
+	dict->count = 0;
+	dict->matched = 0;
+	dict->resets++;
+}
 
-	if (refresh_title && table->show_title){
-		table_column_title(table,false);
-	}
 
-	lines = table->keyword[0] ? table->filter : table->lines;
-	if (lines < 1) {
-		return 0;
+static void table_dict_free(struct table_dict *dict)
+{
+	if (dict) {
+		table_dict_reset(dict);
+		free(dict->words);
+		free(dict->hash);
+		free(dict->match);
+		free(dict);
 	}
+}
 
-	/* 当前表格被聚焦时的显示状态 */
-	attr = &table->wg.editing ? A_FOCUS : A_UNFOCUS;
 
-	height = table->wg.height - table->show_border;
-	display = table->start_line;
+/**
+  * @brief    检索各字典列的字符串是否包含关键词，每个不同的字符串只检索一次
+  * @note     在 table_item_match() 之前调用，调用时表格已加锁；
+  *           内存不足时 matched 不增长，table_item_match() 逐行检索其余的行
+*/
+static void table_dict_match(struct table *table,const char *keyword,size_t len)
+{
+	struct table_dict *dict;
+	unsigned char *match;
 
-	if (table->keyword[0]) {
-		node = table->filter_items.next;
-		for (int i = 0; i < display; i++) {
-			node = node->next;
+	for (int i = 0; table->types && i < table->types->cols; i++) {
+		if (NULL == (dict = table->types->col[i].dict)) {
+			continue;
 		}
-		item = container_of(node,struct table_item,filter);
-	} else {
-		node = table->items.next;
-		for (int i = 0; i < display; i++) {
-			node = node->next;
+		if (strcmp(dict->keyword,keyword)) {
+			strncpy(dict->keyword,keyword,sizeof(dict->keyword)-1);
+			dict->keyword[sizeof(dict->keyword)-1] = '\0';
+			dict->matched = 0;
 		}
-		item = container_of(node,struct table_item,node);
-	}
-
-	desktop_lock();
-	werase(table->window);
-	for (y = 0; y < height; y++) {
-		if (display == table->current_line){
-			wattron(win,attr);
+		if (dict->matched == dict->count) {
+			continue;
 		}
-
-		mvwhline(table->window,y,0,' ',table->wg.width);
-		for (x = i = 0; i < cols; i++) {
-			int id = column[i]->index;
-			width = column[i]->display_width;
-			wstrncpy(value,item->values[id],width);
-			mvwaddstr(win,y,x,value);
-			x += width;
+		if (NULL == (match = realloc(dict->match,dict->size))) {
+			dict->matched = 0;
+			continue;
 		}
-
-		if (display == table->current_line){
-			wattroff(win,attr);
+		dict->match = match;
+		for ( ; dict->matched < dict->count; dict->matched++) {
+			const char *word = dict->words[dict->matched];
+			match[dict->matched] = NULL != wg_memmem(word,strlen(word),keyword,len);
 		}
+	}
+}
 
-		if (refresh_each_row) {
-			wnoutrefresh(win);
-			doupdate();
-		}
 
-		display++;
-		node = node->next;
-		if (table->keyword[0]) {
-			if (node == &table->filter_items) {
-				break;
-			} else {
-				item = container_of(node,struct table_item,filter);
-			}
-		} else {
-			if (node == &table->items) {
-				break;
-			} else {
-				item = container_of(node,struct table_item,node);
-			}
-		}
-	}
+static int table_dict_word_cmp(const void *a,const void *b)
+{
+	return strcmp(((const struct table_dict_word *)a)->word,((const struct table_dict_word *)b)->word);
+}
 
-	/* 页脚显示行数信息 */
-	if (table->show_footer && table->wg.width > 24) {
-		table_footer(table);
-	}
- 
-	if (!refresh_each_row){
-		desktop_refresh();
-	}
-	desktop_unlock();
 
-	table_scrollbar_update(table);
-	return 0;
+static int table_dict_word_coll(const void *a,const void *b)
+{
+	return strcoll(((const struct table_dict_word *)a)->word,((const struct table_dict_word *)b)->word);
 }
 
 
 /**
-  * @brief    表格上箭头按键的默认响应函数
-  * @param    self     : 目标表格所在的 wg 控件句柄
-  * @param    shortcut : 键盘键值
+  * @brief    为排序快照预先算出字典中各字符串的排序值
+  * @param    type : 比较方式 @see enum table_sort_type
+  * @note     字符串比较时为各字符串排序后的序号，以整数比较代替逐行比较字符串
+  * @return   以编码 + 1 为下标的排序值，下标 0 为空字符串，内存不足返回 NULL
 */
-static wg_state_t table_line_up(struct nwidget *self,long shortcut)
+static union table_sort_value *table_dict_sort_values(struct table_dict *dict,int type)
 {
-	int refresh_each_row = false;
-	struct table *table = container_of(self, struct table,wg);
-	if (table->current_line < 1)
-		return WG_OK;
-	NWIDGET_MUTEX_LOCK(table->mutex);
-	table->current_line--;
-	if (table->start_line > table->current_line){
-		/* 如果当前行是窗口的第一行，需要整页下移，并强制每行刷新.
-		   note:如果此处不强制刷新会导致闪屏，原因未明 */
-		refresh_each_row = true;
-		table->start_line = table->current_line;
+	int (*cmp)(const void *,const void *) = type == TABLE_SORT_COLLATE ? table_dict_word_coll : table_dict_word_cmp;
+	struct table_dict_word *words;
+	union table_sort_value *values;
+	int count = dict->count + 1;
+
+	if (NULL == (values = malloc(sizeof(union table_sort_value) * count))) {
+		return NULL;
+	}
+	if (type == TABLE_SORT_INT || type == TABLE_SORT_FLOAT) {
+		for (int i = 0; i < count; i++) {
+			const char *word = i ? dict->words[i-1] : "";
+			if (type == TABLE_SORT_INT)
+				values[i].i = strtoll(word,NULL,10);
+			else
+				values[i].f = strtod(word,NULL);
+		}
+		return values;
 	}
 
-	table_refresh_raw(table,false,refresh_each_row);
-	NWIDGET_MUTEX_UNLOCK(table->mutex);
-	if (table->sig.changed)
-		table->sig.changed(table,table->sig.changed_arg);
-	return WG_OK;
+	if (NULL == (words = malloc(sizeof(struct table_dict_word) * count))) {
+		free(values);
+		return NULL;
+	}
+	for (int i = 0; i < count; i++) {
+		words[i].word = i ? dict->words[i-1] : "";
+		words[i].code = i;
+	}
+	qsort(words,count,sizeof(struct table_dict_word),cmp);
+	for (int i = 0,rank = 0; i < count; i++) {
+		/* 比较结果相同的字符串序号相同，由插入顺序决定先后 */
+		if (i && cmp(&words[i-1],&words[i]))
+			rank = i;
+		values[words[i].code].i = rank;
+	}
+	free(words);
+	return values;
 }
 
+
 /**
-  * @brief    表格下箭头按键的默认响应函数
-  * @param    self     : 目标表格所在的 wg 控件句柄
-  * @param    shortcut : 键盘键值
+  * @brief    按列类型将字符串解析为值，字典列的新字符串加入字典
 */
-static wg_state_t table_line_down(struct nwidget *self,long shortcut)
+static union table_value table_value_parse(struct table_type *type,const char *str)
 {
-	int refresh_each_row = false;
-	int start_display_at,height,selected,lines;
-	struct table *table = container_of(self, struct table,wg);
+	const char *const *names = type->arg;
+	union table_value value;
 
-	lines = table->keyword[0] ? table->filter : table->lines;
-	selected = table->current_line;
-	start_display_at = table->start_line;
-	if (selected >= lines-1){
-		return WG_OK;
+	str = str ? str : "";
+	if (type->dict) {
+		value.i = table_dict_code(type->dict,str,1);
+		return value;
 	}
-	NWIDGET_MUTEX_LOCK(table->mutex);
-	selected++;
-	height = table->wg.height - table->show_border - table->show_title;
-	if (selected >= start_display_at + height) {
-		/* 如果当前行是窗口的最后一行，需要整页上移，并强制每行刷新.
-		   note:如果此处不强制刷新会导致闪屏，原因未明 */
-		refresh_each_row = true;
-		start_display_at++;
+	if (type->type == TABLE_COL_DOUBLE) {
+		value.f = strtod(str,NULL);
+		return value;
 	}
-
-	table->current_line = selected;
-	table->start_line = start_display_at;
-
-	table_refresh_raw(table,false,refresh_each_row);
-	NWIDGET_MUTEX_UNLOCK(table->mutex);
-	if (table->sig.changed)
-		table->sig.changed(table,table->sig.changed_arg);
-	return WG_OK;
+	if (type->type == TABLE_COL_ENUM && type->format == table_format_enum) {
+		for (long long i = 0; names && names[i]; i++) {
+			if (!strcmp(names[i],str)) {
+				value.i = i;
+				return value;
+			}
+		}
+	}
+	value.i = strtoll(str,NULL,10);
+	return value;
 }
 
 
 /**
-  * @brief    表格 page up ，左箭头的默认响应函数
-  * @param    self : 目标表格所在的 wg 控件句柄
-  * @param    shortcut : 键盘键值
+  * @brief    获取单元格的显示内容，类型列格式化至 buf
+  * @return   普通列返回 item->values[col]，类型列返回 buf
 */
-static wg_state_t table_page_up(struct nwidget *self,long shortcut)
+static const char *table_cell_text(struct table *table,struct table_item *item,int col,char *buf,int size)
 {
-	int start_display_at,height;
-	struct table *table = container_of(self, struct table,wg);
-	start_display_at = table->start_line;
-	if (start_display_at < 1){
-		return WG_OK;
+	struct table_type *type = table_col_type(table,col);
+	if (!type) {
+		return item->values[col];
 	}
-	
-	NWIDGET_MUTEX_LOCK(table->mutex);
-	height = table->wg.height - table->show_border - table->show_title ;
-	start_display_at -= (height - 1);
-	if (start_display_at < 0)
-		start_display_at = 0;
-	table->current_line = start_display_at;
-	table->start_line = start_display_at;
-	table_refresh_raw(table,false,false);
-	NWIDGET_MUTEX_UNLOCK(table->mutex);
-	if (table->sig.changed)
-		table->sig.changed(table,table->sig.changed_arg);
-	return WG_OK;
+	if (type->dict) {
+		return table_dict_word(type,item->slot);
+	}
+	buf[0] = '\0';
+	type->format(buf,size,type->data[item->slot],type->arg);
+	return buf;
 }
 
+
 /**
-  * @brief    表格 page down 、右箭头的默认响应函数
-  * @param    self     : 目标表格所在的 wg 控件句柄
-  * @param    shortcut : 键盘键值
+  * @brief    单元格的值是否与字符串 value 相同，类型列按解析后的值比较
 */
-static wg_state_t table_page_down(struct nwidget *self,long shortcut)
+static int table_cell_equal(struct table *table,struct table_item *item,int col,const char *value)
 {
-	int start_display_at,height,lines;
-	struct table *table = container_of(self, struct table,wg);
-	lines = table->keyword[0] ? table->filter : table->lines;
-	start_display_at = table->start_line;
-	height = table->wg.height - table->show_border - table->show_title ;
-	if (start_display_at >= lines - height) {
-		return WG_OK;
-	}
+	struct table_type *type = table_col_type(table,col);
+	union table_value x;
 
-	NWIDGET_MUTEX_LOCK(table->mutex);
-	start_display_at += (height-1);
-	if (start_display_at + height > lines)
-		start_display_at = lines - height;
-	table->current_line = start_display_at;
-	table->start_line = start_display_at;
-	table_refresh_raw(table,false,false);
-	NWIDGET_MUTEX_UNLOCK(table->mutex);
-	if (table->sig.changed)
-		table->sig.changed(table,table->sig.changed_arg);
-	return WG_OK;
+	if (!type) {
+		return !strcmp(item->values[col],value);
+	}
+	if (type->dict) {
+		return !strcmp(table_dict_word(type,item->slot),value);
+	}
+	x = table_value_parse(type,value);
+	if (type->type == TABLE_COL_DOUBLE)
+		return x.f == type->data[item->slot].f;
+	return x.i == type->data[item->slot].i;
 }
 
 
 /**
-  * @brief    表格 end 键的默认响应函数
-  * @param    self     : 目标表格所在的 wg 控件句柄
-  * @param    shortcut : 键盘键值
+  * @brief    为新行分配类型列下标，调用时表格已加锁
+  * @return   成功返回下标，表格没有类型列返回 -1，内存不足返回 -2
 */
-static wg_state_t table_line_end(struct nwidget *self,long shortcut)
+static int table_slot_alloc(struct table *table)
 {
-	int start_display_at,height,lines;
-	struct table *table = container_of(self, struct table,wg);
-	lines = table->keyword[0] ? table->filter : table->lines;
-	height = table->wg.height - table->show_border - table->show_title ;
-	start_display_at = lines - height;
-	if (start_display_at < 0 || start_display_at == table->start_line) {
-		return WG_OK;
+	struct table_types *types = table->types;
+	union table_value *data;
+	int *slots,size;
+
+	if (!types) {
+		return -1;
 	}
-	NWIDGET_MUTEX_LOCK(table->mutex);
-	table->current_line = start_display_at;
-	table->start_line = start_display_at;
-	table_refresh_raw(table,false,false);
-	NWIDGET_MUTEX_UNLOCK(table->mutex);
-	if (table->sig.changed)
-		table->sig.changed(table,table->sig.changed_arg);
-	return WG_OK;
+	if (types->free_count) {
+		return types->free_slots[--types->free_count];
+	}
+
+	if (types->slots == types->size) {
+		size = types->size * 2 + 256;
+		if (NULL == (slots = realloc(types->free_slots,sizeof(int) * size))) {
+			return -2;
+		}
+		types->free_slots = slots;
+		for (int i = 0; i < types->cols; i++) {
+			if (types->col[i].type == TABLE_COL_STRING)
+				continue;
+			if (NULL == (data = realloc(types->col[i].data,sizeof(union table_value) * size)))
+				return -2;
+			types->col[i].data = data;
+		}
+		types->size = size;
+	}
+	return types->slots++;
 }
 
 
 /**
-  * @brief    表格 home 键的默认响应函数
-  * @param    self     : 目标表格所在的 wg 控件句柄
-  * @param    shortcut : 键盘键值
+  * @brief    释放行的类型列下标，调用时表格已加锁
 */
-static wg_state_t table_line_home(struct nwidget *self,long shortcut)
+static void table_slot_free(struct table *table,int slot)
 {
-	struct table *table = container_of(self, struct table,wg);
-	if (!table->current_line && !table->start_line) {
-		return WG_OK;
+	if (slot >= 0 && table->types) {
+		table->types->free_slots[table->types->free_count++] = slot;
 	}
-	NWIDGET_MUTEX_LOCK(table->mutex);
-	table->current_line = 0;
-	table->start_line = 0;
-	table_refresh_raw(table,false,false);
-	NWIDGET_MUTEX_UNLOCK(table->mutex);
-	if (table->sig.changed)
-		table->sig.changed(table,table->sig.changed_arg);
-	return WG_OK;
 }
 
 
 /**
-  * @brief    表格向右滑动展示右边未完全展示的列
-  * @param    table
+  * @brief    按行内容计算一行所需的存储大小
 */
-static wg_state_t table_column_move_right(struct table *table)
+static size_t table_item_size(struct table *table,char *values[])
 {
-	if (table->has_next_column) {
-		NWIDGET_MUTEX_LOCK(table->mutex);
-		visible_column_cleanup(table);
-		visible_column_checkout(table,table->start_col+1);
-		table_refresh_raw(table,true,false);
-		NWIDGET_MUTEX_UNLOCK(table->mutex);
+	size_t size;
+
+	size = sizeof(struct table_item) ;
+	size += sizeof(char *) * table->cols; /* for table_item->values[] */
+	for (int i = 0 ; i < table->cols ; i++) {
+		/* 类型列的值按列存放，只占一个空字符串 */
+		if (table_col_type(table,i))
+			size += 1;
+		else
+			size += table_cell_space(table,i,values[i] ? values[i] : "");
 	}
-	return WG_OK;
+	return size;
 }
 
 
 /**
-  * @brief    表格向左滑动展示左边未展示的列
-  * @param    table
+  * @brief    将行内容打包至 newitem，其存储不小于 table_item_size()
+  * @param    slot : 类型列下标 @see table_slot_alloc()
+  * @note     单元格内容紧凑存放于 values[] 之后，每个单元格只占用实际长度；
+  *           类型列的内容解析后存放于类型列数组，检索索引列的检索键紧随其内容
+  * @return   newitem
 */
-static wg_state_t table_column_move_left(struct table *table)
+static struct table_item *table_item_pack(struct table *table,struct table_item *newitem,char *values[],int slot)
 {
-	NWIDGET_MUTEX_LOCK(table->mutex);
-	if (table->has_prev_column) {
-		visible_column_cleanup(table);
-		visible_column_checkout(table,table->start_col-1);
-		table_refresh_raw(table,true,false);
+	struct table_type *type;
+	char *value ;
+	size_t len;
+
+	memset(newitem,0,sizeof(struct table_item));
+	newitem->slot = slot;
+
+	value = (char *)&newitem->values[table->cols] ;
+	for (int i = 0 ; i < table->cols ; i++) {
+		if (NULL != (type = table_col_type(table,i))) {
+			type->data[slot] = table_value_parse(type,values[i]);
+			*value = '\0';
+			newitem->values[i] = value++;
+			continue;
+		}
+		len = values[i] ? strlen(values[i]) : 0;
+		memcpy(value,values[i] ? values[i] : "",len);
+		value[len] = '\0';
+		newitem->values[i] = value;
+		value += len + 1;
+		if (table_col_search(table,i))
+			value += wg_pinyin_key(newitem->values[i],value,(size_t)-1) + 1;
 	}
-	NWIDGET_MUTEX_UNLOCK(table->mutex);
-	return WG_OK;
+	return newitem;
 }
 
 
 /**
-  * @brief 表格滑动展示未展示的列
-  * @param self : 目标表格所在的 wg 控件句柄
-  * @param key : 键盘键值
+  * @brief    按行内容创建新行，尚未加入表格
+  * @note     行在 table->arena 中分配，调用时表格已加锁
+  * @return   成功返回新行，内存不足返回 NULL
 */
-static wg_state_t table_column_move(struct nwidget *self,long key)
+static struct table_item *table_item_new(struct table *table,char *values[])
 {
-	struct table *table = container_of(self,struct table,wg);
-	int move_right = (key == KEY_CTRL_RIGHT || key == '>');
+	struct table_item *newitem;
+	int slot = table_slot_alloc(table);
 
-	/* 如果是按住鼠标拖动窗体，则移动方向需要做反处理 */
-	if (mouse.bstate)
-		move_right ^= 1;
-	if (move_right) 
-		table_column_move_right(table);
-	else
-		table_column_move_left(table);
-	return WG_OK;
+	if (slot < -1) {
+		return NULL;
+	}
+	if (!(newitem = (struct table_item *)wg_arena_alloc(&table->arena,table_item_size(table,values)))) {
+		table_slot_free(table,slot);
+		return NULL;
+	}
+	return table_item_pack(table,newitem,values,slot);
 }
 
 
 /**
-  * @brief    表格被选中执行函数，' ','\n' 的执行函数
-  * @param    self   : 目标表格所在的 wg 控件句柄
+  * @brief    创建空的键索引
+  * @param    col : 键列
+  * @param    size : 桶数，须为 2 的幂
 */
-static wg_state_t table_selected(struct nwidget *self,long key)
+static struct table_keys *table_keys_new(int col,int size)
 {
-	struct table *table = container_of(self, struct table,wg);
-	if (table->current_line > -1 && table->sig.selected)
-		table->sig.selected(table,table->sig.selected_arg);
-	return WG_OK;
+	struct table_keys *keys;
+	keys = calloc(1,sizeof(struct table_keys) + sizeof(struct table_item *) * size);
+	if (keys) {
+		keys->col = col;
+		keys->size = size;
+	}
+	return keys;
 }
 
 
 /**
-  * @brief    对表格的当前选中行进行显示刷新
-  * @param    table : 目标表格
-  * @param    display_attr : 显示格式
-  * @return   0
+  * @brief    键索引的桶数加倍，调用时表格已加锁
+  * @note     内存不足时沿用原索引，只是各桶的链更长
 */
-static int table_refresh_current_line(struct table *table,int display_attr)
+static void table_keys_grow(struct table *table)
 {
-	struct wg_list *node;
-	struct table_item *item;
-	struct table_column **column;
-	int visible_cols,line;
-
-	NWIDGET_MUTEX_LOCK(table->mutex);
-	line = table->current_line;
-	column = table->visible;
-	visible_cols = table->visible_cols;
+	struct table_keys *old = table->keys,*keys;
+	struct table_item *item,*next,**bucket;
 
-	/* 如果无选中行或无显示列 */
-	if (line < 0 || visible_cols < 1){
-		goto cleanup;
+	if (NULL == (keys = table_keys_new(old->col,old->size * 2))) {
+		return;
 	}
-	
-	if (table->keyword[0]) {
-		/* 如果是过滤过的表格，则查找过滤链表 */
-		node = table->filter_items.next;
-		for (int i = 0; i < line; i++) {
-			node = node->next;
-		}
-		item = container_of(node,struct table_item,filter);
-	} else {
-		node = table->items.next;
-		for (int i = 0; i < line; i++) {
-			node = node->next;
+	keys->count = old->count;
+	for (int i = 0; i < old->size; i++) {
+		for (item = old->bucket[i]; item; item = next) {
+			next = item->key_next;
+			bucket = &keys->bucket[table_key_hash(item->values[keys->col]) & (keys->size - 1)];
+			item->key_next = *bucket;
+			*bucket = item;
 		}
-		item = container_of(node,struct table_item,node);
 	}
+	free(old);
+	table->keys = keys;
+}
 
-	/* 得到当前行在窗口内的高度 */
-	line -= table->start_line;
-	if ( visible_cols ) {
-		char value[256];
-		int id,x = 0;
-		desktop_lock();
-		wattron(table->window,display_attr);
-		mvwhline(table->window,line,x,' ',table->wg.width);
-		for (int j = 0 ; j < visible_cols ; j++) {
-			id = column[j]->index;
-			wstrncpy(value,item->values[id],column[j]->display_width);
-			mvwaddstr(table->window,line,x,value);
-			x += column[j]->display_width;
-		}
-		wattroff(table->window,display_attr);
-		
-		desktop_refresh();
-		desktop_unlock();
+
+/**
+  * @brief    将一行加入键索引，调用时表格已加锁
+*/
+static void table_keys_insert(struct table *table,struct table_item *item)
+{
+	struct table_item **bucket;
+
+	if (!table->keys) {
+		return;
 	}
-cleanup:
-	NWIDGET_MUTEX_UNLOCK(table->mutex);
-	return 0;
+	if (table->keys->count >= table->keys->size)
+		table_keys_grow(table);
+
+	bucket = &table->keys->bucket[table_key_hash(item->values[table->keys->col]) & (table->keys->size - 1)];
+	item->key_next = *bucket;
+	*bucket = item;
+	table->keys->count++;
 }
 
+
 /**
-  * @brief    表格控件聚焦时的回调
-  * @param    self : 目标表格所在的 wg 控件句柄
+  * @brief    将一行移出键索引，调用时表格已加锁
 */
-static int table_focus(struct nwidget *self)
+static void table_keys_remove(struct table *table,struct table_item *item)
 {
-	struct table *table = container_of(self, struct table,wg);
-	table_refresh_current_line(table,A_FOCUS);
-	/*if (table->show_title && table->wg.bkg){
-		int color,y,x,len;
-		y = x = table->show_border ? 1 : 0;
-		len = table->wg.width - x * 2;
-		if (table->wg.bkg == wgtheme.desktop_bkg )
-			color = wgtheme.desktop_fg;
-		else 
-			color = wgtheme.form_fg;
-		wattron(table->wg.win,color);
-		mvwhline(table->wg.win,y+1,x,table->ts,len);
-		wattroff(table->wg.win,color);
-	}*/
-	return WG_OK;
+	struct table_keys *keys = table->keys;
+	struct table_item **pos;
+
+	if (!keys) {
+		return;
+	}
+	pos = &keys->bucket[table_key_hash(item->values[keys->col]) & (keys->size - 1)];
+	for ( ; *pos; pos = &(*pos)->key_next) {
+		if (*pos == item) {
+			*pos = item->key_next;
+			keys->count--;
+			return;
+		}
+	}
 }
 
 
 /**
-  * @brief    表格控件失焦时的回调
-  * @param    self : 目标表格所在的 wg 控件句柄
+  * @brief    按键查找行，调用时表格已加锁
+  * @return   键列内容等于 key 的行，不存在返回 NULL
 */
-static int table_blur(struct nwidget *self)
+static struct table_item *table_keys_find(struct table *table,const char *key)
 {
-	struct table *table = container_of(self, struct table,wg);
-	table_refresh_current_line(table,A_UNFOCUS);
-	/*if (table->show_title && table->wg.bkg){
-		int y,x,len;
-		y = x = table->show_border ? 1 : 0;
-		len = table->wg.width - table->show_border;
-		mvwhline(table->wg.win,y+1,x,table->ts,len);
-	}*/
-	return WG_OK;
+	struct table_keys *keys = table->keys;
+	struct table_item *item;
+
+	item = keys->bucket[table_key_hash(key) & (keys->size - 1)];
+	for ( ; item; item = item->key_next) {
+		if (!strcmp(item->values[keys->col],key))
+			return item;
+	}
+	return NULL;
 }
 
 
 /**
-  * @brief    表格鼠标被按下时执行的回调函数，一般仅进行反显
-  * @param    self   : 目标表格所在的 wg 控件句柄
-  * @return   WG_OK
+  * @brief    以第 col 列为键重建键索引，调用时表格已加锁
+  * @param    col : 键列，为 -1 时删除索引
+  * @return   成功返回 0
 */
-static wg_state_t table_mousedown(struct nwidget *self)
+static int table_keys_build(struct table *table,int col)
 {
-	int selected,last,lines,min;
-	struct table *table = container_of(self, struct table,wg);
-	last = table->current_line;
-	lines = table->keyword[0] ? table->filter : table->lines;
-	if (mouse.bstate & BUTTON1_RELEASED){
-		return WG_OK;
+	struct table_keys *keys = NULL;
+	struct wg_list *node;
+	int size = 64;
+
+	while (size < table->lines)
+		size *= 2;
+	if (col >= 0 && NULL == (keys = table_keys_new(col,size))) {
+		return -1;
 	}
 
-	min = table->show_title + (table->show_border != 0);
-	selected = mouse.y - self->rely ;
-	if (selected < min) {
-		return WG_OK;
+	free(table->keys);
+	table->keys = keys;
+	for (node = table->items.next; keys && node != &table->items; node = node->next) {
+		table_keys_insert(table,container_of(node,struct table_item,node));
 	}
+	return 0;
+}
 
-	NWIDGET_MUTEX_LOCK(table->mutex);
-	selected -= table->show_border != 0;
-	selected -= table->show_title;
-	selected += table->start_line;
-	if (selected >= lines) {
-		NWIDGET_MUTEX_UNLOCK(table->mutex);
-		return WG_OK;
+
+/**
+  * @brief    清空键索引，表格被清空时调用，调用时表格已加锁
+*/
+static void table_keys_reset(struct table *table)
+{
+	if (table->keys) {
+		memset(table->keys->bucket,0,sizeof(struct table_item *) * table->keys->size);
+		table->keys->count = 0;
 	}
+}
 
-	table->current_line = selected;
-	if (last != selected)
-		table_refresh_raw(table,false,false);
 
-	NWIDGET_MUTEX_UNLOCK(table->mutex);
+/**
+  * @brief    释放所有下标，表格被清空时调用，调用时表格已加锁
+*/
+static void table_types_reset(struct table *table)
+{
+	if (table->types) {
+		table->types->slots = 0;
+		table->types->free_count = 0;
+		for (int i = 0; i < table->types->cols; i++)
+			table_dict_reset(table->types->col[i].dict);
+	}
+}
 
-	if (table->sig.clicked) 
-		table->sig.clicked(table,table->sig.clicked_arg);
-	
-	if (last != selected && table->sig.changed)
-		table->sig.changed(table,table->sig.changed_arg); 
-	
-	/*else if (table->sig.selected){
-		table->sig.selected(table,table->sig.selected_arg);
-	}*/
-	if ((mouse.bstate & BUTTON1_DOUBLE_CLICKED) && table->sig.selected)
-		table->sig.selected(table,table->sig.selected_arg);
-	return WG_OK;
+
+/**
+  * @brief    释放类型列
+*/
+static void table_types_free(struct table *table)
+{
+	if (table->types) {
+		for (int i = 0; i < table->types->cols; i++) {
+			free(table->types->col[i].data);
+			table_dict_free(table->types->col[i].dict);
+		}
+		free(table->types->free_slots);
+		free(table->types);
+		table->types = NULL;
+	}
 }
 
 
 /**
-  * @brief    删除一个表格所有数据
-  * @param    table : 目标表格
-  * @return   成功返回 0 
+  * @brief    获取单元格参与聚合的值
+  * @return   空单元格返回 0，非数值返回 1，数值返回 2 并存于 value
+  * @note     字符串按开头的数值解析，如 "12%" 计为 12
 */
-int table_clear(struct table *table)
+static int table_agg_value(struct table *table,struct table_item *item,int col,double *value)
 {
-	struct wg_list *node,*next;
+	struct table_type *type = table_col_type(table,col);
+	const char *str;
+	char *end;
 
-	NWIDGET_MUTEX_LOCK(table->mutex);
-	node = table->items.next;
-	wg_list_init(&table->items);
-	memset(table->keyword,0,sizeof(table->keyword));
-	table->start_line = table->filter = table->lines = 0;
-	table->current_line = table->current_col = -1;
-	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	if (type && !type->dict) {
+		*value = type->type == TABLE_COL_DOUBLE ? type->data[item->slot].f : (double)type->data[item->slot].i;
+		return 2;
+	}
+	str = type ? table_dict_word(type,item->slot) : item->values[col];
+	if (!str[0]) {
+		return 0;
+	}
+	*value = strtod(str,&end);
+	return end != str ? 2 : 1;
+}
 
-	desktop_lock();
-	werase(table->window);
-	desktop_refresh();
-	desktop_unlock();
 
-	table_scrollbar_update(table);
+static int table_agg_node_cmp(const struct wg_rank_node *a,const struct wg_rank_node *b,void *arg)
+{
+	double x = container_of(a,struct table_agg_node,rank)->value;
+	double y = container_of(b,struct table_agg_node,rank)->value;
+	(void)arg;
+	return (x > y) - (x < y);
+}
 
-	while (node != &table->items) {
-		next = node->next;
-		free(container_of(node,struct table_item,node));
-		node = next;
+
+/**
+  * @brief    在数值树中查找等于 value 的节点，O(log n)
+  * @return   找到返回节点，否则返回 NULL
+*/
+static struct table_agg_node *table_agg_node_find(struct wg_rank_tree *values,double value)
+{
+	struct wg_rank_node *node = values->root;
+	struct table_agg_node *agg;
+
+	while (node) {
+		agg = container_of(node,struct table_agg_node,rank);
+		if (value == agg->value)
+			return agg;
+		node = value < agg->value ? node->left : node->right;
+	}
+	return NULL;
+}
+
+
+static void table_agg_node_free(struct wg_rank_node *node)
+{
+	if (node) {
+		table_agg_node_free(node->left);
+		table_agg_node_free(node->right);
+		free(container_of(node,struct table_agg_node,rank));
 	}
-	return 0;
 }
 
 
 /**
-  * @brief    表格预关闭函数，通知用户层表格将被关闭
-  * @param    self : 表格所属的 widget 句柄
-  * @return   成功返回 0 
+  * @brief    清空一组聚合状态并释放其数值树
 */
-static int table_preclose(struct nwidget *self)
+static void table_agg_state_clear(struct table_agg_state *st)
 {
-	struct table *table = container_of(self, struct table,wg);
-	if (table->sig.closed)
-		table->sig.closed(table,table->sig.closed_arg);
-	return 0;
+	table_agg_node_free(st->values.root);
+	memset(st,0,sizeof(struct table_agg_state));
+	wg_rank_init(&st->values);
 }
 
 
 /**
-  * @brief    销毁一个表格，释放表格的内存
-  * @param    self : 表格所属的 widget 句柄
-  * @note     一般在 widget_delete 中由 table->wg.destroy 调用
-  * @return   成功返回 0 
+  * @brief    将一个值计入或移出一组聚合状态
+  * @param    kind : @see table_agg_value()
+  * @param    sign : 1 为计入，-1 为移出
+  * @param    ordered : 是否维护数值树，最小/最大值聚合时为真
+  * @note     数值树中每个不同数值一个节点，最小/最大值即树的首尾节点，
+  *           移出最后一个最小/最大值后无需重新扫描
 */
-static int table_destroy(struct nwidget *self)
+static void table_agg_state_add(struct table_agg_state *st,int kind,double value,int sign,int ordered)
 {
-	int item_num = 0;
-	struct wg_list *next,*node;
-	struct table *table = container_of(self, struct table,wg);
-
-	if (table->sig.closed)
-		table->sig.closed(table,table->sig.closed_arg);
+	struct table_agg_node *node;
 
-	node = table->items.next;
-	while(node != &table->items){
-		next = node->next;
-		free(container_of(node,struct table_item,node));
-		node = next;
-		item_num++;
+	if (!kind) {
+		return;
 	}
-
-	DEBUG_MSG("%s(free %d items)",__FUNCTION__,item_num);
-
-	visible_column_cleanup(table);
-	node = table->column.next;
-	while(node != &table->column) {
-		next = node->next;
-		free(container_of(node, struct table_column,node));
-		node = next;
+	st->count += sign;
+	if (kind < 2) {
+		return;
 	}
 
-	/* 当表格有边框或显示列标题时会创建子窗口 */
-	if (table->show_border || table->show_title) {
-		#ifdef VISIBLE_PANEL
-			if (table->panel)
-				del_panel(table->panel);
-		#endif
-		if (table->window)
-			delwin(table->window);
+	st->n += sign;
+	st->sum += sign * value;
+	if (st->n < 1) {
+		/* 已无数值，清除累积误差 */
+		st->sum = 0;
+	}
+	if (!ordered || value != value) {
+		return;
 	}
 
-	NWIDGET_MUTEX_DEINIT(table->mutex);
-
-	/* 由 table_create 创建的表格需要释放内存 */
-	if (table->created_by == wg_table_create){
-		DEBUG_MSG("%s(%p)",__FUNCTION__,table);
-		free(table);
+	node = table_agg_node_find(&st->values,value);
+	if (sign > 0) {
+		if (node) {
+			node->n++;
+		} else if ((node = malloc(sizeof(struct table_agg_node))) != NULL) {
+			node->value = value;
+			node->n = 1;
+			wg_rank_insert(&st->values,&node->rank,table_agg_node_cmp,NULL);
+		}
+	} else if (node && --node->n < 1) {
+		wg_rank_erase(&st->values,&node->rank);
+		free(node);
 	}
-	return 0;
 }
 
 
 /**
-  * @brief    filter editline '\n' 的执行函数
-  * @param    _filter   : filter editline
-  * @param    _table    : 回调参数
+  * @brief    将一行计入或移出聚合，调用时表格已加锁
+  * @param    col : 只处理该列，为 -1 时处理所有聚合列
+  * @param    sign : 1 为计入，-1 为移出
+  * @param    which : TABLE_AGGS_ALL 和/或 TABLE_AGGS_VIEW
 */
-static int table_column_do_hide(void *_selection,void *_table)
+static void table_aggs_item(struct table *table,struct table_item *item,int col,int sign,int which)
 {
-	struct wg_list *node;
-	struct table_column *column;
-	struct table *selection,*table;
-	int col,hide;
-	
-	selection = (struct table *)_selection;
-	table = (struct table *)_table;
-	col = wg_table_current_line(selection);
-	
-	NWIDGET_MUTEX_LOCK(table->mutex);
-	node = table->column.next;
-	for (int i = 0; i < col; i++) {
-		node = node->next;
+	struct table_aggs *aggs = table->aggs;
+	double value = 0;
+	int kind,ordered;
+
+	if (!aggs || !aggs->count) {
+		return;
 	}
-	column = container_of(node,struct table_column,node);
-	hide = !column->hide;
-	if (hide) {
-		/* 遍历所有列，如果仅存 1 列不允许隐藏 */
-		int show = 0;
-		node = table->column.next;
-		while (node != &table->column) {
-			struct table_column *check;
-			check = container_of(node,struct table_column,node);
-			node = node->next;
-			show += !check->hide;
-		}
-		if (show < 2) {
-			hide = 0;
-			beep();
-			goto unlock;
-		}
+	for (int i = col < 0 ? 0 : col; i < aggs->cols && (col < 0 || i == col); i++) {
+		if (aggs->col[i].agg == TABLE_AGG_NONE)
+			continue;
+		kind = table_agg_value(table,item,i,&value);
+		ordered = aggs->col[i].agg == TABLE_AGG_MIN || aggs->col[i].agg == TABLE_AGG_MAX;
+		if (which & TABLE_AGGS_ALL)
+			table_agg_state_add(&aggs->col[i].all,kind,value,sign,ordered);
+		if (which & TABLE_AGGS_VIEW)
+			table_agg_state_add(&aggs->col[i].view,kind,value,sign,ordered);
 	}
+}
 
-	column->hide = hide;
-	visible_column_cleanup(table);
-	visible_column_checkout(table,0);
-	table_refresh_raw(table,true,false);
-unlock:
-	NWIDGET_MUTEX_UNLOCK(table->mutex);
-	wg_table_cell_update(selection,col,0,hide ? "[ ]":"[*]");
-	return WG_OK;
+
+/**
+  * @brief    行所在的聚合，在过滤视图中的行同时计入过滤视图的聚合
+*/
+static inline int table_aggs_of(struct table_item *item)
+{
+	return TABLE_AGGS_ALL | (wg_rank_linked(&item->filter_rank) ? TABLE_AGGS_VIEW : 0);
 }
 
 
 /**
-  * @brief    响应 '/' 弹出列隐藏表格弹框
-  * @param    self : 目标表格所在的 wg 控件句柄
-  * @param    key : 键
+  * @brief    清空聚合状态，调用时表格已加锁
+  * @param    which : TABLE_AGGS_ALL 和/或 TABLE_AGGS_VIEW
 */
-static wg_state_t table_column_hide(struct nwidget *self,long key)
+static void table_aggs_reset(struct table *table,int which)
 {
-	static const struct wghandler wg_handlers[] = {
-		{'/',widget_exit_left},
-		{'\t',widget_exit_left},
-		{'\e',widget_exit_left},
-		{KEY_BACKSPACE,widget_exit_left},
-		{0,0}
-	};
-	int height,width,x,y;
-	char *values[2];
-	struct wg_list *node;
-	struct table_column *column;
-	struct table *selection,*table = container_of(self, struct table,wg);
-	if (table->cols < 2) {
-		beep();
-		return WG_OK;
+	for (int i = 0; table->aggs && i < table->aggs->cols; i++) {
+		if (which & TABLE_AGGS_ALL)
+			table_agg_state_clear(&table->aggs->col[i].all);
+		if (which & TABLE_AGGS_VIEW)
+			table_agg_state_clear(&table->aggs->col[i].view);
 	}
+}
 
-	/* 换算弹框的位置，尽量在原表格的居中位置 */
-	height = table->cols + 4;
-	if (table->wg.height > height) {
-		y = table->wg.rely + (table->wg.height-height)/2;
-		height = height;
-	} else {
-		y = table->wg.rely;
-		height = table->wg.height;
-	}
 
-	if (table->wg.width > 32) {
-		x = table->wg.relx + (table->wg.width-32)/2;
-		width = 32;
-	} else if (table->wg.width >= 16) {
-		x = table->wg.relx + 1;
-		width = table->wg.width - 2;
-	} else {
-		x = table->wg.relx - (16-table->wg.width)/2;
-		width = 16;
+/**
+  * @brief    获取当前视图下第 col 列的聚合结果，调用时表格已加锁
+  * @return   成功返回 0，未设置聚合或没有数值时返回 -1
+*/
+static int table_agg_result(struct table *table,int col,double *value)
+{
+	struct table_agg *agg;
+	struct table_agg_state *st;
+	struct wg_rank_node *node;
+	int view = table_filtering(table);
+
+	if (!table->aggs || col < 0 || col >= table->aggs->cols ||
+		(agg = &table->aggs->col[col])->agg == TABLE_AGG_NONE) {
+		return -1;
+	}
+	st = view ? &agg->view : &agg->all;
+	if (agg->agg == TABLE_AGG_COUNT) {
+		*value = (double)st->count;
+		return 0;
+	}
+	if (st->n < 1) {
+		return -1;
+	}
+	switch (agg->agg) {
+	case TABLE_AGG_MIN:
+	case TABLE_AGG_MAX:
+		node = agg->agg == TABLE_AGG_MIN ? wg_rank_first(&st->values) : wg_rank_last(&st->values);
+		if (!node)
+			return -1;
+		*value = container_of(node,struct table_agg_node,rank)->value;
+		break;
+	case TABLE_AGG_MEAN:
+		*value = st->sum / st->n;
+		break;
+	default:
+		*value = st->sum;
+		break;
 	}
+	return 0;
+}
 
-	char msg[256];
-	snprintf(msg, sizeof(msg),"%d,%d",y,x);
-	desktop_tips(msg);
 
-	/* 创建一个新的表格覆盖于当前表格之上 */
-	selection = wg_table_create(height,width,TABLE_BORDER|TABLE_TITLE);
-	wg_table_column_add(selection,"",3);
-	wg_table_column_add(selection,"column name",32);
+/**
+  * @brief    一列的分面，未设置时返回 NULL
+*/
+static inline struct table_facet *table_facet_of(struct table *table,int col)
+{
+	struct table_facets *facets = table->facets;
+	return facets && col < facets->cols ? facets->col[col] : NULL;
+}
 
-	/* 新建的表格悬空，使其失焦后自动销毁 */
-	wg_table_put(selection,NULL,y,x);
 
-	/* 更新键盘响应和信号，在选择窗口被销毁后刷新原表格的列 */
-	handlers_update(&selection->wg,wg_handlers);
-	wg_signal_connect(selection,selected,table_column_do_hide,table);
-	
-	for (node = table->column.next; node != &table->column; node = node->next) {
-		column = container_of(node,struct table_column,node);
-		values[0] = column->hide ? "[ ]" : "[*]";
-		values[1] = column->title;
-		wg_table_item_add(selection,values);
+static void table_facet_free(struct table_facet *facet)
+{
+	if (facet) {
+		table_dict_reset(&facet->dict);
+		free(facet->dict.words);
+		free(facet->dict.hash);
+		free(facet->counts);
+		free(facet);
 	}
+}
 
-	return WG_OK;
+
+/**
+  * @brief    移出行数为 0 的值，重建字典
+  * @note     内存不足时沿用原字典
+*/
+static void table_facet_compact(struct table_facet *facet)
+{
+	struct table_dict dict;
+	long long *counts;
+	int code,live = facet->dict.count - facet->dead;
+
+	memset(&dict,0,sizeof(dict));
+	if (NULL == (counts = malloc(sizeof(long long) * (live + 1)))) {
+		return;
+	}
+	for (int i = 0; i < facet->dict.count; i++) {
+		if (!facet->counts[i])
+			continue;
+		if ((code = table_dict_code(&dict,facet->dict.words[i],1)) < 0) {
+			table_dict_reset(&dict);
+			free(dict.words);
+			free(dict.hash);
+			free(counts);
+			return;
+		}
+		counts[code] = facet->counts[i];
+	}
+	table_dict_reset(&facet->dict);
+	free(facet->dict.words);
+	free(facet->dict.hash);
+	free(facet->counts);
+	facet->dict = dict;
+	facet->counts = counts;
+	facet->size = live + 1;
+	facet->dead = 0;
 }
 
+
 /**
-  * @brief    放置一个 table 控件
-  * @param    table : 表格
-  * @param    parent : 父窗体
-  * @param    y : 父窗体的y坐标
-  * @param    x : 父窗体的x坐标
-  * @return   成功返回 0
+  * @brief    将一个值计入或移出分面
+  * @param    sign : 1 为计入，-1 为移出
+  * @note     内存不足时该值不计入，分面的行数偏少
 */
-int wg_table_put(struct table *table,struct nwidget *parent,int y,int x)
+static void table_facet_add(struct table_facet *facet,const char *value,int sign)
 {
-	static const char tips[] = 
+	long long *counts;
+	int code,count = facet->dict.count;
+
+	/* counts[] 预留新值的位置 */
+	if (sign > 0 && count >= facet->size) {
+		if (NULL == (counts = realloc(facet->counts,sizeof(long long) * (facet->size * 2 + 16)))) {
+			return;
+		}
+		facet->counts = counts;
+		facet->size = facet->size * 2 + 16;
+	}
+	if ((code = table_dict_code(&facet->dict,value,sign > 0)) < 0) {
+		return;
+	}
+
+	if (code >= count) {
+		facet->counts[code] = 0;
+	} else if (!facet->counts[code]) {
+		if (sign < 0)
+			return;
+		facet->dead--;
+	}
+	facet->counts[code] += sign;
+	if (!facet->counts[code] && ++facet->dead > 64 && facet->dead * 2 > facet->dict.count) {
+		table_facet_compact(facet);
+	}
+}
+
+
+/**
+  * @brief    将一行计入或移出各分面列，调用时表格已加锁
+  * @param    col : 只处理该列，为 -1 时处理所有分面列
+  * @param    sign : 1 为计入，-1 为移出
+*/
+static void table_facets_item(struct table *table,struct table_item *item,int col,int sign)
+{
+	struct table_facets *facets = table->facets;
+	struct table_facet *facet;
+	char buf[256];
+
+	if (!facets || !facets->count) {
+		return;
+	}
+	for (int i = col < 0 ? 0 : col; i < facets->cols && (col < 0 || i == col); i++) {
+		if (NULL != (facet = facets->col[i]))
+			table_facet_add(facet,table_cell_text(table,item,i,buf,sizeof(buf)),sign);
+	}
+}
+
+
+/**
+  * @brief    清空各分面列，表格被清空时调用，调用时表格已加锁
+*/
+static void table_facets_reset(struct table *table)
+{
+	for (int i = 0; table->facets && i < table->facets->cols; i++) {
+		if (table->facets->col[i]) {
+			table_dict_reset(&table->facets->col[i]->dict);
+			table->facets->col[i]->dead = 0;
+		}
+	}
+}
+
+
+/**
+  * @brief    将整行内容重新打包至 item->heap，调用时表格已加锁
+  * @param    col : 改为 value 的列，为 -1 时内容不变，只按当前的检索索引列重新生成检索键
+  * @return   成功返回 0，内存不足返回 -1
+*/
+static int table_item_repack(struct table *table,struct table_item *item,int col,const char *value)
+{
+	char *heap,*cell;
+	const char *src;
+	size_t size = 0,len;
+
+	for (int i = 0; i < table->cols; i++) {
+		size += table_cell_space(table,i,i == col ? value : item->values[i]);
+	}
+	if (NULL == (cell = heap = wg_arena_alloc(&table->arena,size))) {
+		return -1;
+	}
+
+	for (int i = 0; i < table->cols; i++) {
+		src = i == col ? value : item->values[i];
+		len = strlen(src) + 1;
+		memcpy(cell,src,len);
+		item->values[i] = cell;
+		cell += len;
+		if (table_col_search(table,i))
+			cell += wg_pinyin_key(item->values[i],cell,(size_t)-1) + 1;
+	}
+	wg_arena_free(&table->arena,item->heap);
+	item->heap = heap;
+	return 0;
+}
+
+
+/**
+  * @brief    修改一行中某个单元格的内容
+  * @param    table : 目标表格
+  * @param    item : 指定行
+  * @param    col : 指定列
+  * @param    value : 新内容
+  * @note     新内容(含检索键)不长于原内容时原地修改，否则将整行内容重新打包至 item->heap
+  * @return   成功返回 0，内存不足返回 -1
+*/
+static int table_item_set(struct table *table,struct table_item *item,int col,const char *value)
+{
+	struct table_type *type = table_col_type(table,col);
+	size_t len = strlen(value);
+	int ret = 0;
+
+	table_aggs_item(table,item,col,-1,table_aggs_of(item));
+	table_facets_item(table,item,col,-1);
+	if (type) {
+		type->data[item->slot] = table_value_parse(type,value);
+	} else if (!table_col_search(table,col) && len <= strlen(item->values[col])) {
+		memmove(item->values[col],value,len + 1);
+	} else if (table_col_search(table,col) &&
+		len + wg_pinyin_key(value,NULL,0) <= strlen(item->values[col]) + strlen(table_cell_key(item,col))) {
+		memmove(item->values[col],value,len + 1);
+		wg_pinyin_key(item->values[col],item->values[col] + len + 1,(size_t)-1);
+	} else {
+		ret = table_item_repack(table,item,col,value);
+	}
+	table_aggs_item(table,item,col,1,table_aggs_of(item));
+	table_facets_item(table,item,col,1);
+	return ret;
+}
+
+
+/**
+  * @brief    按比较方式比较两个单元格的值
+  * @param    type : @see enum table_sort_type
+*/
+static int table_value_cmp(const char *a,const char *b,int type)
+{
+	switch (type) {
+	case TABLE_SORT_INT: {
+		long long x = strtoll(a,NULL,10),y = strtoll(b,NULL,10);
+		return (x > y) - (x < y);
+	}
+	case TABLE_SORT_FLOAT: {
+		double x = strtod(a,NULL),y = strtod(b,NULL);
+		return (x > y) - (x < y);
+	}
+	case TABLE_SORT_COLLATE:
+		return strcoll(a,b);
+	default:
+		return strcmp(a,b);
+	}
+}
+
+
+/**
+  * @brief    按原始值比较类型列的两个值
+*/
+static int table_typed_cmp(struct table_type *type,int a,int b)
+{
+	union table_value *x = &type->data[a],*y = &type->data[b];
+	if (type->type == TABLE_COL_DOUBLE)
+		return (x->f > y->f) - (x->f < y->f);
+	return (x->i > y->i) - (x->i < y->i);
+}
+
+
+/**
+  * @brief    按当前排序键比较两行，排序键相同时按插入顺序
+*/
+static int table_items_cmp(struct table *table,struct table_item *x,struct table_item *y)
+{
+	struct table_sort_key *key = table->sort_keys;
+	struct table_type *type;
+	int ret;
+	for (int i = 0; i < table->sort_nkeys; i++,key++) {
+		if (NULL != (type = table_col_type(table,key->col)) && type->dict)
+			ret = table_value_cmp(table_dict_word(type,x->slot),table_dict_word(type,y->slot),key->type);
+		else if (type)
+			ret = table_typed_cmp(type,x->slot,y->slot);
+		else
+			ret = table_value_cmp(x->values[key->col],y->values[key->col],key->type);
+		if (ret)
+			return key->descending ? -ret : ret;
+	}
+	return (int)(x->seq - y->seq);
+}
+
+
+static int table_rank_cmp(const struct wg_rank_node *a,const struct wg_rank_node *b,void *table)
+{
+	return table_items_cmp(table,
+		container_of(a,struct table_item,rank),container_of(b,struct table_item,rank));
+}
+
+
+static int table_filter_rank_cmp(const struct wg_rank_node *a,const struct wg_rank_node *b,void *table)
+{
+	return table_items_cmp(table,
+		container_of(a,struct table_item,filter_rank),container_of(b,struct table_item,filter_rank));
+}
+
+
+/**
+  * @brief    当前显示顺序是否按排序键有序
+*/
+static inline int table_is_sorted(struct table *table)
+{
+	return table->sort_nkeys && !table->sort_pending;
+}
+
+
+/**
+  * @brief    指定列是否为排序键
+*/
+static int table_is_sort_key(struct table *table,int col)
+{
+	for (int i = 0; i < table->sort_nkeys; i++) {
+		if (table->sort_keys[i].col == col)
+			return 1;
+	}
+	return 0;
+}
+
+
+static inline int table_is_virtual(struct table *table)
+{
+	return table->source.fill != NULL;
+}
+
+
+/**
+  * @brief    释放虚拟表格的行缓存
+  * @param    table : 目标表格
+*/
+static void table_vcache_free(struct table *table)
+{
+	struct table_vcache *cache = table->vcache;
+	if (cache) {
+		for (int i = 0; i < cache->rows; i++) {
+			free(cache->slot[i]);
+		}
+		free(cache);
+		table->vcache = NULL;
+	}
+}
+
+
+/**
+  * @brief    检出虚拟表格的行缓存，列数改变时重新分配
+  * @param    table : 目标表格
+  * @return   成功返回缓存，否则返回 NULL
+*/
+static struct table_vcache *table_vcache_checkout(struct table *table)
+{
+	struct table_vcache *cache = table->vcache;
+	struct table_vrow *row;
+	int rows,size,cols = table->cols;
+	char *value;
+
+	rows = table->wg.height * 4;
+	if (rows < 32)
+		rows = 32;
+	if (cache && cache->cols == cols && cache->rows >= rows) {
+		return cache;
+	}
+
+	table_vcache_free(table);
+	size = sizeof(struct table_vcache) + sizeof(struct table_vrow *) * rows;
+	if (!cols || NULL == (cache = malloc(size))) {
+		return NULL;
+	}
+	memset(cache,0,size);
+	cache->cols = cols;
+	cache->size = table->wg.width * 2;
+	table->vcache = cache;
+
+	size = sizeof(struct table_vrow) + (sizeof(char *) + 1 + cache->size) * cols;
+	for (cache->rows = 0; cache->rows < rows; cache->rows++) {
+		if (NULL == (row = malloc(size))) {
+			table_vcache_free(table);
+			return NULL;
+		}
+		row->line = -1;
+		row->pending = 0;
+		row->state = (unsigned char *)&row->values[cols];
+		value = (char *)&row->state[cols];
+		for (int i = 0; i < cols; i++) {
+			row->state[i] = 0;
+			row->values[i] = value;
+			value += cache->size;
+		}
+		cache->slot[cache->rows] = row;
+	}
+	return cache;
+}
+
+
+/**
+  * @brief    获取虚拟表格的一行，未缓存时向数据源请求
+  * @param    table : 目标表格
+  * @param    line : 指定行
+  * @return   行数据，数据源尚未给出的单元格为 TABLE_PLACEHOLDER
+*/
+static char **table_virtual_row(struct table *table,int line)
+{
+	struct table_vcache *cache;
+	struct table_vrow *row;
+	int state;
+
+	if (line < 0 || line >= table->lines) {
+		return NULL;
+	}
+	if (NULL == (cache = table_vcache_checkout(table))) {
+		return NULL;
+	}
+
+	row = cache->slot[line % cache->rows];
+	if (row->line == line) {
+		return row->values;
+	}
+
+	row->line = line;
+	row->pending = 0;
+	for (int i = 0; i < cache->cols; i++) {
+		row->values[i][0] = '\0';
+		state = table->source.fill(table,line,i,row->values[i],cache->size,table->source.arg);
+		row->values[i][cache->size-1] = '\0';
+		row->state[i] = (state == TABLE_FILL_PENDING);
+		if (row->state[i]) {
+			strcpy(row->values[i],TABLE_PLACEHOLDER);
+			row->pending++;
+		}
+	}
+	return row->values;
+}
+
+
+/**
+  * @brief    向数据源请求 [line,line+count) 范围的行
+  * @param    table : 目标表格
+  * @param    line : 起始行
+  * @param    count : 行数
+*/
+static void table_virtual_load(struct table *table,int line,int count)
+{
+	int end = line + count;
+	for (line = line < 0 ? 0 : line ; line < end && line < table->lines; line++) {
+		table_virtual_row(table,line);
+	}
+}
+
+
+/**
+  * @brief    按滚动方向预取下一页
+  * @param    table : 目标表格
+  * @param    height : 可视行数
+*/
+static void table_virtual_prefetch(struct table *table,int height)
+{
+	struct table_vcache *cache = table->vcache;
+	int start = table->start_line;
+	if (!cache) {
+		return;
+	}
+
+	if (start > cache->last_start) {
+		table_virtual_load(table,start + height,height);
+	} else if (start < cache->last_start) {
+		table_virtual_load(table,start - height,height);
+	}
+	cache->last_start = start;
+}
+
+
+/**
+  * @brief    释放行显示缓存
+  * @param    table : 目标表格
+*/
+static void table_rcache_free(struct table *table)
+{
+	struct table_rcache *cache = table->rcache;
+	if (cache) {
+		for (int i = 0; i < cache->rows; i++) {
+			free(cache->slot[i]);
+		}
+		free(cache);
+		table->rcache = NULL;
+	}
+}
+
+
+/**
+  * @brief    检出行显示缓存，控件尺寸改变时重新分配
+  * @param    table : 目标表格
+  * @return   成功返回缓存，否则返回 NULL
+*/
+static struct table_rcache *table_rcache_checkout(struct table *table)
+{
+	struct table_rcache *cache = table->rcache;
+	int rows,size,text,cols;
+
+	rows = table->wg.height * 4;
+	if (rows < 32)
+		rows = 32;
+
+	/* 每个显示宽度至多占用 1.5 个字节 @see wstrncpy()，保持偶数使 len[] 对齐 */
+	text = table->wg.width * 2 + 2;
+	cols = table->wg.width > 0 ? table->wg.width : 1;
+	if (cache && cache->rows >= rows && cache->size >= text && cache->cols >= cols) {
+		return cache;
+	}
+
+	table_rcache_free(table);
+	size = sizeof(struct table_rcache) + sizeof(struct table_rline *) * rows;
+	if (NULL == (cache = calloc(1,size))) {
+		return NULL;
+	}
+	cache->size = text;
+	cache->cols = cols;
+	table->rcache = cache;
+
+	size = sizeof(struct table_rline) + text + sizeof(short) * cols;
+	for (cache->rows = 0; cache->rows < rows; cache->rows++) {
+		if (NULL == (cache->slot[cache->rows] = calloc(1,size))) {
+			table_rcache_free(table);
+			return NULL;
+		}
+		cache->slot[cache->rows]->len = (short *)(cache->slot[cache->rows]->text + text);
+	}
+	return cache;
+}
+
+
+/**
+  * @brief    单元格内容改变，丢弃该行的显示缓存
+  * @param    table : 目标表格
+  * @param    item : 指定行
+*/
+static void table_rcache_drop(struct table *table,struct table_item *item)
+{
+	struct table_rline *rline;
+	if (table->rcache) {
+		rline = table->rcache->slot[item->seq % table->rcache->rows];
+		if (rline->item == item)
+			rline->item = NULL;
+	}
+}
+
+
+/**
+  * @brief    释放一行，调用时表格已加锁
+*/
+static void table_item_free(struct table *table,struct table_item *item)
+{
+	table_rcache_drop(table,item);
+	table_slot_free(table,item->slot);
+	wg_arena_free(&table->arena,item->heap);
+	wg_arena_free(&table->arena,item);
+}
+
+
+/**
+  * @brief    释放后台排序期间删除的行，调用时表格已加锁
+*/
+static void table_graveyard_free(struct table *table)
+{
+	struct wg_list *node,*next;
+	for (node = table->graveyard.next; node != &table->graveyard; node = next) {
+		next = node->next;
+		table_item_free(table,container_of(node,struct table_item,node));
+	}
+	wg_list_init(&table->graveyard);
+}
+
+
+/**
+  * @brief    获取一行按当前可视列截断后的显示内容，未缓存时生成
+  * @param    table : 目标表格
+  * @param    item : 指定行
+  * @return   成功返回显示缓存，否则返回 NULL
+*/
+static struct table_rline *table_rline_get(struct table *table,struct table_item *item)
+{
+	struct table_rcache *cache;
+	struct table_rline *rline;
+	char *text;
+	const char *value;
+	char buf[256];
+
+	if (NULL == (cache = table_rcache_checkout(table))) {
+		return NULL;
+	}
+
+	rline = cache->slot[item->seq % cache->rows];
+	if (rline->item == item && rline->seq == item->seq && rline->layout == table->layout) {
+		return rline;
+	}
+
+	text = rline->text;
+	for (int i = 0; i < table->visible_cols; i++) {
+		value = table_cell_text(table,item,table->visible[i]->index,buf,sizeof(buf));
+		rline->len[i] = wstrncpy(text,value,table->visible[i]->display_width);
+		text += rline->len[i];
+	}
+	rline->item = item;
+	rline->seq = item->seq;
+	rline->layout = table->layout;
+	return rline;
+}
+
+
+/**
+  * @brief    在表格可视窗口的第 y 行绘制一行数据，调用前需 desktop_lock()
+  * @param    table : 目标表格
+  * @param    y : 可视窗口内的行
+  * @param    values : 行数据
+  * @param    attr : 显示格式，为 0 时正常显示
+*/
+static void table_draw_row(struct table *table,int y,char **values,long attr)
+{
+	char value[256];
+	int id,x = 0;
+	struct table_column **column = table->visible;
+	WINDOW *win = table->window;
+
+	if (attr)
+		wattron(win,attr);
+	mvwhline(win,y,0,' ',table->wg.width);
+	for (int i = 0; i < table->visible_cols; i++) {
+		id = column[i]->index;
+		wstrncpy(value,values[id],column[i]->display_width);
+		mvwaddstr(win,y,x,value);
+		x += column[i]->display_width;
+	}
+	if (attr)
+		wattroff(win,attr);
+}
+
+
+/**
+  * @brief    只重绘一行中的部分可视列，调用前需 desktop_lock()
+  * @param    table : 目标表格
+  * @param    y : 可视窗口内的行
+  * @param    item : 行
+  * @param    cells : 需重绘的可视列，第 i 位对应 table->visible[i] @see TABLE_CELL_BIT
+  * @param    attr : 显示格式，为 0 时正常显示
+*/
+static void table_draw_cells(struct table *table,int y,struct table_item *item,unsigned int cells,long attr)
+{
+	struct table_rline *rline = table_rline_get(table,item);
+	WINDOW *win = table->window;
+	char value[256],buf[256],*text = rline ? rline->text : NULL;
+	const char *cell;
+	int len,width,x = 0;
+
+	if (attr)
+		wattron(win,attr);
+	for (int i = 0; i < table->visible_cols; i++) {
+		width = table->visible[i]->display_width;
+		if (rline) {
+			len = rline->len[i];
+		} else if (cells & TABLE_CELL_BIT(i)) {
+			cell = table_cell_text(table,item,table->visible[i]->index,buf,sizeof(buf));
+			len = wstrncpy(value,cell,width);
+		}
+		if (cells & TABLE_CELL_BIT(i)) {
+			mvwhline(win,y,x,' ',width);
+			mvwaddnstr(win,y,x,rline ? text : value,len);
+		}
+		if (rline)
+			text += len;
+		x += width;
+	}
+	if (attr)
+		wattroff(win,attr);
+}
+
+
+/**
+  * @brief    在表格可视窗口的第 y 行绘制一行，优先使用行显示缓存，调用前需 desktop_lock()
+  * @param    table : 目标表格
+  * @param    y : 可视窗口内的行
+  * @param    item : 行
+  * @param    attr : 显示格式，为 0 时正常显示
+*/
+static void table_draw_item(struct table *table,int y,struct table_item *item,long attr)
+{
+	struct table_rline *rline;
+	WINDOW *win = table->window;
+	char *text;
+	int x = 0;
+
+	if (NULL == (rline = table_rline_get(table,item))) {
+		if (attr)
+			wattron(win,attr);
+		mvwhline(win,y,0,' ',table->wg.width);
+		if (attr)
+			wattroff(win,attr);
+		table_draw_cells(table,y,item,~0u,attr);
+		return;
+	}
+
+	if (attr)
+		wattron(win,attr);
+	mvwhline(win,y,0,' ',table->wg.width);
+	text = rline->text;
+	for (int i = 0; i < table->visible_cols; i++) {
+		mvwaddnstr(win,y,x,text,rline->len[i]);
+		text += rline->len[i];
+		x += table->visible[i]->display_width;
+	}
+	if (attr)
+		wattroff(win,attr);
+}
+
+
+/**
+  * @brief    获取表格行数据
+  * @param    table : 目标表格
+  * @param    line : 指定行
+  * @return   行数据，如 values[0] 为指定行第一列数据
+*/
+char **wg_table_values(struct table *table,int line)
+{
+	struct table_item *item;
+	char **values;
+	assert(table);
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (table_is_virtual(table)) {
+		values = table_virtual_row(table,line);
+	} else {
+		item = table_item_at(table,line);
+		values = item ? item->values : NULL;
+	}
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return values;
+}
+
+
+/**
+  * @brief    获取表格指定单元格数据
+  * @param    table   : 目标表格
+  * @param    line    : 指定行
+  * @param    column  : 指定列
+  * @return   单元数据
+*/
+char *wg_table_value(struct table *table,int line,int column)
+{
+	struct table_item *item;
+	char **row,*value = NULL;
+	assert(table);
+	if (column < 0 || column >= table->cols) {
+		return NULL;
+	}
+
+	if (table_is_virtual(table) || !table_col_type(table,column)) {
+		row = wg_table_values(table,line);
+		return row ? row[column] : NULL;
+	}
+
+	/* 类型列格式化至表格内的缓冲 */
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (NULL != (item = table_item_at(table,line))) {
+		value = (char *)table_cell_text(table,item,column,table->types->buf,sizeof(table->types->buf));
+	}
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return value;
+}
+
+
+/**
+  * @brief    清空可视列
+  * @param    table : 目标表格
+  * @return   0
+*/
+static int visible_column_cleanup(struct table *table)
+{
+	for (int i = 0; i < table->visible_cols ; i++) {
+		table->visible[i]->display_width = 0;
+	}
+	table->visible = NULL;
+	table->visible_cols = 0;
+	return 0;
+}
+
+
+/**
+  * @brief    重建未隐藏列的索引 table->shown，调用时表格已加锁
+  * @note     只在增加列或改变隐藏状态时调用，横向滚动时直接按下标定位起始列
+  * @return   成功返回 0，内存不足时沿用原索引并返回 -1
+*/
+static int table_layout_index(struct table *table)
+{
+	struct table_column **shown,*column;
+	struct wg_list *node;
+	int count = 0;
+
+	/* visible 指向 shown[] 的一段，重建前清空 */
+	visible_column_cleanup(table);
+	shown = realloc(table->shown,sizeof(struct table_column *) * (table->cols + 1));
+	if (!shown) {
+		return -1;
+	}
+	for (node = table->column.next; node != &table->column; node = node->next) {
+		column = container_of(node,struct table_column,node);
+		if (!column->hide)
+			shown[count++] = column;
+	}
+	table->shown = shown;
+	table->shown_cols = count;
+	return 0;
+}
+
+
+/**
+  * @brief    检出可显示的列至 table->visible
+  * @param    table : 目标表格
+  * @param    start_col : 从第几列开始展示，为 table->shown 的下标
+  * @note     即 start_col 以下的列将折叠到左侧不被展示；
+  *           只遍历可显示的列，与表格的总列数无关
+  * @return   0
+*/
+static int visible_column_checkout(struct table *table,int start_col)
+{
+	int has_next_column = 0;
+	int width,visible_cols = 0;
+	struct table_column *column,**visible = NULL;
+
+	visible_column_cleanup(table);
+	if (start_col < 0 || start_col >= table->shown_cols) {
+		goto cleanup;
+	}
+
+	/* 除去边框为表格的有效显示宽度 */
+	width = table->wg.width - table->show_border;
+
+	/* 从第 start_col 列起计入当前窗口可显示的列 */
+	visible = &table->shown[start_col];
+	while (start_col + visible_cols < table->shown_cols) {
+		column = visible[visible_cols++];
+		if (width > column->width){
+			column->display_width = column->width;
+		} else {
+			column->display_width = width;
+		}
+
+		/* 剩余空间不足 3 列，跳出 */
+		width -= column->display_width;
+		if (width < 3) {
+			break;
+		}
+	}
+
+	/* 判断当前表格窗口右侧是否仍有未显示完全的内容 */
+	column = visible[visible_cols - 1];
+	has_next_column = (column->display_width < column->width - 1) ||
+		start_col + visible_cols < table->shown_cols;
+
+	/* 如果显示完所有列后仍有剩余空间，均匀分配至各列 */
+	for (int i = 0 ; i < width ; i++) {
+		visible[i%visible_cols]->display_width++;
+	}
+
+cleanup:
+	table->layout++;
+	table->visible = visible;
+	table->visible_cols = visible_cols;
+	table->has_prev_column = table->start_col = start_col;
+	table->has_next_column = has_next_column;
+	return 0;
+}
+
+
+
+
+/**
+  * @brief    表格重新绘制列标题
+  * @param    table : 目标表格
+  * @param    draw_hline : 是否绘制水平分割线
+  * @return   0
+*/
+static void table_column_title(struct table *table,int draw_hline)
+{
+	char value[256];
+	int col,y,x,width;
+	struct table_column **column = table->visible;
+
+	y = x = table->show_border ? 1 : 0;
+	width = table->wg.width - x * 2;
+
+	mvwhline(table->wg.win,y,x,' ',width);
+	if (draw_hline){
+		chtype hline = table->ts ? table->ts : ACS_HLINE;
+		mvwhline(table->wg.win,y+1,x,hline,width);
+	}
+
+	for (col = 0; col < table->visible_cols; col++) {
+		width = column[col]->display_width;
+		wstrncpy(value,column[col]->title,width);
+		mvwaddstr(table->wg.win,y,x,value);
+		x += width;
+	}
+	desktop_refresh();
+}
+
+/**
+  * @brief    表格页脚刷新
+  * @param    table : 目标表格
+*/
+static void table_footer(struct table *table)
+{
+	static const char *const names[] = {
+		[TABLE_AGG_SUM] = "sum ",
+		[TABLE_AGG_MIN] = "min ",
+		[TABLE_AGG_MAX] = "max ",
+		[TABLE_AGG_MEAN] = "avg ",
+		[TABLE_AGG_COUNT] = "n ",
+	};
+	char value[13],text[64],cell[256];
+	int x,y,lines,width,limit;
+	double result;
+
+	y = table->wg.height - 1;
+	x = table->wg.width - 2;
+	lines = table_filtering(table) ? table->filter : table->lines;
+
+	mvwhline(table->wg.win,y,1,table->bs,x);
+
+	/* 各列的聚合显示在该列下方，行数信息只在第一个聚合之前有空间时显示 */
+	limit = table->wg.width - 1;
+	x = 1;
+	for (int i = 0; table->aggs && table->aggs->count && i < table->visible_cols; i++) {
+		int col = table->visible[i]->index;
+		width = table->visible[i]->display_width;
+		if (col < table->aggs->cols && table->aggs->col[col].agg != TABLE_AGG_NONE && width > 1) {
+			if (table_agg_result(table,col,&result))
+				snprintf(text,sizeof(text),"%s-",names[table->aggs->col[col].agg]);
+			else
+				snprintf(text,sizeof(text),"%s%.10g",names[table->aggs->col[col].agg],result);
+			wstrncpy(cell,text,width - 1);
+			mvwaddstr(table->wg.win,y,x,cell);
+			limit = x < limit ? x : limit;
+		}
+		x += width;
+	}
+
+	x = 1;
+	if (table->current_line > -1) {
+		value[12] = '\0';
+		snprintf(value,12,"%d/%d",table->current_line,lines);
+		if (x + (int)strlen(value) < limit) {
+			mvwaddstr(table->wg.win,y,1,value);
+			x += strlen(value) + 1;
+		}
+	}
+
+	/* 后台加载进度，总大小未知时显示已读取的字节数 */
+	if (table->loader && table->loader->running) {
+		char progress[24];
+		if (table->loader->total > 0)
+			snprintf(progress,sizeof(progress),"[%d%%]",(int)(table->loader->done * 100 / table->loader->total));
+		else
+			snprintf(progress,sizeof(progress),"[%lldK]",table->loader->done / 1024);
+		if (x + (int)strlen(progress) < table->wg.width - 1 - 8 && x + (int)strlen(progress) < limit)
+			mvwaddstr(table->wg.win,y,x,progress);
+	}
+
+	if (table->has_prev_column || table->has_next_column) {
+		char *stat = "";
+		x = table->wg.width-1-7;
+		mvwaddch(table->wg.win,y,x,ACS_RTEE);
+		mvwaddch(table->wg.win,y,x+6,ACS_LTEE);
+		if (!table->has_prev_column)
+			stat = "===  ";
+		else if (!table->has_next_column)
+			stat = "  ===";
+		else
+			stat = " === ";
+		mvwaddstr(table->wg.win,y,x+1,stat);
+	}
+}
+
+/**
+  * @brief    设置了聚合时刷新页脚，调用时表格已加锁
+  * @note     只影响行数信息的改变不单独刷新页脚，聚合值需随之更新
+*/
+static void table_refresh_aggs(struct table *table)
+{
+	if (table->wg.win && table->aggs && table->aggs->count &&
+		table->show_footer && table->wg.width > 24) {
+		desktop_lock();
+		table_footer(table);
+		if (!table->wg.hidden)
+			desktop_refresh();
+		desktop_unlock();
+	}
+}
+
+/**
+  * @brief    刷新显示一个表格
+  * @param    table : 目标表格
+  * @param    refresh_title : 是否刷新标题栏
+  * @return   0
+*/
+static int table_refresh_raw(struct table *table,int refresh_title)
+{
+	int display,height,lines,cols,y;
+	long attr;
+	char **values;
+	struct table_item *item ;
+
+	if (!table->wg.win) { /* 未放置的控件 */
+		return -1;
+	}
+
+	if ( (cols = table->visible_cols) < 0) {
+		return 0;
+	}
+
+	if (refresh_title && table->show_title){
+		table_column_title(table,false);
+	}
+
+	lines = table_filtering(table) ? table->filter : table->lines;
+
+	/* 当前表格被聚焦时的显示状态 */
+	attr = &table->wg.editing ? A_FOCUS : A_UNFOCUS;
+
+	height = table->wg.height - table->show_border;
+	display = table->start_line;
+	item = NULL;
+	if (lines < 1) {
+		/* 空表格或无检出行，只清空窗口 */
+	} else if (table_is_virtual(table)) {
+		/* 虚拟表格先向数据源请求可视行，再进行绘制 */
+		table_virtual_load(table,display,height);
+	} else if (NULL == (item = table_item_at(table,display))) {
+		return 0;
+	}
+
+	desktop_lock();
+	werase(table->window);
+	for (y = 0; y < height && display < lines; y++) {
+		if (item) {
+			table_draw_item(table,y,item,display == table->current_line ? attr : 0);
+		} else if (NULL != (values = table_virtual_row(table,display))) {
+			table_draw_row(table,y,values,display == table->current_line ? attr : 0);
+		} else {
+			break;
+		}
+
+		display++;
+		if (item && NULL == (item = table_item_next(table,item))) {
+			break;
+		}
+	}
+
+	/* 页脚显示行数信息 */
+	if (table->show_footer && table->wg.width > 24) {
+		table_footer(table);
+	}
+ 
+	desktop_refresh();
+	desktop_unlock();
+
+	if (table_is_virtual(table)) {
+		table_virtual_prefetch(table,height);
+	}
+
+	table_scrollbar_update(table);
+	return 0;
+}
+
+
+/**
+  * @brief    绘制当前视图中的第 line 行，不在可视区域内时忽略，调用前需 desktop_lock()
+  * @param    table : 目标表格
+  * @param    line : 指定行
+  * @param    attr : 显示格式，为 0 时正常显示
+*/
+static void table_draw_line(struct table *table,int line,long attr)
+{
+	struct table_item *item;
+	char **values;
+	int y = line - table->start_line;
+
+	if (line < 0 || y < 0 || y >= table->wg.height - table->show_border - table->show_title) {
+		return;
+	}
+
+	if (table_is_virtual(table)) {
+		if (NULL != (values = table_virtual_row(table,line)))
+			table_draw_row(table,y,values,attr);
+	} else if (NULL != (item = table_item_at(table,line))) {
+		table_draw_item(table,y,item,attr);
+	}
+}
+
+
+/**
+  * @brief    选中行移动一行，必要时可视区域滚动一行，只重绘改变的行，调用时表格已加锁
+  * @param    table : 目标表格
+  * @param    selected : 新的选中行
+*/
+static void table_move_line(struct table *table,int selected)
+{
+	int last = table->current_line,scroll = 0,height;
+	long attr = table->wg.editing ? A_FOCUS : A_UNFOCUS;
+	WINDOW *win = table->window;
+
+	height = table->wg.height - table->show_border - table->show_title;
+	if (selected < table->start_line)
+		scroll = selected - table->start_line;
+	else if (selected >= table->start_line + height)
+		scroll = selected - (table->start_line + height - 1);
+	table->current_line = selected;
+	table->start_line += scroll;
+
+	if (!win || !table->visible_cols) {
+		return;
+	}
+	if (scroll > 1 || scroll < -1) {
+		table_refresh_raw(table,false);
+		return;
+	}
+
+	/* 虚拟表格先向数据源请求，不在 desktop_lock() 期间等待数据源 */
+	if (table_is_virtual(table)) {
+		table_virtual_load(table,selected,1);
+		table_virtual_load(table,last,1);
+	}
+
+	desktop_lock();
+	if (scroll) {
+		/* 可视行整体滚动一行，ncurses 会以终端的滚动区域完成，只需绘制新露出的一行 */
+		scrollok(win,TRUE);
+		wscrl(win,scroll);
+		scrollok(win,FALSE);
+	}
+	table_draw_line(table,last,0);
+	table_draw_line(table,selected,attr);
+	if (table->show_footer && table->wg.width > 24) {
+		table_footer(table);
+	}
+	desktop_refresh();
+	desktop_unlock();
+
+	if (table_is_virtual(table)) {
+		table_virtual_prefetch(table,height);
+	}
+	table_scrollbar_update(table);
+}
+
+
+/**
+  * @brief    表格上箭头按键的默认响应函数
+  * @param    self     : 目标表格所在的 wg 控件句柄
+  * @param    shortcut : 键盘键值
+*/
+static wg_state_t table_line_up(struct nwidget *self,long shortcut)
+{
+	struct table *table = container_of(self, struct table,wg);
+	if (table->current_line < 1)
+		return WG_OK;
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	table_move_line(table,table->current_line - 1);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	if (table->sig.changed)
+		table->sig.changed(table,table->sig.changed_arg);
+	return WG_OK;
+}
+
+/**
+  * @brief    表格下箭头按键的默认响应函数
+  * @param    self     : 目标表格所在的 wg 控件句柄
+  * @param    shortcut : 键盘键值
+*/
+static wg_state_t table_line_down(struct nwidget *self,long shortcut)
+{
+	int lines;
+	struct table *table = container_of(self, struct table,wg);
+
+	lines = table_filtering(table) ? table->filter : table->lines;
+	if (table->current_line >= lines-1){
+		return WG_OK;
+	}
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	table_move_line(table,table->current_line + 1);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	if (table->sig.changed)
+		table->sig.changed(table,table->sig.changed_arg);
+	return WG_OK;
+}
+
+
+/**
+  * @brief    表格 page up ，左箭头的默认响应函数
+  * @param    self : 目标表格所在的 wg 控件句柄
+  * @param    shortcut : 键盘键值
+*/
+static wg_state_t table_page_up(struct nwidget *self,long shortcut)
+{
+	int start_display_at,height;
+	struct table *table = container_of(self, struct table,wg);
+	start_display_at = table->start_line;
+	if (start_display_at < 1){
+		return WG_OK;
+	}
+	
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	height = table->wg.height - table->show_border - table->show_title ;
+	start_display_at -= (height - 1);
+	if (start_display_at < 0)
+		start_display_at = 0;
+	table->current_line = start_display_at;
+	table->start_line = start_display_at;
+	table_refresh_raw(table,false);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	if (table->sig.changed)
+		table->sig.changed(table,table->sig.changed_arg);
+	return WG_OK;
+}
+
+/**
+  * @brief    表格 page down 、右箭头的默认响应函数
+  * @param    self     : 目标表格所在的 wg 控件句柄
+  * @param    shortcut : 键盘键值
+*/
+static wg_state_t table_page_down(struct nwidget *self,long shortcut)
+{
+	int start_display_at,height,lines;
+	struct table *table = container_of(self, struct table,wg);
+	lines = table_filtering(table) ? table->filter : table->lines;
+	start_display_at = table->start_line;
+	height = table->wg.height - table->show_border - table->show_title ;
+	if (start_display_at >= lines - height) {
+		return WG_OK;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	start_display_at += (height-1);
+	if (start_display_at + height > lines)
+		start_display_at = lines - height;
+	table->current_line = start_display_at;
+	table->start_line = start_display_at;
+	table_refresh_raw(table,false);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	if (table->sig.changed)
+		table->sig.changed(table,table->sig.changed_arg);
+	return WG_OK;
+}
+
+
+/**
+  * @brief    表格 end 键的默认响应函数
+  * @param    self     : 目标表格所在的 wg 控件句柄
+  * @param    shortcut : 键盘键值
+*/
+static wg_state_t table_line_end(struct nwidget *self,long shortcut)
+{
+	int start_display_at,height,lines;
+	struct table *table = container_of(self, struct table,wg);
+	lines = table_filtering(table) ? table->filter : table->lines;
+	height = table->wg.height - table->show_border - table->show_title ;
+	start_display_at = lines - height;
+	if (start_display_at < 0 || start_display_at == table->start_line) {
+		return WG_OK;
+	}
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	table->current_line = start_display_at;
+	table->start_line = start_display_at;
+	table_refresh_raw(table,false);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	if (table->sig.changed)
+		table->sig.changed(table,table->sig.changed_arg);
+	return WG_OK;
+}
+
+
+/**
+  * @brief    表格 home 键的默认响应函数
+  * @param    self     : 目标表格所在的 wg 控件句柄
+  * @param    shortcut : 键盘键值
+*/
+static wg_state_t table_line_home(struct nwidget *self,long shortcut)
+{
+	struct table *table = container_of(self, struct table,wg);
+	if (!table->current_line && !table->start_line) {
+		return WG_OK;
+	}
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	table->current_line = 0;
+	table->start_line = 0;
+	table_refresh_raw(table,false);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	if (table->sig.changed)
+		table->sig.changed(table,table->sig.changed_arg);
+	return WG_OK;
+}
+
+
+/**
+  * @brief    表格向右滑动展示右边未完全展示的列
+  * @param    table
+*/
+static wg_state_t table_column_move_right(struct table *table)
+{
+	if (table->has_next_column) {
+		NWIDGET_MUTEX_LOCK(table->mutex);
+		visible_column_cleanup(table);
+		visible_column_checkout(table,table->start_col+1);
+		table_refresh_raw(table,true);
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+	}
+	return WG_OK;
+}
+
+
+/**
+  * @brief    表格向左滑动展示左边未展示的列
+  * @param    table
+*/
+static wg_state_t table_column_move_left(struct table *table)
+{
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (table->has_prev_column) {
+		visible_column_cleanup(table);
+		visible_column_checkout(table,table->start_col-1);
+		table_refresh_raw(table,true);
+	}
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return WG_OK;
+}
+
+
+/**
+  * @brief 表格滑动展示未展示的列
+  * @param self : 目标表格所在的 wg 控件句柄
+  * @param key : 键盘键值
+*/
+static wg_state_t table_column_move(struct nwidget *self,long key)
+{
+	struct table *table = container_of(self,struct table,wg);
+	int move_right = (key == KEY_CTRL_RIGHT || key == '>');
+
+	/* 如果是按住鼠标拖动窗体，则移动方向需要做反处理 */
+	if (mouse.bstate)
+		move_right ^= 1;
+	if (move_right) 
+		table_column_move_right(table);
+	else
+		table_column_move_left(table);
+	return WG_OK;
+}
+
+
+/**
+  * @brief    表格被选中执行函数，' ','\n' 的执行函数
+  * @param    self   : 目标表格所在的 wg 控件句柄
+*/
+static wg_state_t table_selected(struct nwidget *self,long key)
+{
+	struct table *table = container_of(self, struct table,wg);
+	if (table->current_line > -1 && table->sig.selected)
+		table->sig.selected(table,table->sig.selected_arg);
+	return WG_OK;
+}
+
+
+/**
+  * @brief    对表格的当前选中行进行显示刷新
+  * @param    table : 目标表格
+  * @param    display_attr : 显示格式
+  * @return   0
+*/
+static int table_refresh_current_line(struct table *table,int display_attr)
+{
+	NWIDGET_MUTEX_LOCK(table->mutex);
+
+	/* 如果无选中行或无显示列 */
+	if (table->current_line < 0 || table->visible_cols < 1 || !table->window){
+		goto cleanup;
+	}
+
+	if (table_is_virtual(table)) {
+		table_virtual_load(table,table->current_line,1);
+	}
+
+	desktop_lock();
+	table_draw_line(table,table->current_line,display_attr);
+	desktop_refresh();
+	desktop_unlock();
+cleanup:
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return 0;
+}
+
+/**
+  * @brief    表格控件聚焦时的回调
+  * @param    self : 目标表格所在的 wg 控件句柄
+*/
+static int table_focus(struct nwidget *self)
+{
+	struct table *table = container_of(self, struct table,wg);
+	table_refresh_current_line(table,A_FOCUS);
+	/*if (table->show_title && table->wg.bkg){
+		int color,y,x,len;
+		y = x = table->show_border ? 1 : 0;
+		len = table->wg.width - x * 2;
+		if (table->wg.bkg == wgtheme.desktop_bkg )
+			color = wgtheme.desktop_fg;
+		else 
+			color = wgtheme.form_fg;
+		wattron(table->wg.win,color);
+		mvwhline(table->wg.win,y+1,x,table->ts,len);
+		wattroff(table->wg.win,color);
+	}*/
+	return WG_OK;
+}
+
+
+/**
+  * @brief    表格控件失焦时的回调
+  * @param    self : 目标表格所在的 wg 控件句柄
+*/
+static int table_blur(struct nwidget *self)
+{
+	struct table *table = container_of(self, struct table,wg);
+	table_refresh_current_line(table,A_UNFOCUS);
+	/*if (table->show_title && table->wg.bkg){
+		int y,x,len;
+		y = x = table->show_border ? 1 : 0;
+		len = table->wg.width - table->show_border;
+		mvwhline(table->wg.win,y+1,x,table->ts,len);
+	}*/
+	return WG_OK;
+}
+
+
+/**
+  * @brief    表格鼠标被按下时执行的回调函数，一般仅进行反显
+  * @param    self   : 目标表格所在的 wg 控件句柄
+  * @return   WG_OK
+*/
+static wg_state_t table_mousedown(struct nwidget *self)
+{
+	int selected,last,lines,min;
+	struct table *table = container_of(self, struct table,wg);
+	last = table->current_line;
+	lines = table_filtering(table) ? table->filter : table->lines;
+	if (mouse.bstate & BUTTON1_RELEASED){
+		return WG_OK;
+	}
+
+	min = table->show_title + (table->show_border != 0);
+	selected = mouse.y - self->rely ;
+	if (selected < min) {
+		return WG_OK;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	selected -= table->show_border != 0;
+	selected -= table->show_title;
+	selected += table->start_line;
+	if (selected >= lines) {
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		return WG_OK;
+	}
+
+	table->current_line = selected;
+	if (last != selected)
+		table_refresh_raw(table,false);
+
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+
+	if (table->sig.clicked) 
+		table->sig.clicked(table,table->sig.clicked_arg);
+	
+	if (last != selected && table->sig.changed)
+		table->sig.changed(table,table->sig.changed_arg); 
+	
+	/*else if (table->sig.selected){
+		table->sig.selected(table,table->sig.selected_arg);
+	}*/
+	if ((mouse.bstate & BUTTON1_DOUBLE_CLICKED) && table->sig.selected)
+		table->sig.selected(table,table->sig.selected_arg);
+	return WG_OK;
+}
+
+
+/**
+  * @brief    释放条件过滤程序
+*/
+static void table_where_free(struct table_where *where)
+{
+	if (!where) {
+		return;
+	}
+	for (int i = 0; i < where->count; i++) {
+		free(where->code[i].values);
+		free(where->code[i].codes);
+	}
+	free(where->code);
+	free(where->text);
+	free(where);
+}
+
+
+/**
+  * @brief    读取条件表达式的下一个记号至 parser->token
+  * @note     单词和字符串复制至 parser->pool，字符串去掉引号并处理 \ 转义；
+  *           记号为比较方式、'(' ')' ',' '!' '&' '|'，单词为 'w'，字符串为 's'，
+  *           表达式结束为 0，出错为 -1
+*/
+static void table_where_next(struct table_where_parser *parser)
+{
+	const char *s = parser->pos;
+	char quote;
+
+	while (*s == ' ' || *s == '\t')
+		s++;
+	parser->word = NULL;
+	switch (*s) {
+	case '\0':
+		parser->token = 0;
+		break;
+	case '(': case ')': case ',':
+		parser->token = *s++;
+		break;
+	case '&': case '|':
+		parser->token = s[1] == s[0] ? *s : -1;
+		s += s[1] == s[0] ? 2 : 1;
+		break;
+	case '=':
+		parser->token = TABLE_PRED_EQ;
+		s += 1 + (s[1] == '=');
+		break;
+	case '!':
+		parser->token = s[1] == '=' ? TABLE_PRED_NE : '!';
+		s += 1 + (s[1] == '=');
+		break;
+	case '<':
+		parser->token = s[1] == '=' ? TABLE_PRED_LE : TABLE_PRED_LT;
+		s += 1 + (s[1] == '=');
+		break;
+	case '>':
+		parser->token = s[1] == '=' ? TABLE_PRED_GE : TABLE_PRED_GT;
+		s += 1 + (s[1] == '=');
+		break;
+	case '"': case '\'':
+		quote = *s++;
+		parser->word = parser->pool;
+		while (*s && *s != quote) {
+			if (*s == '\\' && s[1])
+				s++;
+			*parser->pool++ = *s++;
+		}
+		*parser->pool++ = '\0';
+		parser->token = *s ? 's' : -1;
+		s += *s != '\0';
+		break;
+	default:
+		parser->word = parser->pool;
+		while (*s && !strchr(" \t()<>=!,&|\"'",*s))
+			*parser->pool++ = *s++;
+		*parser->pool++ = '\0';
+		parser->token = 'w';
+		break;
+	}
+	parser->pos = s;
+}
+
+
+/**
+  * @brief    向程序追加一条指令
+  * @param    op : @see enum table_pred_op
+  * @return   成功返回指令，内存不足或求值栈过深返回 NULL
+*/
+static struct table_pred *table_where_emit(struct table_where_parser *parser,int op)
+{
+	struct table_where *where = parser->where;
+	struct table_pred *code;
+
+	/* 叶子压栈，与/或弹出两个压入一个，非不改变栈深 */
+	parser->depth += op <= TABLE_PRED_IN ? 1 : op == TABLE_PRED_NOT ? 0 : -1;
+	if (parser->depth > TABLE_WHERE_STACK) {
+		return NULL;
+	}
+	if (where->count == where->size) {
+		int size = where->size * 2 + 8;
+		if (NULL == (code = realloc(where->code,sizeof(struct table_pred) * size)))
+			return NULL;
+		where->code = code;
+		where->size = size;
+	}
+	code = &where->code[where->count++];
+	memset(code,0,sizeof(struct table_pred));
+	code->op = op;
+	return code;
+}
+
+
+/**
+  * @brief    按列名或 $列序号 查找列
+  * @return   列序号，不存在返回 -1
+*/
+static int table_where_column(struct table *table,const char *name)
+{
+	struct table_column *column;
+	struct wg_list *node;
+	char *end;
+	long col;
+
+	if (name[0] == '$') {
+		col = strtol(name + 1,&end,10);
+		return end == name + 1 || *end || col < 0 || col >= table->cols ? -1 : (int)col;
+	}
+	for (node = table->column.next; node != &table->column; node = node->next) {
+		column = container_of(node,struct table_column,node);
+		if (!strcmp(column->title,name))
+			return column->index;
+	}
+	return -1;
+}
+
+
+/**
+  * @brief    编译一个比较：列 比较方式 值，或 列 in (值,值...)
+  * @return   成功返回 0
+*/
+static int table_where_leaf(struct table_where_parser *parser)
+{
+	struct table_pred_value *values = NULL,*grow;
+	struct table_pred *pred;
+	int col,op,count = 0,numeric = 1;
+	char *end;
+
+	if (parser->token != 'w' || (col = table_where_column(parser->table,parser->word)) < 0) {
+		return -1;
+	}
+	table_where_next(parser);
+	if (parser->token >= TABLE_PRED_EQ && parser->token <= TABLE_PRED_GE) {
+		op = parser->token;
+		table_where_next(parser);
+	} else if (parser->token == 'w' && !strcmp(parser->word,"in")) {
+		op = TABLE_PRED_IN;
+		table_where_next(parser);
+		if (parser->token != '(')
+			return -1;
+		table_where_next(parser);
+	} else {
+		return -1;
+	}
+
+	/* 比较值，TABLE_PRED_IN 为以逗号分隔的多个值；未加引号的数值按数值比较 */
+	for (;;) {
+		if (parser->token != 'w' && parser->token != 's')
+			goto fail;
+		if (NULL == (grow = realloc(values,sizeof(struct table_pred_value) * (count + 1))))
+			goto fail;
+		values = grow;
+		values[count].str = parser->word;
+		values[count].num = strtod(parser->word,&end);
+		numeric = numeric && parser->token == 'w' && end != parser->word && !*end;
+		count++;
+		table_where_next(parser);
+		if (op != TABLE_PRED_IN)
+			break;
+		if (parser->token == ')') {
+			table_where_next(parser);
+			break;
+		}
+		if (parser->token != ',')
+			goto fail;
+		table_where_next(parser);
+	}
+
+	if (NULL == (pred = table_where_emit(parser,op))) {
+		goto fail;
+	}
+	pred->col = col;
+	pred->numeric = numeric;
+	pred->count = count;
+	pred->values = values;
+	return 0;
+fail:
+	free(values);
+	return -1;
+}
+
+
+static int table_where_or(struct table_where_parser *parser);
+
+
+/**
+  * @brief    编译 !条件、(条件) 或一个比较
+*/
+static int table_where_unary(struct table_where_parser *parser)
+{
+	int ret;
+
+	if (parser->token == '!') {
+		table_where_next(parser);
+		if (table_where_unary(parser) || !table_where_emit(parser,TABLE_PRED_NOT))
+			return -1;
+		return 0;
+	}
+	if (parser->token != '(') {
+		return table_where_leaf(parser);
+	}
+
+	if (++parser->nest > TABLE_WHERE_STACK * 4) {
+		return -1;
+	}
+	table_where_next(parser);
+	ret = table_where_or(parser);
+	if (ret || parser->token != ')') {
+		return -1;
+	}
+	parser->nest--;
+	table_where_next(parser);
+	return 0;
+}
+
+
+static int table_where_and(struct table_where_parser *parser)
+{
+	if (table_where_unary(parser)) {
+		return -1;
+	}
+	while (parser->token == '&') {
+		table_where_next(parser);
+		if (table_where_unary(parser) || !table_where_emit(parser,TABLE_PRED_AND))
+			return -1;
+	}
+	return 0;
+}
+
+
+static int table_where_or(struct table_where_parser *parser)
+{
+	if (table_where_and(parser)) {
+		return -1;
+	}
+	while (parser->token == '|') {
+		table_where_next(parser);
+		if (table_where_and(parser) || !table_where_emit(parser,TABLE_PRED_OR))
+			return -1;
+	}
+	return 0;
+}
+
+
+/**
+  * @brief    将条件表达式编译为后缀形式的求值程序，调用时表格已加锁
+  * @return   成功返回程序，表达式有误或内存不足返回 NULL
+*/
+static struct table_where *table_where_compile(struct table *table,const char *expr)
+{
+	struct table_where_parser parser;
+	struct table_where *where;
+
+	if (NULL == (where = calloc(1,sizeof(struct table_where)))) {
+		return NULL;
+	}
+	/* 每个单词至多多占一个结尾的 '\0' */
+	if (NULL == (where->text = malloc(strlen(expr) * 2 + 2))) {
+		table_where_free(where);
+		return NULL;
+	}
+
+	memset(&parser,0,sizeof(parser));
+	parser.table = table;
+	parser.where = where;
+	parser.pos = expr;
+	parser.pool = where->text;
+	table_where_next(&parser);
+	if (table_where_or(&parser) || parser.token != 0) {
+		table_where_free(where);
+		return NULL;
+	}
+	return where;
+}
+
+
+/**
+  * @brief    按数值比较
+*/
+static int table_pred_num(const struct table_pred *pred,double value)
+{
+	const struct table_pred_value *v = pred->values;
+
+	switch (pred->op) {
+	case TABLE_PRED_NE:
+		return value != v->num;
+	case TABLE_PRED_LT:
+		return value < v->num;
+	case TABLE_PRED_LE:
+		return value <= v->num;
+	case TABLE_PRED_GT:
+		return value > v->num;
+	case TABLE_PRED_GE:
+		return value >= v->num;
+	default:
+		for (int i = 0; i < pred->count; i++) {
+			if (value == v[i].num)
+				return 1;
+		}
+		return 0;
+	}
+}
+
+
+/**
+  * @brief    按单元格的显示内容比较，数值比较时按内容开头的数值比较
+*/
+static int table_pred_text(const struct table_pred *pred,const char *text)
+{
+	const struct table_pred_value *v = pred->values;
+	char *end;
+	double value;
+	int cmp;
+
+	if (pred->numeric) {
+		value = strtod(text,&end);
+		return end != text ? table_pred_num(pred,value) : pred->op == TABLE_PRED_NE;
+	}
+	if (pred->op == TABLE_PRED_EQ || pred->op == TABLE_PRED_IN) {
+		for (int i = 0; i < pred->count; i++) {
+			if (!strcmp(text,v[i].str))
+				return 1;
+		}
+		return 0;
+	}
+
+	cmp = strcmp(text,v->str);
+	switch (pred->op) {
+	case TABLE_PRED_NE:
+		return cmp != 0;
+	case TABLE_PRED_LT:
+		return cmp < 0;
+	case TABLE_PRED_LE:
+		return cmp <= 0;
+	case TABLE_PRED_GT:
+		return cmp > 0;
+	default:
+		return cmp >= 0;
+	}
+}
+
+
+/**
+  * @brief    预先算出字典列各字符串的比较结果，每个不同的字符串只比较一次
+  * @note     在 table_where_eval() 之前调用，调用时表格已加锁；
+  *           内存不足时 known 不增长，求值时逐行比较其余的行
+*/
+static void table_where_prepare(struct table *table)
+{
+	struct table_dict *dict;
+	struct table_type *type;
+	struct table_pred *pred;
+	unsigned char *codes;
+
+	for (int i = 0; table->where && i < table->where->count; i++) {
+		pred = &table->where->code[i];
+		if (pred->op > TABLE_PRED_IN || !(type = table_col_type(table,pred->col)) || !(dict = type->dict))
+			continue;
+		if (pred->resets != dict->resets) {
+			/* 字典被清空过，编码已失效 */
+			pred->resets = dict->resets;
+			pred->known = 0;
+		}
+		if (pred->known == dict->count || NULL == (codes = realloc(pred->codes,dict->size)))
+			continue;
+		pred->codes = codes;
+		for ( ; pred->known < dict->count; pred->known++)
+			codes[pred->known] = table_pred_text(pred,dict->words[pred->known]);
+	}
+}
+
+
+/**
+  * @brief    对一批行求一个比较的值，每批只按列类型分派一次
+*/
+static void table_pred_eval(struct table *table,const struct table_pred *pred,
+	struct table_item **items,int n,unsigned char *out)
+{
+	struct table_type *type = table_col_type(table,pred->col);
+	long long code;
+	char buf[256];
+
+	if (type && !type->dict && pred->numeric) {
+		/* 类型列直接比较原始值 */
+		if (type->type == TABLE_COL_DOUBLE) {
+			for (int i = 0; i < n; i++)
+				out[i] = table_pred_num(pred,type->data[items[i]->slot].f);
+		} else {
+			for (int i = 0; i < n; i++)
+				out[i] = table_pred_num(pred,(double)type->data[items[i]->slot].i);
+		}
+	} else if (type && type->dict) {
+		/* 字典列查 table_where_prepare() 的结果 */
+		for (int i = 0; i < n; i++) {
+			code = type->data[items[i]->slot].i;
+			out[i] = code >= 0 && code < pred->known ? pred->codes[code] :
+				table_pred_text(pred,table_dict_word(type,items[i]->slot));
+		}
+	} else {
+		for (int i = 0; i < n; i++)
+			out[i] = table_pred_text(pred,table_cell_text(table,items[i],pred->col,buf,sizeof(buf)));
+	}
+}
+
+
+/**
+  * @brief    按条件过滤程序对一批行求值
+  * @param    table : 目标表格，table->where 不为 NULL
+  * @param    items : 各行
+  * @param    count : 行数
+  * @param    match : 输出各行是否满足条件
+  * @note     每 TABLE_WHERE_BATCH 行执行一遍程序，每条指令处理整批行
+*/
+static void table_where_eval(struct table *table,struct table_item **items,int count,unsigned char *match)
+{
+	unsigned char stack[TABLE_WHERE_STACK][TABLE_WHERE_BATCH];
+	const struct table_where *where = table->where;
+	const struct table_pred *pred;
+	int n,sp;
+
+	for (int base = 0; base < count; base += TABLE_WHERE_BATCH) {
+		n = count - base < TABLE_WHERE_BATCH ? count - base : TABLE_WHERE_BATCH;
+		sp = 0;
+		for (int pc = 0; pc < where->count; pc++) {
+			pred = &where->code[pc];
+			switch (pred->op) {
+			case TABLE_PRED_AND:
+				sp--;
+				for (int i = 0; i < n; i++)
+					stack[sp-1][i] &= stack[sp][i];
+				break;
+			case TABLE_PRED_OR:
+				sp--;
+				for (int i = 0; i < n; i++)
+					stack[sp-1][i] |= stack[sp][i];
+				break;
+			case TABLE_PRED_NOT:
+				for (int i = 0; i < n; i++)
+					stack[sp-1][i] ^= 1;
+				break;
+			default:
+				table_pred_eval(table,pred,items + base,n,stack[sp++]);
+				break;
+			}
+		}
+		memcpy(match + base,stack[0],n);
+	}
+}
+
+
+/**
+  * @brief    判断一行是否包含关键词
+  * @param    table : 目标表格
+  * @param    item : 指定行
+  * @param    keyword : 关键词
+  * @param    len : 关键词长度，为 0 时均检出
+  * @return   任意一列包含关键词返回 1
+*/
+static int table_item_search(struct table *table,struct table_item *item,const char *keyword,size_t len)
+{
+	struct table_type *type;
+	const char *value;
+	char buf[256];
+	long long code;
+	if (!len) {
+		return 1;
+	}
+	for (int i = 0; i < table->cols; i++) {
+		/* 字典列直接查 table_dict_match() 的结果 */
+		type = table_col_type(table,i);
+		if (type && type->dict && (code = type->data[item->slot].i) >= 0 && code < type->dict->matched) {
+			if (type->dict->match[code])
+				return 1;
+			continue;
+		}
+		value = table_cell_text(table,item,i,buf,sizeof(buf));
+		if (wg_memmem(value,strlen(value),keyword,len))
+			return 1;
+		if (!table_col_search(table,i))
+			continue;
+
+		/* 检索索引列再以小写关键词查找原内容和检索键 @see table_search_prepare() */
+		if (table->search->fold && wg_memmem(value,strlen(value),table->search->keyword,len))
+			return 1;
+		value = table_cell_key(item,i);
+		if (*value && wg_memmem(value,strlen(value),table->search->keyword,len))
+			return 1;
+	}
+	return 0;
+}
+
+
+/**
+  * @brief    判断一行是否被过滤视图检出：满足过滤条件且包含关键词
+  * @note     调用前需 table_match_prepare()
+*/
+static int table_item_match(struct table *table,struct table_item *item,const char *keyword,size_t len)
+{
+	unsigned char match = 1;
+	if (table->where)
+		table_where_eval(table,&item,1,&match);
+	return match && table_item_search(table,item,keyword,len);
+}
+
+
+/**
+  * @brief    检索之前将关键词转为小写，供检索索引列匹配检索键
+  * @note     检索键中的拉丁字母均为小写，过长的关键词截断为 search->keyword 的长度
+*/
+static void table_search_prepare(struct table *table,const char *keyword,size_t len)
+{
+	struct table_search *search = table->search;
+	char c;
+
+	if (!search || !search->count) {
+		return;
+	}
+	if (len >= sizeof(search->keyword)) {
+		len = sizeof(search->keyword) - 1;
+	}
+	search->fold = 0;
+	for (size_t i = 0; i < len; i++) {
+		c = keyword[i];
+		if (c >= 'A' && c <= 'Z') {
+			c = c - 'A' + 'a';
+			search->fold = 1;
+		}
+		search->keyword[i] = c;
+	}
+	search->keyword[len] = '\0';
+}
+
+
+/**
+  * @brief    检索之前预先处理各字典列和检索索引列，调用时表格已加锁
+*/
+static void table_match_prepare(struct table *table,const char *keyword,size_t len)
+{
+	if (len) {
+		table_dict_match(table,keyword,len);
+		table_search_prepare(table,keyword,len);
+	}
+	table_where_prepare(table);
+}
+
+
+/**
+  * @brief    检索线程的执行函数，先按批对过滤条件求值，再只对满足条件的行检索关键词
+*/
+static void table_match_range(void *arg,int start,int end)
+{
+	struct table_match_job *job = arg;
+	struct table *table = job->table;
+
+	if (table->where)
+		table_where_eval(table,&job->items[start],end - start,&job->match[start]);
+	for (int i = start; i < end; i++) {
+		if (!table->where || job->match[i])
+			job->match[i] = table_item_search(table,job->items[i],job->keyword,job->len);
+	}
+}
+
+
+/**
+  * @brief    释放第 depth 层及以上的过滤结果缓存
+  * @param    table : 目标表格
+  * @param    depth : 保留的缓存层数
+*/
+static void table_filter_drop(struct table *table,int depth)
+{
+	while (table->filter_depth > depth) {
+		free(table->filter_cache[--table->filter_depth]);
+		table->filter_cache[table->filter_depth] = NULL;
+	}
+}
+
+
+/**
+  * @brief    向一层过滤缓存追加一行
+  * @return   成功返回 0
+*/
+static int table_filter_push(struct table_filter_level **plevel,struct table_item *item)
+{
+	struct table_filter_level *level = *plevel;
+	if (level->count == level->size) {
+		int size = level->size * 2 + 64;
+		level = realloc(level,sizeof(struct table_filter_level) + sizeof(struct table_item *) * size);
+		if (!level) {
+			return -1;
+		}
+		level->size = size;
+		*plevel = level;
+	}
+	level->items[level->count++] = item;
+	return 0;
+}
+
+
+/**
+  * @brief    检索缓存生成之后新增的行，使缓存结果与表格同步
+  * @param    table : 目标表格
+  * @param    plevel : 过滤缓存，扩容时会被更新
+  * @return   成功返回 0
+*/
+static int table_filter_sync(struct table *table,struct table_filter_level **plevel)
+{
+	struct table_filter_level *level = *plevel;
+	struct table_item *item;
+	struct wg_list *node;
+	int append = table->lines - level->lines;
+	size_t len = strlen(level->keyword);
+
+	if (append < 1) {
+		return 0;
+	}
+
+	table_match_prepare(table,level->keyword,len);
+	/* 新增的行位于 items 末尾 */
+	for (node = &table->items; append--; node = node->prev);
+	for ( ; node != &table->items; node = node->next) {
+		item = container_of(node,struct table_item,node);
+		if (!table_item_match(table,item,level->keyword,len)) {
+			continue;
+		}
+		if (table_filter_push(plevel,item)) {
+			return -1;
+		}
+
+		/* 已排序的表格，新增行需按顺序插入 */
+		level = *plevel;
+		if (table_is_sorted(table)) {
+			int low = 0,high = level->count - 1,mid;
+			while (low < high) {
+				mid = (low + high) / 2;
+				if (table_items_cmp(table,item,level->items[mid]) < 0)
+					high = mid;
+				else
+					low = mid + 1;
+			}
+			memmove(&level->items[low+1],&level->items[low],
+				sizeof(struct table_item *) * (level->count - 1 - low));
+			level->items[low] = item;
+		}
+	}
+	(*plevel)->lines = table->lines;
+	return 0;
+}
+
+
+/**
+  * @brief    检索关键词，生成一层过滤缓存
+  * @param    table : 目标表格
+  * @param    keyword : 关键词
+  * @param    parent : 上一层缓存，其关键词为 keyword 的子串；为 NULL 时检索整个表格
+  * @return   成功返回缓存，否则返回 NULL
+*/
+static struct table_filter_level *table_filter_scan(struct table *table,
+	const char *keyword,struct table_filter_level *parent)
+{
+	struct table_filter_level *level;
+	struct table_match_job job;
+	struct wg_rank_node *node;
+	int count = 0,size = parent ? parent->count : table->lines;
+
+	level = malloc(sizeof(struct table_filter_level) + sizeof(struct table_item *) * size);
+	if (!level) {
+		return NULL;
+	}
+	strncpy(level->keyword,keyword,sizeof(level->keyword)-1);
+	level->keyword[sizeof(level->keyword)-1] = '\0';
+	level->lines = table->lines;
+	level->size = size;
+
+	/* 先按显示顺序列出候选行，关键词增长时结果只会是上一层结果的子集 */
+	if (parent) {
+		memcpy(level->items,parent->items,sizeof(struct table_item *) * size);
+	} else {
+		for (node = wg_rank_first(&table->index); node; node = wg_rank_next(node)) {
+			level->items[count++] = container_of(node,struct table_item,rank);
+		}
+	}
+
+	/* 候选行分段交由多个线程检索，再按原顺序合并结果 */
+	keyword = level->keyword;
+	table_match_prepare(table,keyword,strlen(keyword));
+	job.table = table;
+	job.items = level->items;
+	job.keyword = keyword;
+	job.len = strlen(keyword);
+	job.match = malloc(size + 1);
+	if (job.match) {
+		wg_parallel_for(size,TABLE_SCAN_CHUNK,table_match_range,&job);
+		for (int i = count = 0; i < size; i++) {
+			if (job.match[i])
+				level->items[count++] = level->items[i];
+		}
+		free(job.match);
+	} else {
+		for (int i = count = 0; i < size; i++) {
+			if (table_item_match(table,level->items[i],keyword,job.len))
+				level->items[count++] = level->items[i];
+		}
+	}
+	level->count = count;
+
+	/* 释放多余的空间，缓存会保留多层 */
+	if (level->count < level->size / 2) {
+		struct table_filter_level *shrink;
+		size = level->count;
+		shrink = realloc(level,sizeof(struct table_filter_level) + sizeof(struct table_item *) * size);
+		if (shrink) {
+			level = shrink;
+			level->size = size;
+		}
+	}
+	return level;
+}
+
+
+/**
+  * @brief    将过滤视图清空
+  * @param    table : 目标表格
+*/
+static void table_filter_unlink(struct table *table)
+{
+	struct table_item *item;
+	struct wg_list *node,*next;
+
+	for (node = table->filter_items.next; node != &table->filter_items; node = next) {
+		next = node->next;
+		item = container_of(node,struct table_item,filter);
+		wg_list_init(&item->filter);
+		item->filter_rank.size = 0;
+	}
+	wg_list_init(&table->filter_items);
+	wg_rank_init(&table->filter_index);
+	table_aggs_reset(table,TABLE_AGGS_VIEW);
+	table->filter = 0;
+}
+
+
+/**
+  * @brief    以过滤结果重建过滤视图 filter_items/filter_index
+  * @param    table : 目标表格
+  * @param    items : 按显示顺序排列的检出行
+  * @param    count : 检出行数
+*/
+static void table_filter_apply(struct table *table,struct table_item **items,int count)
+{
+	struct wg_rank_node **nodes;
+	struct table_item *item;
+
+	table_filter_unlink(table);
+	nodes = malloc(sizeof(struct wg_rank_node *) * (count + 1));
+	for (int i = 0; i < count; i++) {
+		item = items[i];
+		table_aggs_item(table,item,-1,1,TABLE_AGGS_VIEW);
+		wg_list_add_tail(&item->filter,&table->filter_items);
+		if (nodes)
+			nodes[i] = &item->filter_rank;
+		else
+			wg_rank_insert_at(&table->filter_index,&item->filter_rank,i);
+	}
+
+	if (nodes) {
+		wg_rank_build(&table->filter_index,nodes,count);
+		free(nodes);
+	}
+	table->filter = count;
+}
+
+
+/**
+  * @brief    过滤视图改变后保持选中行并刷新，调用时表格已加锁
+  * @param    table : 目标表格
+  * @param    current : 原选中行，可为 NULL
+*/
+static void table_filter_refresh(struct table *table,struct table_item *current)
+{
+	int lines,visible_height;
+
+	/* 尽量保持原选中行，否则选中第一行 */
+	lines = table_filtering(table) ? table->filter : table->lines;
+	if (table->current_line > -1) {
+		table->current_line = current ? table_item_line(table,current) : -1;
+		if (table->current_line < 0)
+			table->current_line = lines ? 0 : -1;
+	}
+
+	visible_height = table->wg.height - table->show_border - table->show_title;
+	table->start_line = table->current_line < 0 ? 0 : table->current_line;
+	if (table->start_line + visible_height > lines)
+		table->start_line = lines > visible_height ? lines - visible_height : 0;
+
+	table_refresh_raw(table,false);
+}
+
+
+/**
+  * @brief    模糊匹配时字符的类别，UTF-8 多字节字符按小写字母处理
+*/
+static inline int table_fuzzy_class(unsigned char c)
+{
+	if (c >= 'a' && c <= 'z')
+		return TABLE_FUZZY_LOWER;
+	if (c >= 'A' && c <= 'Z')
+		return TABLE_FUZZY_UPPER;
+	if (c >= '0' && c <= '9')
+		return TABLE_FUZZY_DIGIT;
+	return c >= 0x80 ? TABLE_FUZZY_LOWER : TABLE_FUZZY_NONWORD;
+}
+
+
+/**
+  * @brief    匹配字符的位置加分：单词开头和分隔符，其次为驼峰和数字开头
+  * @param    prev : 前一个字符的类别
+  * @param    cur : 匹配字符的类别
+*/
+static inline int table_fuzzy_bonus(int prev,int cur)
+{
+	if (cur == TABLE_FUZZY_NONWORD || prev == TABLE_FUZZY_NONWORD)
+		return TABLE_FUZZY_BOUNDARY;
+	if ((prev == TABLE_FUZZY_LOWER && cur == TABLE_FUZZY_UPPER) ||
+		(prev != TABLE_FUZZY_DIGIT && cur == TABLE_FUZZY_DIGIT))
+		return TABLE_FUZZY_CAMEL;
+	return 0;
+}
+
+
+static inline unsigned char table_fuzzy_fold(unsigned char c,int exact)
+{
+	return (!exact && c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+
+/**
+  * @brief    按 fzf 的方式对一行文本计分
+  * @param    text : 行文本
+  * @param    len : 文本长度
+  * @param    pattern : 匹配串
+  * @param    plen : 匹配串长度
+  * @param    exact : 区分大小写，否则文本中的大写字母按小写比较
+  * @note     先正向找到匹配串各字符依次出现的位置，再自末尾反向收缩出最短的匹配区间，
+  *           只对该区间计分：每个匹配字符得分并按位置加分，首字符的加分加倍，
+  *           连续匹配沿用首个字符的加分，区间内未匹配的字符扣分
+  * @return   不匹配返回 -1，否则返回得分，得分相同时文本较短的返回值较大
+*/
+static int table_fuzzy_score(const char *text,int len,const char *pattern,int plen,int exact)
+{
+	const unsigned char *s = (const unsigned char *)text;
+	const unsigned char *p = (const unsigned char *)pattern;
+	int start,end,pidx = 0,score = 0,gap = 0,consecutive = 0,first = 0,prev,cur,bonus;
+
+	for (end = 0; end < len && pidx < plen; end++) {
+		if (table_fuzzy_fold(s[end],exact) == p[pidx])
+			pidx++;
+	}
+	if (pidx < plen) {
+		return -1;
+	}
+	for (start = end - 1,pidx = plen - 1; ; start--) {
+		if (table_fuzzy_fold(s[start],exact) == p[pidx] && --pidx < 0)
+			break;
+	}
+
+	prev = start > 0 ? table_fuzzy_class(s[start-1]) : TABLE_FUZZY_NONWORD;
+	for (pidx = 0; start < end; start++) {
+		cur = table_fuzzy_class(s[start]);
+		if (pidx < plen && table_fuzzy_fold(s[start],exact) == p[pidx]) {
+			bonus = table_fuzzy_bonus(prev,cur);
+			if (!consecutive) {
+				first = bonus;
+			} else {
+				if (bonus >= TABLE_FUZZY_BOUNDARY && bonus > first)
+					first = bonus;
+				if (bonus < first)
+					bonus = first;
+				if (bonus < TABLE_FUZZY_CONSECUTIVE)
+					bonus = TABLE_FUZZY_CONSECUTIVE;
+			}
+			score += TABLE_FUZZY_MATCH + (pidx ? bonus : bonus * 2);
+			gap = 0;
+			consecutive++;
+			pidx++;
+		} else {
+			score -= gap ? TABLE_FUZZY_GAP_EXTENSION : TABLE_FUZZY_GAP_START;
+			gap = 1;
+			consecutive = 0;
+		}
+		prev = cur;
+	}
+
+	/* 得分相同时文本较短的优先 */
+	if (len > TABLE_FUZZY_TEXT - 1)
+		len = TABLE_FUZZY_TEXT - 1;
+	return (score > 0 ? score : 0) * TABLE_FUZZY_TEXT + TABLE_FUZZY_TEXT - 1 - len;
+}
+
+
+/**
+  * @brief    一行参与模糊匹配的文本，各列以 '\t' 连接，类型列为格式化后的内容
+  * @note     检索索引列的检索键接在各列之后，以便按拼音匹配
+  * @return   文本长度，不超过 size - 1
+*/
+static int table_fuzzy_text(struct table *table,struct table_item *item,char *buf,int size)
+{
+	const char *value;
+	char cell[256];
+	int len = 0,n;
+
+	for (int i = 0; i < table->cols * 2 && len < size - 1; i++) {
+		if (i < table->cols)
+			value = table_cell_text(table,item,i,cell,sizeof(cell));
+		else if (table_col_search(table,i - table->cols))
+			value = table_cell_key(item,i - table->cols);
+		else
+			continue;
+		if (!*value && i >= table->cols)
+			continue;
+		if (i)
+			buf[len++] = '\t';
+		n = strlen(value);
+		if (n > size - 1 - len)
+			n = size - 1 - len;
+		memcpy(buf + len,value,n);
+		len += n;
+	}
+	buf[len] = '\0';
+	return len;
+}
+
+
+/**
+  * @brief    在表格加锁时对一行计分，调用前需 table_match_prepare()
+  * @return   不满足关键词和条件过滤或不匹配时返回 -1，否则返回得分
+*/
+static int table_fuzzy_item_score(struct table *table,struct table_item *item)
+{
+	struct table_fuzzy *fuzzy = table->fuzzy;
+	char buf[TABLE_FUZZY_TEXT];
+	int len;
+
+	if (!table_item_match(table,item,table->keyword,strlen(table->keyword))) {
+		return -1;
+	}
+	len = table_fuzzy_text(table,item,buf,sizeof(buf));
+	return table_fuzzy_score(buf,len,fuzzy->pattern,fuzzy->plen,fuzzy->exact);
+}
+
+
+static inline int table_fuzzy_worse(const struct table_fuzzy_hit *a,const struct table_fuzzy_hit *b)
+{
+	return a->score < b->score || (a->score == b->score && a->index > b->index);
+}
+
+
+/**
+  * @brief    以 hit 替换堆顶并下沉
+  * @param    heap : 小顶堆，堆顶为最差的候选
+  * @param    count : 堆中的候选数
+*/
+static void table_fuzzy_sift(struct table_fuzzy_hit *heap,int count,struct table_fuzzy_hit hit)
+{
+	int i,child;
+	for (i = 0; (child = i * 2 + 1) < count; i = child) {
+		if (child + 1 < count && table_fuzzy_worse(&heap[child+1],&heap[child]))
+			child++;
+		if (!table_fuzzy_worse(&heap[child],&hit))
+			break;
+		heap[i] = heap[child];
+	}
+	heap[i] = hit;
+}
+
+
+/**
+  * @brief    向容量为 k 的候选堆加入一个候选，堆满时只替换比它差的堆顶
+*/
+static void table_fuzzy_push(struct table_fuzzy_hit *heap,int *count,int k,struct table_fuzzy_hit hit)
+{
+	int i;
+	if (*count < k) {
+		for (i = (*count)++; i > 0 && table_fuzzy_worse(&hit,&heap[(i-1)/2]); i = (i-1)/2)
+			heap[i] = heap[(i-1)/2];
+		heap[i] = hit;
+	} else if (k > 0 && table_fuzzy_worse(&heap[0],&hit)) {
+		table_fuzzy_sift(heap,k,hit);
+	}
+}
+
+
+/**
+  * @brief    计分线程的执行函数，对第 [start,end) 段计分，每段只保留前 slice_k 个候选
+*/
+static void table_fuzzy_range(void *arg,int start,int end)
+{
+	struct table_fuzzy_job *job = arg;
+	struct table_fuzzy_snap *snap = job->snap;
+	struct table_fuzzy_hit hit,*heap;
+	int last;
+
+	for (int s = start; s < end && !job->cancel; s++) {
+		heap = &job->hits[s * job->slice_k];
+		last = (s + 1) * TABLE_FUZZY_SLICE < snap->count ? (s + 1) * TABLE_FUZZY_SLICE : snap->count;
+		for (hit.index = s * TABLE_FUZZY_SLICE; hit.index < last; hit.index++) {
+			hit.score = table_fuzzy_score(snap->text + snap->offset[hit.index],
+				snap->offset[hit.index+1] - snap->offset[hit.index] - 1,job->pattern,job->plen,job->exact);
+			if (hit.score >= 0)
+				table_fuzzy_push(heap,&job->found[s],job->slice_k,hit);
+		}
+	}
+}
+
+
+/**
+  * @brief    对模糊匹配快照计分，合并各段的候选，结果存于 job->result
+  * @return   成功返回 0，被取消或内存不足返回 -1
+*/
+static int table_fuzzy_run(struct table_fuzzy_job *job)
+{
+	int slices = (job->snap->count + TABLE_FUZZY_SLICE - 1) / TABLE_FUZZY_SLICE;
+	int k = job->top_k < job->snap->count ? job->top_k : job->snap->count;
+	struct table_fuzzy_hit hit;
+
+	job->slice_k = k < TABLE_FUZZY_SLICE ? k : TABLE_FUZZY_SLICE;
+	job->found = calloc(slices + 1,sizeof(int));
+	job->hits = malloc(sizeof(struct table_fuzzy_hit) * ((size_t)slices * job->slice_k + 1));
+	job->result = malloc(sizeof(struct table_fuzzy_hit) * (k + 1));
+	if (!job->found || !job->hits || !job->result) {
+		return -1;
+	}
+
+	/* 各段在各自的堆中保留候选，无需对所有行排序 */
+	wg_parallel_for(slices,1,table_fuzzy_range,job);
+	if (job->cancel) {
+		return -1;
+	}
+	job->results = 0;
+	for (int s = 0; s < slices; s++) {
+		for (int i = 0; i < job->found[s]; i++)
+			table_fuzzy_push(job->result,&job->results,k,job->hits[s * job->slice_k + i]);
+	}
+
+	/* 依次将最差的堆顶移至末尾，得到从高到低的顺序 */
+	for (int n = job->results - 1; n > 0; n--) {
+		hit = job->result[n];
+		job->result[n] = job->result[0];
+		table_fuzzy_sift(job->result,n,hit);
+	}
+	return 0;
+}
+
+
+/**
+  * @brief    释放模糊匹配任务的计分结果
+*/
+static void table_fuzzy_job_clear(struct table_fuzzy_job *job)
+{
+	free(job->found);
+	free(job->hits);
+	free(job->result);
+	job->found = NULL;
+	job->hits = NULL;
+	job->result = NULL;
+}
+
+
+static void table_fuzzy_job_free(struct table_fuzzy_job *job)
+{
+	table_fuzzy_job_clear(job);
+	free(job);
+}
+
+
+/**
+  * @brief    释放对候选行快照的引用，调用时表格已加锁
+*/
+static void table_fuzzy_snap_put(struct table_fuzzy_snap *snap)
+{
+	if (snap && --snap->refs == 0) {
+		free(snap->items);
+		free(snap->offset);
+		free(snap->text);
+		free(snap);
+	}
+}
+
+
+/**
+  * @brief    过滤条件或显示顺序改变，丢弃候选行快照，调用时表格已加锁
+  * @note     进行中的检索仍持有其快照，所引用的行在检索结束后释放
+*/
+static void table_fuzzy_stale(struct table *table)
+{
+	struct table_fuzzy *fuzzy = table->fuzzy;
+
+	if (!fuzzy || !fuzzy->snap) {
+		return;
+	}
+	for (int i = 0; i < fuzzy->changed_count; i++)
+		fuzzy->changed[i]->flags &= ~TABLE_ITEM_CHANGED;
+	fuzzy->changed_count = 0;
+	table_fuzzy_snap_put(fuzzy->snap);
+	fuzzy->snap = NULL;
+	if (!fuzzy->busy && !table->sort_pending)
+		table_graveyard_free(table);
+}
+
+
+/**
+  * @brief    将一行的文本追加至候选行快照，调用时表格已加锁
+  * @return   成功返回 0，内存不足返回 -1
+*/
+static int table_fuzzy_snap_add(struct table *table,struct table_fuzzy_snap *snap,struct table_item *item)
+{
+	char buf[TABLE_FUZZY_TEXT],*text;
+	size_t used = snap->count ? snap->offset[snap->count] : 0;
+	struct table_item **items;
+	int *offset,len,size;
+
+	if (snap->count + 1 >= snap->size) {
+		size = snap->size ? snap->size * 2 : 64;
+		if (NULL == (items = realloc(snap->items,sizeof(struct table_item *) * size)))
+			return -1;
+		snap->items = items;
+		if (NULL == (offset = realloc(snap->offset,sizeof(int) * size)))
+			return -1;
+		snap->offset = offset;
+		snap->size = size;
+	}
+	len = table_fuzzy_text(table,item,buf,sizeof(buf));
+	if (used + len + 1 > snap->text_size) {
+		size = (used + len + 1) * 2;
+		if (NULL == (text = realloc(snap->text,size)))
+			return -1;
+		snap->text = text;
+		snap->text_size = size;
+	}
+	memcpy(snap->text + used,buf,len + 1);
+	snap->items[snap->count] = item;
+	snap->offset[snap->count++] = used;
+	snap->offset[snap->count] = used + len + 1;
+	return 0;
+}
+
+
+/**
+  * @brief    在表格加锁时生成候选行快照，候选行为满足关键词和条件过滤的行，复制其文本
+  * @param    table : 目标表格
+  * @return   成功返回快照
+*/
+static struct table_fuzzy_snap *table_fuzzy_snapshot(struct table *table)
+{
+	struct table_filter_level *level = NULL;
+	struct table_fuzzy_snap *snap;
+	struct wg_rank_node *node;
+
+	if (NULL == (snap = calloc(1,sizeof(struct table_fuzzy_snap)))) {
+		return NULL;
+	}
+	snap->refs = 1;
+	snap->seq = table->seq;
+	if ((table->keyword[0] || table->where) && NULL == (level = table_filter_scan(table,table->keyword,NULL))) {
+		goto fail;
+	}
+
+	if (level) {
+		for (int i = 0; i < level->count; i++) {
+			if (table_fuzzy_snap_add(table,snap,level->items[i]))
+				goto fail;
+		}
+	} else {
+		for (node = wg_rank_first(&table->index); node; node = wg_rank_next(node)) {
+			if (table_fuzzy_snap_add(table,snap,container_of(node,struct table_item,rank)))
+				goto fail;
+		}
+	}
+	free(level);
+	return snap;
+fail:
+	free(level);
+	table_fuzzy_snap_put(snap);
+	return NULL;
+}
+
+
+/**
+  * @brief    将快照之后新增的行追加至快照，调用时表格已加锁且快照未被检索引用
+  * @return   成功返回 0，内存不足返回 -1
+*/
+static int table_fuzzy_snap_append(struct table *table,struct table_fuzzy_snap *snap)
+{
+	struct table_item *item;
+	struct wg_list *node;
+
+	/* 快照之后新增的行位于 items 末尾 */
+	for (node = table->items.prev; node != &table->items; node = node->prev) {
+		if ((int)(container_of(node,struct table_item,node)->seq - snap->seq) < 0)
+			break;
+	}
+	table_match_prepare(table,table->keyword,strlen(table->keyword));
+	for (node = node->next; node != &table->items; node = node->next) {
+		item = container_of(node,struct table_item,node);
+		if (table_item_match(table,item,table->keyword,strlen(table->keyword)) && table_fuzzy_snap_add(table,snap,item))
+			return -1;
+	}
+	snap->seq = table->seq;
+	return 0;
+}
+
+
+/**
+  * @brief    快照中的一行被修改或删除，调用时表格已加锁
+  * @param    changed : 1 为修改，0 为删除
+  * @note     被修改的行在替换结果时按当前内容计分；失效的行过半时丢弃快照，下次检索时重建
+*/
+static void table_fuzzy_invalidate(struct table *table,struct table_item *item,int changed)
+{
+	struct table_fuzzy *fuzzy = table->fuzzy;
+	struct table_item **list;
+	int size;
+
+	if (!fuzzy || !fuzzy->snap || (item->flags & TABLE_ITEM_CHANGED) ||
+		(int)(item->seq - fuzzy->snap->seq) >= 0) {
+		/* 已计入，或不在快照中 */
+		return;
+	}
+	if (!changed && (table->keyword[0] || table->where)) {
+		/* 未修改的行是否在快照中，与生成快照时一致 */
+		table_match_prepare(table,table->keyword,strlen(table->keyword));
+		if (!table_item_match(table,item,table->keyword,strlen(table->keyword)))
+			return;
+	}
+	if (changed && fuzzy->changed_count == fuzzy->changed_size) {
+		size = fuzzy->changed_size ? fuzzy->changed_size * 2 : 64;
+		if (NULL == (list = realloc(fuzzy->changed,sizeof(struct table_item *) * size))) {
+			table_fuzzy_stale(table);
+			return;
+		}
+		fuzzy->changed = list;
+		fuzzy->changed_size = size;
+	}
+	if (changed) {
+		item->flags |= TABLE_ITEM_CHANGED;
+		fuzzy->changed[fuzzy->changed_count++] = item;
+	}
+	if (++fuzzy->snap->dead * 2 > fuzzy->snap->count)
+		table_fuzzy_stale(table);
+}
+
+
+/**
+  * @brief    将一行按得分插入 fuzzy->items[]，得分相同的排在后面，已满时挤出最后一行
+  * @param    evicted : 输出被挤出的行，没有时为 NULL
+  * @return   插入的位置，得分不足以进入前 top_k 行时返回 -1
+*/
+static int table_fuzzy_place(struct table_fuzzy *fuzzy,struct table_item *item,int score,struct table_item **evicted)
+{
+	int low = 0,high = fuzzy->count,mid;
+
+	*evicted = NULL;
+	while (low < high) {
+		mid = (low + high) / 2;
+		if (fuzzy->scores[mid] >= score)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	if (low >= fuzzy->top_k) {
+		return -1;
+	}
+	if (fuzzy->count == fuzzy->top_k) {
+		*evicted = fuzzy->items[--fuzzy->count];
+	}
+	memmove(&fuzzy->items[low+1],&fuzzy->items[low],sizeof(struct table_item *) * (fuzzy->count - low));
+	memmove(&fuzzy->scores[low+1],&fuzzy->scores[low],sizeof(int) * (fuzzy->count - low));
+	fuzzy->items[low] = item;
+	fuzzy->scores[low] = score;
+	fuzzy->count++;
+	return low;
+}
+
+
+/**
+  * @brief    将 fuzzy->items[] 中第 pos 行移除，其后的行前移
+*/
+static void table_fuzzy_erase(struct table_fuzzy *fuzzy,int pos)
+{
+	if (pos < 0 || pos >= fuzzy->count) {
+		return;
+	}
+	fuzzy->count--;
+	memmove(&fuzzy->items[pos],&fuzzy->items[pos+1],sizeof(struct table_item *) * (fuzzy->count - pos));
+	memmove(&fuzzy->scores[pos],&fuzzy->scores[pos+1],sizeof(int) * (fuzzy->count - pos));
+}
+
+
+/**
+  * @brief    模糊匹配时对新增或修改的行计分，进入前 top_k 行时插入过滤视图，调用时表格已加锁
+  * @return   在过滤视图中的行号，未检出返回 -1
+*/
+static int table_fuzzy_link(struct table *table,struct table_item *item)
+{
+	struct table_item *evicted;
+	int line,score;
+
+	table_match_prepare(table,table->keyword,strlen(table->keyword));
+	if ((score = table_fuzzy_item_score(table,item)) < 0) {
+		return -1;
+	}
+	if ((line = table_fuzzy_place(table->fuzzy,item,score,&evicted)) < 0) {
+		return -1;
+	}
+	if (evicted) {
+		table_aggs_item(table,evicted,-1,-1,TABLE_AGGS_VIEW);
+		wg_list_del_init(&evicted->filter);
+		wg_rank_erase(&table->filter_index,&evicted->filter_rank);
+		evicted->filter_rank.size = 0;
+		table->filter--;
+	}
+	wg_list_add_tail(&item->filter,&table->filter_items);
+	wg_rank_insert_at(&table->filter_index,&item->filter_rank,line);
+	table_aggs_item(table,item,-1,1,TABLE_AGGS_VIEW);
+	table->filter++;
+	return line;
+}
+
+
+/**
+  * @brief    以模糊匹配的结果重建过滤视图，调用时表格已加锁
+  * @note     结果中被修改或删除的行被跳过，被修改的行和新增的行补充计分；
+  *           快照已被丢弃时结果中的行按当前内容重新计分
+  * @return   被跳过的行使视图不足 top_k 行而快照中还有候选时返回 1，
+  *           job->top_k 已调大，需重新计分
+*/
+static int table_fuzzy_finish(struct table *table,struct table_fuzzy_job *job)
+{
+	struct table_fuzzy *fuzzy = table->fuzzy;
+	struct table_fuzzy_snap *snap = job->snap;
+	struct table_item *item,*evicted;
+	struct wg_list *node;
+	int score,current = snap == fuzzy->snap;
+
+	fuzzy->count = 0;
+	table_match_prepare(table,table->keyword,strlen(table->keyword));
+	for (int i = 0; i < job->results && fuzzy->count < fuzzy->top_k; i++) {
+		item = snap->items[job->result[i].index];
+		if (item->flags & (TABLE_ITEM_DELETED | TABLE_ITEM_CHANGED))
+			continue;
+		score = current ? job->result[i].score : table_fuzzy_item_score(table,item);
+		if (score >= 0)
+			table_fuzzy_place(fuzzy,item,score,&evicted);
+	}
+	if (current && fuzzy->count < fuzzy->top_k && job->results == job->top_k &&
+		job->top_k < snap->count && job->top_k < fuzzy->top_k + snap->dead) {
+		/* 检索期间又有候选行失效 */
+		job->top_k = fuzzy->top_k + snap->dead;
+		return 1;
+	}
+
+	for (int i = 0; current && i < fuzzy->changed_count; i++) {
+		item = fuzzy->changed[i];
+		if (!(item->flags & TABLE_ITEM_DELETED) && (score = table_fuzzy_item_score(table,item)) >= 0)
+			table_fuzzy_place(fuzzy,item,score,&evicted);
+	}
+
+	/* 快照之后新增的行位于 items 末尾 */
+	for (node = table->items.prev; node != &table->items; node = node->prev) {
+		if ((int)(container_of(node,struct table_item,node)->seq - snap->seq) < 0)
+			break;
+	}
+	for (node = node->next; node != &table->items; node = node->next) {
+		item = container_of(node,struct table_item,node);
+		if ((score = table_fuzzy_item_score(table,item)) >= 0)
+			table_fuzzy_place(fuzzy,item,score,&evicted);
+	}
+
+	table_filter_apply(table,fuzzy->items,fuzzy->count);
+	table_filter_refresh(table,NULL);
+	return 0;
+}
+
+
+/**
+  * @brief    后台模糊匹配线程
+*/
+static void *table_fuzzy_entry(void *arg)
+{
+	struct table_fuzzy_job *job = arg;
+	struct table *table = job->table;
+	int ret,again;
+
+	do {
+		ret = table_fuzzy_run(job);
+
+		/* 检索期间如有新的匹配请求，结果作废 */
+		NWIDGET_MUTEX_LOCK(table->mutex);
+		again = 0;
+		if (!ret && !job->cancel && job->generation == table->fuzzy->generation)
+			again = table_fuzzy_finish(table,job);
+		if (!again) {
+			table->fuzzy->busy = 0;
+			table_fuzzy_snap_put(job->snap);
+			job->snap = NULL;
+			if (!table->sort_pending && !table_fuzzy_busy(table))
+				table_graveyard_free(table);
+		}
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		table_fuzzy_job_clear(job);
+	} while (again);
+	return NULL;
+}
+
+
+/**
+  * @brief    取消并等待后台模糊匹配结束
+  * @param    table : 目标表格
+  * @note     调用时不得持有表格锁，检索线程替换结果时需要加锁
+*/
+static void table_fuzzy_cancel(struct table *table)
+{
+	struct table_fuzzy *fuzzy = table->fuzzy;
+	if (fuzzy && fuzzy->thread) {
+		fuzzy->job->cancel = 1;
+		wg_thread_join(fuzzy->thread);
+		fuzzy->thread = NULL;
+	}
+	if (fuzzy && fuzzy->job) {
+		table_fuzzy_job_free(fuzzy->job);
+		fuzzy->job = NULL;
+	}
+}
+
+
+/**
+  * @brief    释放模糊匹配状态，调用前需 table_fuzzy_cancel()，调用时表格已加锁
+*/
+static void table_fuzzy_free(struct table_fuzzy *fuzzy)
+{
+	if (fuzzy) {
+		free(fuzzy->changed);
+		table_fuzzy_snap_put(fuzzy->snap);
+		free(fuzzy->items);
+		free(fuzzy->scores);
+		free(fuzzy);
+	}
+}
+
+
+/**
+  * @brief    以当前匹配串发起一次模糊匹配，调用时表格已加锁
+  * @note     沿用候选行快照并追加此后新增的行，在后台线程中计分，完成后替换过滤视图；
+  *           无法创建线程或上一次检索未结束时直接在当前线程中计分
+  * @return   成功返回 0
+*/
+static int table_fuzzy_start(struct table *table)
+{
+	struct table_fuzzy *fuzzy = table->fuzzy;
+	struct table_fuzzy_job *job;
+	int ret;
+
+	fuzzy->generation++;
+	if (fuzzy->thread && !fuzzy->busy) {
+		/* 上一次检索已结束，线程不再需要表格锁 */
+		wg_thread_join(fuzzy->thread);
+		fuzzy->thread = NULL;
+		table_fuzzy_job_free(fuzzy->job);
+		fuzzy->job = NULL;
+	}
+	if (fuzzy->snap && fuzzy->snap->refs == 1 && table_fuzzy_snap_append(table,fuzzy->snap)) {
+		table_fuzzy_stale(table);
+	}
+	if (!fuzzy->snap && NULL == (fuzzy->snap = table_fuzzy_snapshot(table))) {
+		return -1;
+	}
+	if (NULL == (job = calloc(1,sizeof(struct table_fuzzy_job)))) {
+		return -1;
+	}
+	job->table = table;
+	job->generation = fuzzy->generation;
+	job->top_k = fuzzy->top_k + fuzzy->snap->dead;
+	job->plen = fuzzy->plen;
+	job->exact = fuzzy->exact;
+	memcpy(job->pattern,fuzzy->pattern,sizeof(job->pattern));
+	job->snap = fuzzy->snap;
+	job->snap->refs++;
+
+	if (!fuzzy->thread) {
+		fuzzy->job = job;
+		fuzzy->busy = 1;
+		fuzzy->thread = wg_thread_create(table_fuzzy_entry,job);
+		if (fuzzy->thread)
+			return 0;
+		fuzzy->job = NULL;
+		fuzzy->busy = 0;
+	}
+
+	while (!(ret = table_fuzzy_run(job)) && table_fuzzy_finish(table,job))
+		table_fuzzy_job_clear(job);
+	table_fuzzy_snap_put(job->snap);
+	table_fuzzy_job_free(job);
+	return ret;
+}
+
+
+/**
+  * @brief    视图中的一行被移出后补足 top_k 行，调用时表格已加锁
+  * @note     视图原已满时其后可能还有候选，在后台重新检索；进行中的检索在替换结果时自行补足
+*/
+static void table_fuzzy_refill(struct table *table)
+{
+	struct table_fuzzy *fuzzy = table->fuzzy;
+
+	if (fuzzy->count == fuzzy->top_k - 1 && !fuzzy->busy) {
+		table_fuzzy_start(table);
+	}
+}
+
+
+/**
+  * @brief    以过滤条件检索整个表格，重建过滤视图，调用时表格已加锁
+  * @note     关键词不为空时结果作为第一层过滤缓存；模糊匹配时重新发起模糊匹配
+  * @return   成功返回 0
+*/
+static int table_where_apply(struct table *table)
+{
+	struct table_filter_level *level;
+
+	table_filter_drop(table,0);
+	if (table->fuzzy) {
+		table_fuzzy_stale(table);
+		return table_fuzzy_start(table);
+	}
+	if (!table_filtering(table)) {
+		table_filter_unlink(table);
+		return 0;
+	}
+	if (NULL == (level = table_filter_scan(table,table->keyword,NULL))) {
+		return -1;
+	}
+	table_filter_apply(table,level->items,level->count);
+	if (table->keyword[0]) {
+		table->filter_cache[0] = level;
+		table->filter_depth = 1;
+	} else {
+		free(level);
+	}
+	return 0;
+}
+
+
+/**
+  * @brief    table 控件搜索检出，任意一列包含关键词的行被检出
+  * @param    table  : table 句柄
+  * @param    keyword : 关键词，检索词，为空字符串或 NULL 时取消过滤
+  * @note     设置了过滤条件时只在满足条件的行中检出 @see wg_table_where()
+  * @return   成功返回 检出数，失败返回 -1
+*/
+int wg_table_filter(struct table *table,const char *keyword)
+{
+	struct table_filter_level *level = NULL;
+	struct table_item *current;
+	char buf[sizeof(table->keyword)];
+	size_t len;
+	int depth,lines;
+
+	if (!table || table_is_virtual(table)) {
+		return -1;
+	}
+	if (!keyword) {
+		keyword = "";
+	}
+	if ((len = strlen(keyword)) >= sizeof(buf)) {
+		/* 过长的关键词在 UTF-8 字符边界处截断，缓存和检索均使用截断后的关键词 */
+		len = sizeof(buf) - 1;
+		while (len > 0 && (keyword[len] & 0xC0) == 0x80)
+			len--;
+		memcpy(buf,keyword,len);
+		buf[len] = '\0';
+		keyword = buf;
+	}
+
+	table_fuzzy_cancel(table);
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (!strncmp(table->keyword,keyword,sizeof(table->keyword)-1)) {
+		/* 关键词未改变 */
+		lines = table_filtering(table) ? table->filter : table->lines;
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		return lines;
+	}
+
+	current = table_item_at(table,table->current_line);
+	if (!keyword[0] && !table->where && !table->fuzzy) {
+		/* 取消过滤，缓存保留以便再次输入 */
+		table_filter_unlink(table);
+		table->keyword[0] = '\0';
+		lines = table->lines;
+		goto refresh;
+	}
+	if (!keyword[0] || table->fuzzy) {
+		/* 只剩过滤条件时缓存均含有关键词，模糊匹配时候选行改变，均需重新检索 */
+		memcpy(table->keyword,keyword,len + 1);
+		if (table_where_apply(table))
+			goto failed;
+		lines = table->filter;
+		goto refresh;
+	}
+
+	/* 从最深一层开始查找关键词的子串 */
+	for (depth = table->filter_depth; depth > 0; depth--) {
+		level = table->filter_cache[depth-1];
+		if (strstr(keyword,level->keyword))
+			break;
+	}
+
+	if (depth > 0 && !strcmp(level->keyword,keyword)) {
+		/* 关键词回退至之前的输入，直接复用 */
+		if (table_filter_sync(table,&table->filter_cache[depth-1]))
+			goto failed;
+		level = table->filter_cache[depth-1];
+	} else {
+		if (depth > 0) {
+			if (table_filter_sync(table,&table->filter_cache[depth-1]))
+				goto failed;
+			level = table->filter_cache[depth-1];
+		}
+		level = table_filter_scan(table,keyword,depth > 0 ? level : NULL);
+		if (!level)
+			goto failed;
+
+		/* 丢弃与新关键词无关的更深的缓存，缓存满时丢弃最浅的一层 */
+		table_filter_drop(table,depth);
+		if (depth == TABLE_FILTER_DEPTH) {
+			free(table->filter_cache[0]);
+			memmove(&table->filter_cache[0],&table->filter_cache[1],
+				sizeof(table->filter_cache[0]) * (TABLE_FILTER_DEPTH-1));
+			depth--;
+		}
+		table->filter_cache[depth++] = level;
+		table->filter_depth = depth;
+	}
+
+	memcpy(table->keyword,keyword,len + 1);
+	table_filter_apply(table,level->items,level->count);
+	lines = table->filter;
+
+refresh:
+	table_filter_refresh(table,current);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	if (table->sig.changed)
+		table->sig.changed(table,table->sig.changed_arg);
+	return lines;
+
+failed:
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return -1;
+}
+
+
+/**
+  * @brief    按列条件过滤，与关键词过滤同时生效
+  * @param    table : 目标表格
+  * @param    expr  : 条件表达式，为空字符串或 NULL 时取消条件过滤
+  * @note     表达式只编译一次，检索时按批对各行求值
+  * @return   成功返回检出数，表达式有误或内存不足返回 -1
+*/
+int wg_table_where(struct table *table,const char *expr)
+{
+	struct table_where *where = NULL;
+	struct table_item *current;
+	int lines;
+
+	if (!table || table_is_virtual(table)) {
+		return -1;
+	}
+
+	table_fuzzy_cancel(table);
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (expr && expr[0] && NULL == (where = table_where_compile(table,expr))) {
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		return -1;
+	}
+
+	/* 缓存的过滤结果均按原条件检出 */
+	current = table_item_at(table,table->current_line);
+	table_where_free(table->where);
+	table->where = where;
+	if (table_where_apply(table)) {
+		/* 内存不足，取消条件过滤 */
+		table_where_free(table->where);
+		table->where = NULL;
+		table_where_apply(table);
+		table_filter_refresh(table,current);
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		return -1;
+	}
+
+	lines = table_filtering(table) ? table->filter : table->lines;
+	table_filter_refresh(table,current);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	if (table->sig.changed)
+		table->sig.changed(table,table->sig.changed_arg);
+	return lines;
+}
+
+
+/**
+  * @brief    模糊匹配，按得分从高到低只显示得分最高的 top_k 行
+  * @param    table   : 目标表格
+  * @param    pattern : 匹配串，为空字符串或 NULL 时取消
+  * @param    top_k   : 保留的行数，为 0 时使用 TABLE_FUZZY_TOPK
+  * @note     取消进行中的检索后在后台重新计分，结果就绪前显示上一次的结果
+  * @return   成功返回0 
+*/
+int wg_table_fuzzy(struct table *table,const char *pattern,int top_k)
+{
+	struct table_fuzzy *fuzzy;
+	struct table_item *current,**items;
+	int *scores,ret = 0;
+
+	if (!table || table_is_virtual(table) || top_k < 0) {
+		return -1;
+	}
+	if (!pattern) {
+		pattern = "";
+	}
+	if (!top_k) {
+		top_k = TABLE_FUZZY_TOPK;
+	}
+
+	table_fuzzy_cancel(table);
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (!pattern[0]) {
+		/* 取消模糊匹配，恢复关键词和条件过滤的结果 */
+		if (table->fuzzy) {
+			current = table_item_at(table,table->current_line);
+			table_fuzzy_stale(table);
+			table_fuzzy_free(table->fuzzy);
+			table->fuzzy = NULL;
+			ret = table_where_apply(table);
+			table_filter_refresh(table,current);
+		}
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		if (table->sig.changed)
+			table->sig.changed(table,table->sig.changed_arg);
+		return ret;
+	}
+
+	fuzzy = table->fuzzy;
+	if (!fuzzy || fuzzy->top_k != top_k) {
+		items = malloc(sizeof(struct table_item *) * top_k);
+		scores = malloc(sizeof(int) * top_k);
+		if (!fuzzy)
+			fuzzy = calloc(1,sizeof(struct table_fuzzy));
+		if (!items || !scores || !fuzzy) {
+			free(items);
+			free(scores);
+			if (fuzzy != table->fuzzy)
+				free(fuzzy);
+			goto failed;
+		}
+		free(fuzzy->items);
+		free(fuzzy->scores);
+		fuzzy->items = items;
+		fuzzy->scores = scores;
+		fuzzy->top_k = top_k;
+		fuzzy->count = 0;
+		table->fuzzy = fuzzy;
+
+		/* 视图中的行数随之改变，结果就绪前先清空视图 */
+		table_filter_drop(table,0);
+		table_filter_unlink(table);
+	}
+
+	/* 匹配串含大写字母时区分大小写 */
+	strncpy(fuzzy->pattern,pattern,sizeof(fuzzy->pattern)-1);
+	fuzzy->pattern[sizeof(fuzzy->pattern)-1] = '\0';
+	fuzzy->plen = strlen(fuzzy->pattern);
+	fuzzy->exact = 0;
+	for (int i = 0; i < fuzzy->plen; i++) {
+		if (fuzzy->pattern[i] >= 'A' && fuzzy->pattern[i] <= 'Z')
+			fuzzy->exact = 1;
+	}
+
+	ret = table_fuzzy_start(table);
+	if (!ret && fuzzy->thread) {
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		return 0;
+	}
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	if (table->sig.changed)
+		table->sig.changed(table,table->sig.changed_arg);
+	return ret;
+
+failed:
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return -1;
+}
+
+
+/**
+  * @brief    显示顺序改变后，按新顺序重建过滤视图，并保持选中行
+  * @param    table : 目标表格
+  * @param    current : 原选中行，可为 NULL
+*/
+static void table_view_reordered(struct table *table,struct table_item *current)
+{
+	struct wg_rank_node **nodes,*node;
+	struct table_item *item;
+	struct wg_list *list;
+	int count = 0,lines,visible_height;
+
+	/* 模糊匹配的结果按得分排列，与显示顺序无关，只需丢弃按旧顺序排列的快照 */
+	table_fuzzy_stale(table);
+	if (table_filtering(table) && !table->fuzzy) {
+		nodes = malloc(sizeof(struct wg_rank_node *) * (table->filter + 1));
+		if (nodes) {
+			for (node = wg_rank_first(&table->index); node; node = wg_rank_next(node)) {
+				item = container_of(node,struct table_item,rank);
+				if (wg_rank_linked(&item->filter_rank))
+					nodes[count++] = &item->filter_rank;
+			}
+			wg_rank_build(&table->filter_index,nodes,count);
+			free(nodes);
+		} else {
+			wg_rank_init(&table->filter_index);
+			for (list = table->filter_items.next; list != &table->filter_items; list = list->next) {
+				item = container_of(list,struct table_item,filter);
+				wg_rank_insert(&table->filter_index,&item->filter_rank,table_filter_rank_cmp,table);
+			}
+		}
+	}
+
+	/* 缓存的过滤结果按旧顺序排列 */
+	table_filter_drop(table,0);
+
+	lines = table_filtering(table) ? table->filter : table->lines;
+	if (current)
+		table->current_line = table_item_line(table,current);
+	visible_height = table->wg.height - table->show_border - table->show_title;
+	if (table->current_line >= 0 && (table->current_line < table->start_line ||
+		table->current_line >= table->start_line + visible_height)) {
+		table->start_line = table->current_line;
+	}
+	if (table->start_line + visible_height > lines)
+		table->start_line = lines > visible_height ? lines - visible_height : 0;
+
+	table_refresh_raw(table,false);
+}
+
+
+/**
+  * @brief    不经后台线程，直接按当前排序键重建显示顺序
+  * @param    table : 目标表格
+*/
+static void table_sort_inline(struct table *table)
+{
+	struct table_item *item,*current;
+	struct wg_rank_node **nodes;
+	struct wg_list *node;
+	int count = 0;
+
+	current = table_item_at(table,table->current_line);
+	nodes = table->sort_nkeys ? NULL : malloc(sizeof(struct wg_rank_node *) * (table->lines + 1));
+	if (nodes) {
+		/* 恢复插入顺序 */
+		for (node = table->items.next; node != &table->items; node = node->next)
+			nodes[count++] = &container_of(node,struct table_item,node)->rank;
+		wg_rank_build(&table->index,nodes,count);
+		free(nodes);
+	} else {
+		wg_rank_init(&table->index);
+		for (node = table->items.next; node != &table->items; node = node->next) {
+			item = container_of(node,struct table_item,node);
+			wg_rank_insert(&table->index,&item->rank,table_rank_cmp,table);
+		}
+	}
+	table->sort_pending = 0;
+	table_view_reordered(table,current);
+}
+
+
+/**
+  * @brief    比较排序快照中的两行
+*/
+static int table_sort_job_cmp(struct table_sort_job *job,int a,int b)
+{
+	union table_sort_value *x = &job->values[a * job->nkeys];
+	union table_sort_value *y = &job->values[b * job->nkeys];
+	int ret;
+
+	for (int i = 0; i < job->nkeys; i++) {
+		switch (job->keys[i].type) {
+		case TABLE_SORT_INT:
+			ret = (x[i].i > y[i].i) - (x[i].i < y[i].i);
+			break;
+		case TABLE_SORT_FLOAT:
+			ret = (x[i].f > y[i].f) - (x[i].f < y[i].f);
+			break;
+		case TABLE_SORT_COLLATE:
+			ret = strcoll(x[i].s,y[i].s);
+			break;
+		default:
+			ret = strcmp(x[i].s,y[i].s);
+			break;
+		}
+		if (ret)
+			return job->keys[i].descending ? -ret : ret;
+	}
+
+	/* 快照按插入顺序排列，下标即插入顺序 */
+	return a - b;
+}
+
+
+static void table_sort_job_free(struct table_sort_job *job)
+{
+	free(job->items);
+	free(job->values);
+	free(job->strings);
+	free(job->order);
+	free(job);
+}
+
+
+/**
+  * @brief    在表格加锁时生成排序快照，字符串排序键被复制，数值排序键被预先解析
+  * @param    table : 目标表格
+  * @return   成功返回排序任务
+*/
+static struct table_sort_job *table_sort_snapshot(struct table *table)
+{
+	struct table_sort_job *job;
+	struct table_item *item;
+	struct table_type *type;
+	struct wg_list *node;
+	union table_sort_value *value,*dict_values[TABLE_SORT_KEYS] = {NULL};
+	size_t size = 0;
+	char *str;
+	int i = 0;
+
+	if (NULL == (job = calloc(1,sizeof(struct table_sort_job)))) {
+		return NULL;
+	}
+	job->table = table;
+	job->generation = table->sort_generation;
+	job->seq = table->seq;
+	job->nkeys = table->sort_nkeys;
+	job->count = table->lines;
+	memcpy(job->keys,table->sort_keys,sizeof(job->keys));
+
+	/* 类型列按原始值比较，字典列按各字符串预先算出的序号或数值比较 */
+	for (int k = 0; k < job->nkeys; k++) {
+		if (NULL == (type = table_col_type(table,job->keys[k].col)))
+			continue;
+		if (type->dict) {
+			if (NULL == (dict_values[k] = table_dict_sort_values(type->dict,job->keys[k].type)))
+				goto fail;
+			job->keys[k].type = job->keys[k].type == TABLE_SORT_FLOAT ? TABLE_SORT_FLOAT : TABLE_SORT_INT;
+			continue;
+		}
+		job->keys[k].type = type->type == TABLE_COL_DOUBLE ? TABLE_SORT_FLOAT : TABLE_SORT_INT;
+	}
+
+	/* 字符串排序键所需的空间 */
+	for (node = table->items.next; node != &table->items; node = node->next) {
+		item = container_of(node,struct table_item,node);
+		for (int k = 0; k < job->nkeys; k++) {
+			if (job->keys[k].type == TABLE_SORT_STRING || job->keys[k].type == TABLE_SORT_COLLATE)
+				size += strlen(item->values[job->keys[k].col]) + 1;
+		}
+	}
+
+	job->items = malloc(sizeof(struct table_item *) * (job->count + 1));
+	job->values = malloc(sizeof(union table_sort_value) * (job->count * job->nkeys + 1));
+	job->strings = str = malloc(size + 1);
+	if (!job->items || !job->values || !job->strings) {
+		goto fail;
+	}
+
+	value = job->values;
+	for (node = table->items.next; node != &table->items; node = node->next) {
+		item = container_of(node,struct table_item,node);
+		item->flags &= ~TABLE_ITEM_DIRTY;
+		job->items[i++] = item;
+		for (int k = 0; k < job->nkeys; k++,value++) {
+			const char *cell = item->values[job->keys[k].col];
+			if (dict_values[k]) {
+				*value = dict_values[k][table_col_type(table,job->keys[k].col)->data[item->slot].i + 1];
+				continue;
+			}
+			if (NULL != (type = table_col_type(table,job->keys[k].col))) {
+				if (type->type == TABLE_COL_DOUBLE)
+					value->f = type->data[item->slot].f;
+				else
+					value->i = type->data[item->slot].i;
+				continue;
+			}
+			switch (job->keys[k].type) {
+			case TABLE_SORT_INT:
+				value->i = strtoll(cell,NULL,10);
+				break;
+			case TABLE_SORT_FLOAT:
+				value->f = strtod(cell,NULL);
+				break;
+			default:
+				size = strlen(cell) + 1;
+				memcpy(str,cell,size);
+				value->s = str;
+				str += size;
+				break;
+			}
+		}
+	}
+	for (int k = 0; k < job->nkeys; k++)
+		free(dict_values[k]);
+	return job;
+fail:
+	for (int k = 0; k < job->nkeys; k++)
+		free(dict_values[k]);
+	table_sort_job_free(job);
+	return NULL;
+}
+
+
+/**
+  * @brief    归并排序的一趟，归并第 [start,end) 对相邻的有序段
+*/
+static void table_sort_merge(void *arg,int start,int end)
+{
+	struct table_sort_pass *pass = arg;
+	struct table_sort_job *job = pass->job;
+	int width = pass->width,count = job->count;
+	int *src = pass->src,*dst = pass->dst;
+
+	for (int pair = start; pair < end && !job->cancel; pair++) {
+		int low = pair * width * 2;
+		int mid = low + width < count ? low + width : count;
+		int high = mid + width < count ? mid + width : count;
+		int i = low,j = mid,k = low;
+		while (i < mid && j < high) {
+			if (table_sort_job_cmp(job,src[j],src[i]) < 0)
+				dst[k++] = src[j++];
+			else
+				dst[k++] = src[i++];
+		}
+		while (i < mid)
+			dst[k++] = src[i++];
+		while (j < high)
+			dst[k++] = src[j++];
+	}
+}
+
+
+/**
+  * @brief    对排序快照排序，结果存于 job->order
+  * @return   成功返回 0，被取消或内存不足返回 -1
+*/
+static int table_sort_run(struct table_sort_job *job)
+{
+	struct table_sort_pass pass;
+	int *tmp,count = job->count;
+
+	job->order = malloc(sizeof(int) * (count + 1));
+	tmp = malloc(sizeof(int) * (count + 1));
+	if (!job->order || !tmp) {
+		free(tmp);
+		return -1;
+	}
+
+	/* 先对每 16 行做插入排序 */
+	for (int start = 0; start < count; start += 16) {
+		int end = start + 16 < count ? start + 16 : count;
+		for (int i = start; i < end; i++) {
+			int id = i,j = i;
+			for ( ; j > start && table_sort_job_cmp(job,id,job->order[j-1]) < 0; j--)
+				job->order[j] = job->order[j-1];
+			job->order[j] = id;
+		}
+	}
+
+	/* 自底向上归并，每一趟中各对有序段相互独立，可多线程进行 */
+	pass.job = job;
+	pass.src = job->order;
+	pass.dst = tmp;
+	for (pass.width = 16; pass.width < count && !job->cancel; pass.width *= 2) {
+		int pairs = (count + pass.width * 2 - 1) / (pass.width * 2);
+		int chunk = TABLE_SCAN_CHUNK / (pass.width * 2);
+		wg_parallel_for(pairs,chunk > 0 ? chunk : 1,table_sort_merge,&pass);
+		tmp = pass.src;
+		pass.src = pass.dst;
+		pass.dst = tmp;
+	}
+
+	job->order = pass.src;
+	free(pass.dst);
+	return job->cancel ? -1 : 0;
+}
+
+
+/**
+  * @brief    用后台排序的结果替换显示顺序，调用时表格已加锁
+  * @param    table : 目标表格
+  * @param    job : 已完成的排序任务
+*/
+static void table_sort_swap(struct table *table,struct table_sort_job *job)
+{
+	struct table_item *item,*current;
+	struct wg_rank_node **nodes;
+	struct wg_list *node;
+	int count = 0;
+
+	nodes = malloc(sizeof(struct wg_rank_node *) * (job->count + 1));
+	if (!nodes) {
+		table_sort_inline(table);
+		return;
+	}
+
+	current = table_item_at(table,table->current_line);
+	for (int i = 0; i < job->count; i++) {
+		item = job->items[job->order[i]];
+		if (!(item->flags & (TABLE_ITEM_DIRTY | TABLE_ITEM_DELETED)))
+			nodes[count++] = &item->rank;
+	}
+	wg_rank_build(&table->index,nodes,count);
+	table->sort_pending = 0;
+	free(nodes);
+
+	/* 排序期间修改过排序键的行和新增的行按排序键插入 */
+	for (int i = 0; i < job->count; i++) {
+		item = job->items[i];
+		if (item->flags & TABLE_ITEM_DELETED)
+			continue;
+		if (item->flags & TABLE_ITEM_DIRTY) {
+			item->flags &= ~TABLE_ITEM_DIRTY;
+			wg_rank_insert(&table->index,&item->rank,table_rank_cmp,table);
+		}
+	}
+	for (node = table->items.prev; node != &table->items; node = node->prev) {
+		item = container_of(node,struct table_item,node);
+		if ((int)(item->seq - job->seq) < 0)
+			break;
+		item->flags &= ~TABLE_ITEM_DIRTY;
+		wg_rank_insert(&table->index,&item->rank,table_rank_cmp,table);
+	}
+
+	table_view_reordered(table,current);
+}
+
+
+/**
+  * @brief    后台排序线程
+*/
+static void *table_sort_entry(void *arg)
+{
+	struct table_sort_job *job = arg;
+	struct table *table = job->table;
+	int ret = table_sort_run(job);
+
+	/* 排序期间如有新的排序请求，结果作废 */
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (!ret && !job->cancel && job->generation == table->sort_generation)
+		table_sort_swap(table,job);
+	if (!table_fuzzy_busy(table))
+		table_graveyard_free(table);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+
+	free(job->items);
+	free(job->values);
+	free(job->strings);
+	free(job->order);
+	job->items = NULL;
+	job->values = NULL;
+	job->strings = NULL;
+	job->order = NULL;
+	return NULL;
+}
+
+
+/**
+  * @brief    取消并等待后台排序结束
+  * @param    table : 目标表格
+  * @note     调用时不得持有表格锁，排序线程替换结果时需要加锁
+*/
+static void table_sort_cancel(struct table *table)
+{
+	if (table->sort_thread) {
+		table->sort_job->cancel = 1;
+		wg_thread_join(table->sort_thread);
+		table->sort_thread = NULL;
+	}
+	if (table->sort_job) {
+		table_sort_job_free(table->sort_job);
+		table->sort_job = NULL;
+	}
+}
+
+
+/**
+  * @brief    按一列或多列排序
+  * @param    table : 目标表格
+  * @param    keys  : 排序键，keys[0] 为主键 @see struct table_sort_key
+  * @param    nkeys : 排序键数，不超过 TABLE_SORT_KEYS；为 0 时恢复插入顺序
+  * @return   成功返回0 
+*/
+int wg_table_sort(struct table *table,const struct table_sort_key *keys,int nkeys)
+{
+	struct table_sort_job *job;
+
+	if (!table || table_is_virtual(table) || nkeys < 0 || nkeys > TABLE_SORT_KEYS) {
+		return -1;
+	}
+	for (int i = 0; i < nkeys; i++) {
+		if (keys[i].col < 0 || keys[i].col >= table->cols)
+			return -1;
+	}
+
+	table_sort_cancel(table);
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	table->sort_generation++;
+	table->sort_nkeys = nkeys;
+	if (nkeys)
+		memcpy(table->sort_keys,keys,sizeof(struct table_sort_key) * nkeys);
+
+	/* 恢复插入顺序或表格为空时只需按 items 重建，此后加入的行直接插入有序位置 */
+	job = nkeys && table->lines ? table_sort_snapshot(table) : NULL;
+	if (job) {
+		table->sort_job = job;
+		table->sort_pending = 1;
+		table->sort_thread = wg_thread_create(table_sort_entry,job);
+	}
+
+	/* 无法创建后台排序时直接在当前线程中排序 */
+	if (!job || !table->sort_thread) {
+		table->sort_job = NULL;
+		if (job)
+			table_sort_job_free(job);
+		table_sort_inline(table);
+	}
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return 0;
+}
+
+
+/**
+  * @brief    删除一个表格所有数据
+  * @param    table : 目标表格
+  * @return   成功返回 0 
+*/
+int table_clear(struct table *table)
+{
+	struct wg_arena arena;
+
+	table_load_finish(table,1);
+	table_sort_cancel(table);
+	table_fuzzy_cancel(table);
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	wg_arena_move(&arena,&table->arena);
+	wg_list_init(&table->items);
+	wg_list_init(&table->filter_items);
+	wg_list_init(&table->graveyard);
+	wg_list_init(&table->expire);
+	wg_rank_init(&table->index);
+	wg_rank_init(&table->filter_index);
+	table_filter_drop(table,0);
+	table_keys_reset(table);
+	table_types_reset(table);
+	table_aggs_reset(table,TABLE_AGGS_ALL | TABLE_AGGS_VIEW);
+	table_facets_reset(table);
+	memset(table->keyword,0,sizeof(table->keyword));
+	table_where_free(table->where);
+	table->where = NULL;
+	table_fuzzy_free(table->fuzzy);
+	table->fuzzy = NULL;
+	table->start_line = table->filter = table->lines = 0;
+	table->current_line = table->current_col = -1;
+	table_refresh_aggs(table);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+
+	desktop_lock();
+	werase(table->window);
+	desktop_refresh();
+	desktop_unlock();
+
+	table_scrollbar_update(table);
+
+	/* 所有行都在内存池中，整体释放 */
+	wg_arena_release(&arena);
+	return 0;
+}
+
+
+/**
+  * @brief    表格预关闭函数，通知用户层表格将被关闭
+  * @param    self : 表格所属的 widget 句柄
+  * @return   成功返回 0 
+*/
+static int table_preclose(struct nwidget *self)
+{
+	struct table *table = container_of(self, struct table,wg);
+	if (table->sig.closed)
+		table->sig.closed(table,table->sig.closed_arg);
+	return 0;
+}
+
+
+/**
+  * @brief    销毁一个表格，释放表格的内存
+  * @param    self : 表格所属的 widget 句柄
+  * @note     一般在 widget_delete 中由 table->wg.destroy 调用
+  * @return   成功返回 0 
+*/
+static int table_destroy(struct nwidget *self)
+{
+	struct wg_list *next,*node;
+	struct table *table = container_of(self, struct table,wg);
+
+	if (table->sig.closed)
+		table->sig.closed(table,table->sig.closed_arg);
+
+	table_load_finish(table,1);
+	table_sort_cancel(table);
+	table_fuzzy_cancel(table);
+	DEBUG_MSG("%s(free %d items,%zu bytes)",__FUNCTION__,table->lines,table->arena.reserved);
+	wg_arena_release(&table->arena);
+	table_vcache_free(table);
+	table_rcache_free(table);
+	table_filter_drop(table,0);
+	free(table->keys);
+	table_types_free(table);
+	table_aggs_reset(table,TABLE_AGGS_ALL | TABLE_AGGS_VIEW);
+	free(table->aggs);
+	for (int i = 0; table->facets && i < table->facets->cols; i++)
+		table_facet_free(table->facets->col[i]);
+	free(table->facets);
+	free(table->search);
+	table_where_free(table->where);
+	table_fuzzy_free(table->fuzzy);
+
+	visible_column_cleanup(table);
+	free(table->shown);
+	node = table->column.next;
+	while(node != &table->column) {
+		next = node->next;
+		free(container_of(node, struct table_column,node));
+		node = next;
+	}
+
+	/* 当表格有边框或显示列标题时会创建子窗口 */
+	if (table->show_border || table->show_title) {
+		#ifdef VISIBLE_PANEL
+			if (table->panel)
+				del_panel(table->panel);
+		#endif
+		if (table->window)
+			delwin(table->window);
+	}
+
+	NWIDGET_MUTEX_DEINIT(table->mutex);
+
+	/* 由 table_create 创建的表格需要释放内存 */
+	if (table->created_by == wg_table_create){
+		DEBUG_MSG("%s(%p)",__FUNCTION__,table);
+		free(table);
+	}
+	return 0;
+}
+
+
+/**
+  * @brief    filter editline '\n' 的执行函数
+  * @param    _filter   : filter editline
+  * @param    _table    : 回调参数
+*/
+static int table_column_do_hide(void *_selection,void *_table)
+{
+	struct wg_list *node;
+	struct table_column *column;
+	struct table *selection,*table;
+	int col,hide;
+	
+	selection = (struct table *)_selection;
+	table = (struct table *)_table;
+	col = wg_table_current_line(selection);
+	
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	node = table->column.next;
+	for (int i = 0; i < col; i++) {
+		node = node->next;
+	}
+	column = container_of(node,struct table_column,node);
+	hide = !column->hide;
+	if (hide) {
+		/* 遍历所有列，如果仅存 1 列不允许隐藏 */
+		int show = 0;
+		node = table->column.next;
+		while (node != &table->column) {
+			struct table_column *check;
+			check = container_of(node,struct table_column,node);
+			node = node->next;
+			show += !check->hide;
+		}
+		if (show < 2) {
+			hide = 0;
+			beep();
+			goto unlock;
+		}
+	}
+
+	column->hide = hide;
+	table_layout_index(table);
+	visible_column_checkout(table,0);
+	table_refresh_raw(table,true);
+unlock:
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	wg_table_cell_update(selection,col,0,hide ? "[ ]":"[*]");
+	return WG_OK;
+}
+
+
+/**
+  * @brief    换算覆盖于表格之上的弹框的位置，尽量在原表格的居中位置
+  * @param    rows : 弹框中的行数
+  * @param    max_width : 弹框的最大宽度
+*/
+static void table_popup_place(struct table *table,int rows,int max_width,int *height,int *width,int *y,int *x)
+{
+	*height = rows + 4;
+	if (table->wg.height > *height) {
+		*y = table->wg.rely + (table->wg.height-*height)/2;
+	} else {
+		*y = table->wg.rely;
+		*height = table->wg.height;
+	}
+
+	if (table->wg.width > max_width) {
+		*x = table->wg.relx + (table->wg.width-max_width)/2;
+		*width = max_width;
+	} else if (table->wg.width >= 16) {
+		*x = table->wg.relx + 1;
+		*width = table->wg.width - 2;
+	} else {
+		*x = table->wg.relx - (16-table->wg.width)/2;
+		*width = 16;
+	}
+}
+
+
+/**
+  * @brief    响应 '/' 弹出列隐藏表格弹框
+  * @param    self : 目标表格所在的 wg 控件句柄
+  * @param    key : 键
+*/
+static wg_state_t table_column_hide(struct nwidget *self,long key)
+{
+	static const struct wghandler wg_handlers[] = {
+		{'/',widget_exit_left},
+		{'\t',widget_exit_left},
+		{'\e',widget_exit_left},
+		{KEY_BACKSPACE,widget_exit_left},
+		{0,0}
+	};
+	int height,width,x,y;
+	char *values[2];
+	struct wg_list *node;
+	struct table_column *column;
+	struct table *selection,*table = container_of(self, struct table,wg);
+	if (table->cols < 2) {
+		beep();
+		return WG_OK;
+	}
+
+	table_popup_place(table,table->cols,32,&height,&width,&y,&x);
+
+	char msg[256];
+	snprintf(msg, sizeof(msg),"%d,%d",y,x);
+	desktop_tips(msg);
+
+	/* 创建一个新的表格覆盖于当前表格之上 */
+	selection = wg_table_create(height,width,TABLE_BORDER|TABLE_TITLE);
+	wg_table_column_add(selection,"",3);
+	wg_table_column_add(selection,"column name",32);
+
+	/* 新建的表格悬空，使其失焦后自动销毁 */
+	wg_table_put(selection,NULL,y,x);
+
+	/* 更新键盘响应和信号，在选择窗口被销毁后刷新原表格的列 */
+	handlers_update(&selection->wg,wg_handlers);
+	wg_signal_connect(selection,selected,table_column_do_hide,table);
+	
+	for (node = table->column.next; node != &table->column; node = node->next) {
+		column = container_of(node,struct table_column,node);
+		values[0] = column->hide ? "[ ]" : "[*]";
+		values[1] = column->title;
+		wg_table_item_add(selection,values);
+	}
+
+	return WG_OK;
+}
+
+/**
+  * @brief    分面弹框中的值按行数从多到少排列
+*/
+static int table_facet_entry_cmp(const void *a,const void *b)
+{
+	const struct table_facet_entry *x = a,*y = b;
+	if (x->count != y->count)
+		return x->count < y->count ? 1 : -1;
+	return strcmp(x->word,y->word);
+}
+
+
+/**
+  * @brief    分面弹框的选中响应，按选中的值进行条件过滤，选中第一行时取消条件过滤
+  * @param    _selection : 分面弹框
+  * @param    _table     : 原表格
+*/
+static int table_facet_do_filter(void *_selection,void *_table)
+{
+	struct table *selection = (struct table *)_selection;
+	struct table *table = (struct table *)_table;
+	char **values,*expr,*p;
+	const char *s;
+	int line,col;
+
+	line = wg_table_current_line(selection);
+	values = wg_table_values(selection,line);
+	if (line < 1 || !values) {
+		wg_table_where(table,NULL);
+		return WG_OK;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	col = table->facets ? table->facets->popup : -1;
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	if (col < 0 || NULL == (expr = malloc(strlen(values[0]) * 2 + 32))) {
+		return WG_OK;
+	}
+
+	/* 按字符串比较：$列序号 == "值"，值中的引号和反斜杠需转义 */
+	p = expr + sprintf(expr,"$%d == \"",col);
+	for (s = values[0]; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			*p++ = '\\';
+		*p++ = *s;
+	}
+	strcpy(p,"\"");
+	wg_table_where(table,expr);
+	free(expr);
+	return WG_OK;
+}
+
+
+/**
+  * @brief    分面弹框中选中一个值后关闭弹框
+*/
+static wg_state_t table_facet_choose(struct nwidget *self,long key)
+{
+	table_selected(self,key);
+	return widget_exit_left(self,key);
+}
+
+
+/**
+  * @brief    响应 'f' 弹出分面弹框，列出首个可视的分面列的各个不同值及其行数
+  * @param    self : 目标表格所在的 wg 控件句柄
+  * @param    key : 键
+  * @note     行数随行的增删改增量维护，弹出时不扫描表格
+*/
+static wg_state_t table_facet_popup(struct nwidget *self,long key)
+{
+	static const struct wghandler wg_handlers[] = {
+		{'f',widget_exit_left},
+		{'\t',widget_exit_left},
+		{'\e',widget_exit_left},
+		{KEY_BACKSPACE,widget_exit_left},
+		{' ',table_facet_choose},
+		{'\n',table_facet_choose},
+		{0,0}
+	};
+	struct table *selection,*table = container_of(self, struct table,wg);
+	struct table_facet_entry *entries = NULL;
+	struct table_facet *facet = NULL;
+	int height,width,x,y,col = -1,count = 0;
+	char ***rows = NULL,**values = NULL,*counts = NULL;
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	for (int i = 0; i < table->visible_cols && !facet; i++) {
+		col = table->visible[i]->index;
+		facet = table_facet_of(table,col);
+	}
+	if (facet) {
+		table->facets->popup = col;
+		count = facet->dict.count - facet->dead;
+	}
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	if (!facet) {
+		beep();
+		return WG_OK;
+	}
+
+	/* 创建一个新的表格覆盖于当前表格之上，悬空使其失焦后自动销毁 */
+	table_popup_place(table,count + 1,40,&height,&width,&y,&x);
+	selection = wg_table_create(height,width,TABLE_BORDER|TABLE_TITLE);
+	wg_table_column_add(selection,"value",width - 12);
+	wg_table_column_add(selection,"rows",10);
+	wg_table_put(selection,NULL,y,x);
+	handlers_update(&selection->wg,wg_handlers);
+	wg_signal_connect(selection,selected,table_facet_do_filter,table);
+
+	/* 弹出期间分面可能已改变，重新取出各个值，第一行为全部行 */
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (NULL == (facet = table_facet_of(table,col))) {
+		goto cleanup;
+	}
+	count = facet->dict.count - facet->dead;
+	entries = malloc(sizeof(struct table_facet_entry) * (count + 1));
+	rows = malloc(sizeof(char **) * (count + 1));
+	values = malloc(sizeof(char *) * 2 * (count + 1));
+	counts = malloc(24 * (count + 1));
+	if (!entries || !rows || !values || !counts) {
+		goto cleanup;
+	}
+	entries[0].word = "(all)";
+	entries[0].count = table->lines;
+	for (int i = 0,n = 1; i < facet->dict.count && n <= count; i++) {
+		if (facet->counts[i]) {
+			entries[n].word = facet->dict.words[i];
+			entries[n++].count = facet->counts[i];
+		}
+	}
+	qsort(&entries[1],count,sizeof(struct table_facet_entry),table_facet_entry_cmp);
+	for (int i = 0; i <= count; i++) {
+		snprintf(&counts[24 * i],24,"%lld",entries[i].count);
+		values[i * 2] = (char *)entries[i].word;
+		values[i * 2 + 1] = &counts[24 * i];
+		rows[i] = &values[i * 2];
+	}
+	wg_table_items_add_batch(selection,rows,count + 1);
+cleanup:
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	free(entries);
+	free(rows);
+	free(values);
+	free(counts);
+	return WG_OK;
+}
+
+/**
+  * @brief    放置一个 table 控件
+  * @param    table : 表格
+  * @param    parent : 父窗体
+  * @param    y : 父窗体的y坐标
+  * @param    x : 父窗体的x坐标
+  * @return   成功返回 0
+*/
+int wg_table_put(struct table *table,struct nwidget *parent,int y,int x)
+{
+	static const char tips[] = 
 		"table:<home/end/pgup/pgdn/ARROW>move cursor |"
 		"('<'/'>')move visible column |"
 	;
@@ -1097,417 +5593,2344 @@ int wg_table_put(struct table *table,struct nwidget *parent,int y,int x)
 		{0,0}
 	};
 
-	height = table->wg.height;
-	width = table->wg.width;
-	if (!width || !height) {
+	height = table->wg.height;
+	width = table->wg.width;
+	if (!width || !height) {
+		return -1;
+	}
+
+	if (0 != widget_init(&table->wg,parent,height,width,y,x)) {
+		return -1;
+	}
+
+	/* 填充背景色 */
+	if (table->wg.bkg)
+		wbkgd(table->wg.win,table->wg.bkg);
+
+	visible_column_checkout(table,0);
+	
+	y = x = 0;
+	if (table->show_border) {
+		x += 1;
+		y += 1;
+		width -= 2;
+		height -= 2;
+		wborder(table->wg.win,
+			table->ls,table->rs,table->ts,table->bs,
+			table->tl,table->tr,table->bl,table->br);
+		
+	}
+
+	if (table->show_title){
+		y += 2;
+		height -= 2;
+		table_column_title(table,true);
+	}
+
+	if (!x && !y) {
+		table->window = table->wg.win;
+		table->panel = table->wg.panel;
+	} else {
+		table->window = derwin(table->wg.win,height,width,y,x);
+		table->panel = new_panel(table->window);
+		if (table->wg.bkg)
+			wbkgd(table->window,table->wg.bkg);
+	}
+
+	/* 逐行滚动时允许 ncurses 使用终端的插入/删除行功能 @see table_move_line() */
+	idlok(table->window,TRUE);
+
+	/* 如果使能了列隐藏功能，新增 '/' 键响应 */
+	if (table->option & TABLE_COL_HIDE) {
+		static const struct wghandler hide_handlers[] = {
+			{'/' ,table_column_hide},
+			{0,0}
+		};
+		handlers_update(&table->wg,hide_handlers);
+	}
+
+	/* 如果使能了分面弹框，新增 'f' 键响应 */
+	if (table->option & TABLE_FACET) {
+		static const struct wghandler facet_handlers[] = {
+			{'f' ,table_facet_popup},
+			{0,0}
+		};
+		handlers_update(&table->wg,facet_handlers);
+	}
+
+	/* table 控件会创建子窗体，需更新动作响应函数 */
+	handlers_update(&table->wg,table_handlers);
+	table->wg.handle_mouse_event = table_mousedown;
+	table->wg.focus = table_focus;
+	table->wg.blur = table_blur;
+	table->wg.destroy = table_destroy;
+	table->wg.preclose = table_preclose;
+	table->wg.move = table_move;
+	table->wg.hide = table_hide;
+	table->wg.tick = table_tick;
+	table->wg.tips = tips;
+
+	lines = table_filtering(table) ? table->filter : table->lines;
+	if (lines > 0) {
+		/* 放置前已有数据，刷新 */
+		NWIDGET_MUTEX_LOCK(table->mutex);
+		table_refresh_raw(table,false);
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+	}
+	return 0;
+}
+
+
+/**
+  * @brief    初始化一个 table 控件
+  * @param    table  : table 句柄
+  * @param    height : 控件高度
+  * @param    width  : 控件宽度
+  * @param    flags  : 控件参数 @see enum table_flags
+  * @return   成功返回 0
+*/
+int wg_table_init(struct table *table,int height,int width,int flags)
+{
+	if (height < 1) {
+		return -1;
+	}
+	memset(table, 0, sizeof(struct table));
+	NWIDGET_MUTEX_INIT(table->mutex);
+	
+	wg_list_init(&table->column);
+	wg_list_init(&table->items);
+	wg_list_init(&table->filter_items);
+	wg_list_init(&table->graveyard);
+	wg_list_init(&table->expire);
+	wg_rank_init(&table->index);
+	wg_rank_init(&table->filter_index);
+	wg_arena_init(&table->arena,0);
+
+	table->current_col = -1;
+	table->current_line = -1;
+	table->wg.height = height;
+	table->wg.width = width;
+	table->option = flags;
+	table->show_title = (flags & TABLE_TITLE) ? 2 : 0;
+	table->show_border = (flags & TABLE_BORDER) ? 2 : 0;
+	table->show_footer = (flags & TABLE_FOOTER) == TABLE_FOOTER;
+	
+	wg_table_border(table,wgtheme.ls,wgtheme.rs,wgtheme.ts,wgtheme.bs,
+		wgtheme.tl,wgtheme.tr,wgtheme.bl,wgtheme.br);
+	return 0;
+}
+
+
+/**
+  * @brief    创建一个 table 控件
+  * @param    height : 控件高度
+  * @param    width  : 控件宽度
+  * @param    flags  : 控件参数 @see enum table_flags
+  * @return   成功返回 table 句柄，否则返回 0
+*/
+struct table *wg_table_create(int height,int width,int flags)
+{
+	struct table *table = malloc(sizeof(struct table));
+	if (table == NULL) {
+		return NULL;
+	}
+	
+	if (0 != wg_table_init(table,height,width,flags) ) {
+		free(table);
+		return NULL;
+	}
+
+	table->created_by = wg_table_create;
+	DEBUG_MSG("%s(%p)",__FUNCTION__,table);
+	return table;
+}
+
+
+/**
+  * @brief    设置 table 控件的边框显示字符
+  * @return   成功返回 0
+*/
+int wg_table_border(struct table *table,chtype ls,chtype  rs,
+	chtype  ts,chtype  bs,chtype  tl,chtype  tr,chtype  bl,chtype  br)
+{
+	table->ls = ls ? ls : ACS_VLINE;
+	table->rs = rs ? rs : ACS_VLINE;
+	table->ts = ts ? ts : ACS_HLINE;
+	table->bs = bs ? bs : ACS_HLINE;
+	table->tl = tl ? tl : ACS_ULCORNER;
+	table->tr = tr ? tr : ACS_URCORNER;
+	table->bl = bl ? bl : ACS_LLCORNER;
+	table->br = br ? br : ACS_LRCORNER;
+	return 0;
+}
+
+
+/**
+  * @brief    创建新列，尚未加入表格
+  * @return   成功返回新列，宽度无效或内存不足返回 NULL
+*/
+static struct table_column *table_column_new(struct table *table,char *column_name,int width)
+{
+	int size = 0;
+	struct table_column *newcol;
+
+	size = column_name ? strlen(column_name) : 0;
+	size += sizeof(struct table_column);
+	if (NULL == (newcol = malloc(size))) {
+		return NULL;
+	}
+	memset(newcol,0,size);
+	if (column_name) 
+		strcpy(newcol->title,column_name);
+
+	newcol->width = (width > table->wg.width) ? table->wg.width-3 : width;
+	return newcol;
+}
+
+
+/**
+  * @brief    新增列后重新计算可视列并刷新，调用时表格已加锁
+*/
+static void table_columns_changed(struct table *table)
+{
+	table_layout_index(table);
+
+	/* 已经放置了的控件，进行显示 */
+	if (table->wg.win) {
+		table->start_col = -1;
+		visible_column_checkout(table,0);
+		table_refresh_raw(table,true);
+	}
+}
+
+
+/**
+  * @brief    table 控件添加一列
+  * @param    table : table 句柄
+  * @param    column_name : 新列列名
+  * @param    width : 列显示宽度
+  * @return   成功返回 0
+*/
+int wg_table_column_add(struct table *table,char *column_name,int width)
+{
+	struct table_column *newcol;
+
+	if (width < 1) {
+		return 0;
+	}
+
+	if (NULL == (newcol = table_column_new(table,column_name,width))) {
+		return -1;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	wg_list_add_tail(&newcol->node,&table->column);
+	newcol->index = table->cols++;
+	table_columns_changed(table);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return 0;
+}
+
+
+/**
+  * @brief    table 控件一次添加多列，只计算一次可视列并刷新一次
+  * @param    table : table 句柄
+  * @param    column_names : 各列列名
+  * @param    widths : 各列显示宽度，小于 1 的列被忽略
+  * @param    n : 列数
+  * @return   成功返回 0
+*/
+int wg_table_columns_add(struct table *table,char *column_names[],const int widths[],int n)
+{
+	struct table_column *newcol;
+	struct wg_list columns;
+	int ret = 0;
+
+	/* 先在锁外创建所有列 */
+	wg_list_init(&columns);
+	for (int i = 0; i < n; i++) {
+		if (widths[i] < 1) {
+			continue;
+		}
+		if (NULL == (newcol = table_column_new(table,column_names ? column_names[i] : NULL,widths[i]))) {
+			ret = -1;
+			break;
+		}
+		wg_list_add_tail(&newcol->node,&columns);
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	while (columns.next != &columns) {
+		newcol = container_of(columns.next,struct table_column,node);
+		wg_list_del(&newcol->node);
+		wg_list_add_tail(&newcol->node,&table->column);
+		newcol->index = table->cols++;
+	}
+	table_columns_changed(table);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return ret;
+}
+
+
+/**
+  * @brief    将一列设为类型列，其值按列存放，只在绘制可视单元格时格式化
+  * @param    table  : 目标表格，必须为空表格
+  * @param    col    : 目标列，不能为键列
+  * @param    type   : 列类型 @see enum table_column_type
+  * @param    format : 格式化函数，为 NULL 时按类型使用默认格式
+  * @param    arg    : 格式化函数的参数，TABLE_COL_ENUM 的默认格式为名称数组
+  * @return   成功返回0 
+*/
+int wg_table_column_type(struct table *table,int col,int type,table_format_t format,void *arg)
+{
+	static const table_format_t formats[] = {
+		[TABLE_COL_INT] = table_format_int,
+		[TABLE_COL_DOUBLE] = table_format_double,
+		[TABLE_COL_TIME] = table_format_time,
+		[TABLE_COL_ENUM] = table_format_enum,
+		[TABLE_COL_DICT] = NULL,
+	};
+	struct table_types *types;
+	int cols,ret = -1;
+
+	if (!table || table_is_virtual(table) || col < 0 || col >= table->cols ||
+		type < TABLE_COL_STRING || type > TABLE_COL_DICT) {
+		return -1;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (table->lines || (table->keys && table->keys->col == col) ||
+		(type != TABLE_COL_STRING && table_col_search(table,col))) {
+		goto cleanup;
+	}
+
+	/* 扩展至当前列数，各列的 data[] 在加入第一行时分配 */
+	types = table->types;
+	cols = types ? types->cols : 0;
+	if (col >= cols) {
+		types = realloc(types,sizeof(struct table_types) + sizeof(struct table_type) * table->cols);
+		if (!types) {
+			goto cleanup;
+		}
+		if (!table->types)
+			memset(types,0,sizeof(struct table_types));
+		memset(&types->col[cols],0,sizeof(struct table_type) * (table->cols - cols));
+		types->cols = table->cols;
+		table->types = types;
+	}
+
+	if (type == TABLE_COL_DICT && !types->col[col].dict) {
+		if (NULL == (types->col[col].dict = calloc(1,sizeof(struct table_dict))))
+			goto cleanup;
+	} else if (type != TABLE_COL_DICT) {
+		table_dict_free(types->col[col].dict);
+		types->col[col].dict = NULL;
+	}
+	table_dict_reset(types->col[col].dict);
+	free(types->col[col].data);
+	types->col[col].data = NULL;
+	types->col[col].type = type;
+	types->col[col].format = format ? format : formats[type];
+	types->col[col].arg = arg;
+
+	/* 表格为空，重新分配下标 */
+	for (int i = 0; i < types->cols; i++) {
+		free(types->col[i].data);
+		types->col[i].data = NULL;
+	}
+	types->slots = types->size = types->free_count = 0;
+	ret = 0;
+cleanup:
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return ret;
+}
+
+
+/**
+  * @brief    设置一列在页脚显示的聚合
+  * @param    table : 目标表格
+  * @param    col   : 目标列
+  * @param    agg   : 聚合方式 @see enum table_aggregate，TABLE_AGG_NONE 为取消
+  * @note     设置时扫描一次全部行，此后随行的增删改增量更新；
+  *           过滤时显示过滤视图中的行的聚合
+  * @return   成功返回0 
+*/
+int wg_table_aggregate(struct table *table,int col,int agg)
+{
+	struct table_aggs *aggs;
+	struct table_item *item;
+	struct wg_list *node;
+	int cols;
+
+	if (!table || table_is_virtual(table) || col < 0 || col >= table->cols ||
+		agg < TABLE_AGG_NONE || agg > TABLE_AGG_COUNT) {
+		return -1;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	aggs = table->aggs;
+	cols = aggs ? aggs->cols : 0;
+	if (col >= cols) {
+		aggs = realloc(aggs,sizeof(struct table_aggs) + sizeof(struct table_agg) * table->cols);
+		if (!aggs) {
+			NWIDGET_MUTEX_UNLOCK(table->mutex);
+			return -1;
+		}
+		if (!table->aggs)
+			aggs->count = 0;
+		memset(&aggs->col[cols],0,sizeof(struct table_agg) * (table->cols - cols));
+		aggs->cols = table->cols;
+		table->aggs = aggs;
+	}
+
+	aggs->count += (agg != TABLE_AGG_NONE) - (aggs->col[col].agg != TABLE_AGG_NONE);
+	table_agg_state_clear(&aggs->col[col].all);
+	table_agg_state_clear(&aggs->col[col].view);
+	aggs->col[col].agg = agg;
+	if (agg != TABLE_AGG_NONE) {
+		for (node = table->items.next; node != &table->items; node = node->next) {
+			item = container_of(node,struct table_item,node);
+			table_aggs_item(table,item,col,1,table_aggs_of(item));
+		}
+	}
+
+	if (table->wg.win && table->show_footer && table->wg.width > 24) {
+		desktop_lock();
+		table_footer(table);
+		desktop_refresh();
+		desktop_unlock();
+	}
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return 0;
+}
+
+
+/**
+  * @brief    获取一列在当前视图下的聚合结果
+  * @param    value : 输出聚合结果
+  * @return   成功返回0，未设置聚合或没有数值时返回 -1
+*/
+int wg_table_aggregate_value(struct table *table,int col,double *value)
+{
+	int ret;
+
+	assert(table && value);
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	ret = table_agg_result(table,col,value);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return ret;
+}
+
+
+/**
+  * @brief    设置一列是否维护分面，即各个不同值的行数
+  * @param    table  : 目标表格
+  * @param    col    : 目标列
+  * @param    enable : 为 0 时取消
+  * @note     设置时扫描一次全部行，此后随行的增删改增量更新；
+  *           类型列按显示内容统计
+  * @return   成功返回0 
+*/
+int wg_table_facet(struct table *table,int col,int enable)
+{
+	struct table_facets *facets;
+	struct table_facet *facet;
+	struct table_item *item;
+	struct wg_list *node;
+	char buf[256];
+	int cols;
+
+	if (!table || table_is_virtual(table) || col < 0 || col >= table->cols) {
+		return -1;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (!enable || table_facet_of(table,col)) {
+		if (!enable && table_facet_of(table,col)) {
+			table_facet_free(table->facets->col[col]);
+			table->facets->col[col] = NULL;
+			table->facets->count--;
+		}
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		return 0;
+	}
+
+	facets = table->facets;
+	cols = facets ? facets->cols : 0;
+	if (col >= cols) {
+		facets = realloc(facets,sizeof(struct table_facets) + sizeof(struct table_facet *) * table->cols);
+		if (!facets) {
+			NWIDGET_MUTEX_UNLOCK(table->mutex);
+			return -1;
+		}
+		if (!table->facets) {
+			facets->count = 0;
+			facets->popup = -1;
+		}
+		memset(&facets->col[cols],0,sizeof(struct table_facet *) * (table->cols - cols));
+		facets->cols = table->cols;
+		table->facets = facets;
+	}
+
+	if (NULL == (facet = calloc(1,sizeof(struct table_facet)))) {
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		return -1;
+	}
+	for (node = table->items.next; node != &table->items; node = node->next) {
+		item = container_of(node,struct table_item,node);
+		table_facet_add(facet,table_cell_text(table,item,col,buf,sizeof(buf)),1);
+	}
+	facets->col[col] = facet;
+	facets->count++;
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return 0;
+}
+
+
+/**
+  * @brief    获取分面列中一个值的行数
+  * @param    value : 单元格的显示内容
+  * @return   行数，该列未设置分面时返回 -1
+*/
+long long wg_table_facet_count(struct table *table,int col,const char *value)
+{
+	struct table_facet *facet;
+	long long count = -1;
+	int code;
+
+	assert(table && value);
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (col >= 0 && NULL != (facet = table_facet_of(table,col))) {
+		code = table_dict_code(&facet->dict,value,0);
+		count = code < 0 ? 0 : facet->counts[code];
+	}
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return count;
+}
+
+
+/**
+  * @brief    设置一列是否建立检索索引
+  * @param    table  : 目标表格
+  * @param    col    : 目标列，须为字符串列
+  * @param    enable : 为 0 时取消
+  * @note     建立时为已有的行生成检索键，此后在行加入或修改时生成；
+  *           关键词过滤和模糊匹配同时以小写关键词匹配检索键
+  * @return   成功返回0 
+*/
+int wg_table_column_search(struct table *table,int col,int enable)
+{
+	struct table_search *search;
+	struct table_item *item,*current;
+	struct wg_list *node;
+	int cols,ret = 0;
+
+	if (!table || table_is_virtual(table) || col < 0 || col >= table->cols) {
+		return -1;
+	}
+
+	table_fuzzy_cancel(table);
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (table_col_type(table,col)) {
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		return -1;
+	}
+	enable = !!enable;
+	if (table_col_search(table,col) == enable) {
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		return 0;
+	}
+
+	search = table->search;
+	cols = search ? search->cols : 0;
+	if (col >= cols) {
+		search = realloc(search,sizeof(struct table_search) + table->cols);
+		if (!search) {
+			NWIDGET_MUTEX_UNLOCK(table->mutex);
+			return -1;
+		}
+		if (!table->search)
+			search->count = 0;
+		memset(&search->col[cols],0,table->cols - cols);
+		search->cols = table->cols;
+		table->search = search;
+	}
+
+	/* 各行按新的索引列重新打包，取消时检索键不再使用，留待行修改时回收 */
+	search->count += enable ? 1 : -1;
+	search->col[col] = enable;
+	if (enable) {
+		for (node = table->items.next; node != &table->items; node = node->next) {
+			item = container_of(node,struct table_item,node);
+			if (table_item_repack(table,item,-1,NULL)) {
+				/* 内存不足，已打包的行多出的检索键不再使用 */
+				search->count--;
+				search->col[col] = 0;
+				ret = -1;
+				break;
+			}
+		}
+	}
+
+	/* 缓存的过滤结果按原方式检出 */
+	table_filter_drop(table,0);
+	table_fuzzy_stale(table);
+	if (!table_filtering(table)) {
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		return ret;
+	}
+	current = table_item_at(table,table->current_line);
+	table_where_apply(table);
+	table_filter_refresh(table,current);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	if (table->sig.changed)
+		table->sig.changed(table,table->sig.changed_arg);
+	return ret;
+}
+
+
+/**
+  * @brief    视图中插入一行后其后的行下移一行，选中行和起始行随之调整，仍指向原来的行
+  * @param    line : 插入的行号，为 -1 时不在视图中
+  * @return   line
+*/
+static int table_view_inserted(struct table *table,int line)
+{
+	if (line >= 0 && table->current_line >= 0 && line <= table->current_line)
+		table->current_line++;
+	if (line >= 0 && line < table->start_line)
+		table->start_line++;
+	return line;
+}
+
+
+/**
+  * @brief    将新行加入表格，已排序时插入至有序位置，过滤时检索并加入过滤视图
+  * @param    table : 目标表格
+  * @param    item : 新行
+  * @return   新行在当前视图中的行号，被过滤时返回 -1
+*/
+static int table_item_link(struct table *table,struct table_item *item)
+{
+	int line,sorted = table_is_sorted(table);
+
+	item->seq = table->seq++;
+	item->touched = wg_time_ms();
+	wg_list_init(&item->node);
+	wg_list_init(&item->filter);
+	wg_list_add_tail(&item->node,&table->items);
+	wg_list_add_tail(&item->expire,&table->expire);
+	table_keys_insert(table,item);
+	if (sorted) {
+		line = wg_rank_insert(&table->index,&item->rank,table_rank_cmp,table);
+	} else {
+		line = table->lines;
+		wg_rank_insert_at(&table->index,&item->rank,line);
+	}
+	table->lines++;
+	table_aggs_item(table,item,-1,1,TABLE_AGGS_ALL);
+	table_facets_item(table,item,-1,1);
+
+	if (!table_filtering(table)) {
+		return table_view_inserted(table,line);
+	}
+	if (table->fuzzy) {
+		return table_view_inserted(table,table_fuzzy_link(table,item));
+	}
+
+	/* 过滤期间新增的行即时检索，检出则加入过滤视图 */
+	table_match_prepare(table,table->keyword,strlen(table->keyword));
+	if (!table_item_match(table,item,table->keyword,strlen(table->keyword))) {
+		return -1;
+	}
+	wg_list_add_tail(&item->filter,&table->filter_items);
+	if (sorted) {
+		line = wg_rank_insert(&table->filter_index,&item->filter_rank,table_filter_rank_cmp,table);
+	} else {
+		line = table->filter;
+		wg_rank_insert_at(&table->filter_index,&item->filter_rank,line);
+	}
+	table->filter++;
+	table_aggs_item(table,item,-1,1,TABLE_AGGS_VIEW);
+	return table_view_inserted(table,line);
+}
+
+
+/**
+  * @brief    选中行或起始行因行数减少而越界时修正，调用时表格已加锁
+  * @return   起始行被修正返回 1
+*/
+static int table_view_clamp(struct table *table)
+{
+	int lines,visible_height,start = table->start_line;
+
+	lines = table_filtering(table) ? table->filter : table->lines;
+	visible_height = table->wg.height - table->show_border - table->show_title;
+	if (table->current_line >= lines)
+		table->current_line = lines - 1;
+	if (table->start_line + visible_height > lines)
+		table->start_line = lines > visible_height ? lines - visible_height : 0;
+	return start != table->start_line;
+}
+
+
+/**
+  * @brief    将一行从表格中摘下，调用时表格已加锁
+  * @note     选中行和起始行随之调整，仍指向原来的行
+  * @return   该行在当前视图中原来的行号，被过滤时返回 -1
+*/
+static int table_item_unlink(struct table *table,struct table_item *item)
+{
+	int line = table_item_line(table,item);
+
+	table_aggs_item(table,item,-1,-1,table_aggs_of(item));
+	table_facets_item(table,item,-1,-1);
+	wg_list_del(&item->node);
+	wg_list_del(&item->expire);
+	table_keys_remove(table,item);
+	table_fuzzy_invalidate(table,item,0);
+	wg_rank_erase(&table->index,&item->rank);
+	table->lines--;
+	if (wg_rank_linked(&item->filter_rank)) {
+		if (table->fuzzy)
+			table_fuzzy_erase(table->fuzzy,wg_rank_of(&item->filter_rank));
+		wg_list_del(&item->filter);
+		wg_rank_erase(&table->filter_index,&item->filter_rank);
+		table->filter--;
+		if (table->fuzzy)
+			table_fuzzy_refill(table);
+	}
+	table_filter_drop(table,0);
+
+	/* 被摘下的行之后的行上移一行 */
+	if (line >= 0 && line < table->current_line)
+		table->current_line--;
+	if (line >= 0 && line < table->start_line)
+		table->start_line--;
+	return line;
+}
+
+
+/**
+  * @brief    释放摘下的行，调用时表格已加锁
+  * @note     后台排序或模糊匹配的快照仍引用该行，结束后再释放
+*/
+static void table_item_discard(struct table *table,struct table_item *item)
+{
+	if (table->sort_pending || table_fuzzy_busy(table)) {
+		item->flags |= TABLE_ITEM_DELETED;
+		wg_list_add_tail(&item->node,&table->graveyard);
+	} else {
+		table_item_free(table,item);
+	}
+}
+
+
+/**
+  * @brief    摘下一行后刷新显示，调用时表格已加锁
+  * @param    table : 目标表格
+  * @param    line : 被摘下的行原来的行号，@see table_item_unlink()
+*/
+static void table_refresh_removed(struct table *table,int line)
+{
+	int visible_height,y;
+
+	visible_height = table->wg.height - table->show_border - table->show_title;
+	y = line - table->start_line;
+	if (!table->window) {
+		/* 未放置的控件 */
+		table_view_clamp(table);
+	} else if (table_view_clamp(table) || !table->visible_cols) {
+		table_refresh_raw(table,false);
+	} else if (line < 0 || y < 0 || y >= visible_height) {
+		/* 删除的行不在可视区域内，只更新页脚 */
+		desktop_lock();
+		if (table->show_footer && table->wg.width > 24)
+			table_footer(table);
+		if (!table->wg.hidden)
+			desktop_refresh();
+		desktop_unlock();
+		table_scrollbar_update(table);
+	} else {
+		/* 删除所在行，下方的行上移，只需绘制新露出的最后一行和选中行 */
+		desktop_lock();
+		wmove(table->window,y,0);
+		wdeleteln(table->window);
+		table_draw_line(table,table->start_line + visible_height - 1,0);
+		if (table->current_line >= 0)
+			table_draw_line(table,table->current_line,table->wg.editing ? A_FOCUS : A_UNFOCUS);
+		if (table->show_footer && table->wg.width > 24)
+			table_footer(table);
+		if (!table->wg.hidden)
+			desktop_refresh();
+		desktop_unlock();
+		table_scrollbar_update(table);
+	}
+}
+
+
+/**
+  * @brief    淘汰一行，先通知 wg_table_on_evict() 设置的回调再移出表格，调用时表格已加锁
+  * @return   同 table_item_unlink()
+*/
+static int table_item_evict(struct table *table,struct table_item *item)
+{
+	if (table->evicted)
+		table->evicted(table,item->values,table->evicted_arg);
+	return table_item_unlink(table,item);
+}
+
+
+/**
+  * @brief    表格已满时淘汰最早加入的行，并尽量复用其存储创建新行，调用时表格已加锁
+  * @param    table : 目标表格
+  * @param    values : 新行内容
+  * @param    evicted : 输出被淘汰的行原来的行号，@see table_item_unlink()
+  * @return   成功返回新行，尚未加入表格
+*/
+static struct table_item *table_item_recycle(struct table *table,char *values[],int *evicted)
+{
+	struct table_item *item = container_of(table->items.next,struct table_item,node);
+	size_t size = table_item_size(table,values);
+
+	*evicted = table_item_evict(table,item);
+	if (table->sort_pending || table_fuzzy_busy(table) || wg_arena_size(item) < size) {
+		table_item_discard(table,item);
+		return table_item_new(table,values);
+	}
+
+	table_rcache_drop(table,item);
+	wg_arena_free(&table->arena,item->heap);
+	return table_item_pack(table,item,values,item->slot);
+}
+
+
+/**
+  * @brief    向表格添加一行，调用时表格已加锁
+  * @return   成功返回新行，内存不足返回 NULL
+*/
+static struct table_item *table_item_add(struct table *table,char *values[])
+{
+	int visible_height,display,lines,line,full,evicted = -1;
+	struct table_item *newitem;
+
+	full = table->max > 0 && table->lines >= table->max;
+	if (full) {
+		newitem = table_item_recycle(table,values,&evicted);
+	} else {
+		newitem = table_item_new(table,values);
+	}
+	if (!newitem) {
+		if (full)
+			table_refresh_removed(table,evicted);
+		return NULL;
+	}
+	line = table_item_link(table,newitem);
+
+	/* 表格已满，淘汰了最早加入的行，其在可视区域内时可视行整体上移 */
+	if (full)
+		table_refresh_removed(table,evicted);
+	lines = table_filtering(table) ? table->filter : table->lines;
+	visible_height = table->wg.height - table->show_border - table->show_title;
+	display = line - table->start_line;
+
+	if (NULL == table->wg.win) {
+		/* 未放置的控件 */
+		table_view_clamp(table);
+	} else if (table_view_clamp(table) || !table->visible_cols) {
+		/* 模糊匹配挤出了选中行 */
+		table_refresh_raw(table,false);
+	} else if (line < 0 || display < 0 || display >= visible_height) {
+		/* 在不可视区域添加行，起始行已随之调整，可视行不变，只需刷新滚动条 */
+		table_refresh_aggs(table);
+		table_scrollbar_update(table);
+	} else {
+		/* 在可视区域末尾添加行只绘制新行；有序插入至可视区域时下方的行下移一行，
+		   选中行随之下移，同样只需绘制新行 */
+		desktop_lock();
+		if (line < lines - 1) {
+			wmove(table->window,display,0);
+			winsertln(table->window);
+		}
+		table_draw_item(table,display,newitem,line == table->current_line ?
+			(table->wg.editing ? A_FOCUS : A_UNFOCUS) : 0);
+		desktop_refresh();
+		desktop_unlock();
+
+		table_refresh_aggs(table);
+		table_scrollbar_update(table);
+	}
+	return newitem;
+}
+
+
+/**
+  * @brief    向表格添加一行
+  * @param    table  : 目标窗体
+  * @param    values : 行内容
+  * @return   成功返回 table_item 中的 values 数组 
+*/
+char **wg_table_item_add(struct table *table,char *values[])
+{
+	struct table_item *newitem;
+
+	/* 虚拟表格的数据由数据源提供 */
+	if (table_is_virtual(table)) {
+		return NULL;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	newitem = table_item_add(table,values);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return newitem ? newitem->values : NULL;
+}
+
+
+/**
+  * @brief    向表格一次添加多行，只加锁一次，所有行加入后只刷新一次
+  * @param    table  : 目标窗体
+  * @param    rows : 各行内容，rows[i] 同 wg_table_item_add() 的 values
+  * @param    n : 行数
+  * @return   成功加入的行数
+*/
+int wg_table_items_add_batch(struct table *table,char **rows[],int n)
+{
+	int visible_height,line,count,repaint = 0;
+	struct table_item *item;
+
+	if (table_is_virtual(table) || n < 1) {
+		return 0;
+	}
+
+	/* 各行在内存池中连续分配 */
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	visible_height = table->wg.height - table->show_border - table->show_title;
+	for (count = 0; count < n; count++) {
+		if (table->max > 0 && table->lines >= table->max) {
+			item = table_item_recycle(table,rows[count],&line);
+			if (line >= table->start_line && line < table->start_line + visible_height)
+				repaint = 1;
+		} else {
+			item = table_item_new(table,rows[count]);
+		}
+		if (NULL == item)
+			break;
+		line = table_item_link(table,item);
+		if (line >= table->start_line && line < table->start_line + visible_height)
+			repaint = 1;
+	}
+	if (table_view_clamp(table))
+		repaint = 1;
+
+	if (NULL == table->wg.win) {
+		/* 未放置的控件 */
+	} else if (repaint) {
+		table_refresh_raw(table,false);
+	} else {
+		table_scrollbar_update(table);
+	}
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return count;
+}
+
+
+/**
+  * @brief    设置表格的最大行数，超过时淘汰最早加入的行
+  * @param    table : 目标表格
+  * @param    max_rows : 最大行数，为 0 时不限制
+  * @note     被淘汰的行的句柄随即失效，其存储可能已属于新行 @see wg_table_on_evict()
+  * @return   成功返回0 
+*/
+int wg_table_max_rows(struct table *table,int max_rows)
+{
+	struct table_item *item;
+	int evicted = 0;
+
+	if (!table || table_is_virtual(table) || max_rows < 0) {
+		return -1;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	table->max = max_rows;
+	while (max_rows && table->lines > max_rows) {
+		item = container_of(table->items.next,struct table_item,node);
+		table_item_evict(table,item);
+		table_item_discard(table,item);
+		evicted++;
+	}
+	if (evicted) {
+		table_view_clamp(table);
+		if (table->wg.win)
+			table_refresh_raw(table,false);
+	}
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return 0;
+}
+
+
+/**
+  * @brief    设置行的存活时间，行在最近一次加入或更新后超过该时间即被删除
+  * @param    table : 目标表格
+  * @param    ttl_ms : 存活时间(毫秒)，为 0 时不过期
+  * @note     过期的行的句柄随即失效 @see wg_table_on_evict()
+  * @return   成功返回0 
+*/
+int wg_table_ttl(struct table *table,int ttl_ms)
+{
+	if (!table || table_is_virtual(table) || ttl_ms < 0) {
+		return -1;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	table->ttl = ttl_ms;
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return wg_table_expire(table);
+}
+
+
+/**
+  * @brief    删除所有已过期的行，只刷新一次
+  * @param    table : 目标表格
+  * @note     table->expire 按最近更新时间排列，只需从队首检查至第一个未过期的行
+  * @return   删除的行数
+*/
+int wg_table_expire(struct table *table)
+{
+	struct table_item *item;
+	long long now;
+	int count = 0;
+
+	if (!table || table->ttl <= 0) {
+		return 0;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	now = wg_time_ms();
+	while (!wg_list_empty(&table->expire)) {
+		item = container_of(table->expire.next,struct table_item,expire);
+		if (now - item->touched < table->ttl)
+			break;
+		table_item_evict(table,item);
+		table_item_discard(table,item);
+		count++;
+	}
+	if (count) {
+		table_view_clamp(table);
+		if (table->wg.win)
+			table_refresh_raw(table,false);
+	}
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return count;
+}
+
+
+/**
+  * @brief    设置行被淘汰前的回调
+  * @param    table : 目标表格
+  * @param    evicted : 回调函数，row 为被淘汰的行句柄，回调返回后失效；为 NULL 时取消
+  * @param    arg : 回调参数
+  * @note     回调时表格已加锁，回调中不能再调用该表格的接口
+  * @return   成功返回0 
+*/
+int wg_table_on_evict(struct table *table,int (*evicted)(struct table *table,char **row,void *arg),void *arg)
+{
+	if (!table) {
+		return -1;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	table->evicted = evicted;
+	table->evicted_arg = arg;
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return 0;
+}
+
+
+/**
+  * @brief    桌面每轮循环调用，删除过期的行
+*/
+static int table_tick(struct nwidget *wg)
+{
+	wg_table_expire(container_of(wg,struct table,wg));
+	return 0;
+}
+
+
+/**
+  * @brief    行句柄对应的行
+*/
+static inline struct table_item *table_row_item(char **row)
+{
+	return (struct table_item *)((char *)row - offsetof(struct table_item,values));
+}
+
+
+/**
+  * @brief    按行在 table->index 中的顺序比较，过滤视图与 index 顺序一致
+*/
+static int table_filter_order_cmp(const struct wg_rank_node *a,const struct wg_rank_node *b,void *table)
+{
+	struct table_item *x = container_of(a,struct table_item,filter_rank);
+	struct table_item *y = container_of(b,struct table_item,filter_rank);
+	return wg_rank_of(&x->rank) - wg_rank_of(&y->rank);
+}
+
+
+/**
+  * @brief    行内容改变后重新检索，使过滤视图保持正确，调用时表格已加锁
+  * @param    table : 目标表格
+  * @param    item : 内容改变的行
+*/
+static void table_filter_recheck(struct table *table,struct table_item *item)
+{
+	int match,linked = wg_rank_linked(&item->filter_rank);
+
+	if (!table_filtering(table)) {
+		/* 缓存的过滤结果可能已不正确 */
+		table_filter_drop(table,0);
+		return;
+	}
+
+	if (table->fuzzy) {
+		/* 按新的得分重新插入 */
+		table_fuzzy_invalidate(table,item,1);
+		if (linked) {
+			table_fuzzy_erase(table->fuzzy,wg_rank_of(&item->filter_rank));
+			table_aggs_item(table,item,-1,-1,TABLE_AGGS_VIEW);
+			wg_list_del_init(&item->filter);
+			wg_rank_erase(&table->filter_index,&item->filter_rank);
+			item->filter_rank.size = 0;
+			table->filter--;
+		}
+		if (table_fuzzy_link(table,item) < 0 && linked)
+			table_fuzzy_refill(table);
+		return;
+	}
+
+	table_match_prepare(table,table->keyword,strlen(table->keyword));
+	match = table_item_match(table,item,table->keyword,strlen(table->keyword));
+	if (match && !linked) {
+		wg_list_add_tail(&item->filter,&table->filter_items);
+		wg_rank_insert(&table->filter_index,&item->filter_rank,table_filter_order_cmp,table);
+		table_aggs_item(table,item,-1,1,TABLE_AGGS_VIEW);
+		table->filter++;
+	} else if (!match && linked) {
+		table_aggs_item(table,item,-1,-1,TABLE_AGGS_VIEW);
+		wg_list_del_init(&item->filter);
+		wg_rank_erase(&table->filter_index,&item->filter_rank);
+		item->filter_rank.size = 0;
+		table->filter--;
+	}
+	table_filter_drop(table,0);
+}
+
+
+/**
+  * @brief    重绘第 line 行中的部分可视列，调用时表格已加锁
+  * @param    cells : 需重绘的可视列 @see table_draw_cells()
+*/
+static void table_redraw_cells(struct table *table,int line,struct table_item *item,unsigned int cells)
+{
+	long attr = table->wg.editing ? A_FOCUS : A_UNFOCUS;
+	int y = line - table->start_line;
+	int visible = cells && y >= 0 && y < table->wg.height - table->show_border - table->show_title;
+	int footer = table->aggs && table->aggs->count && table->show_footer && table->wg.width > 24;
+
+	/* 设置了聚合时页脚随单元格改变 */
+	if (!table->window || (!visible && !footer)) {
+		return;
+	}
+
+	desktop_lock();
+	if (visible)
+		table_draw_cells(table,y,item,cells,line == table->current_line ? attr : 0);
+	if (footer)
+		table_footer(table);
+	if (!table->wg.hidden)
+		desktop_refresh();
+	desktop_unlock();
+}
+
+
+/**
+  * @brief    第 col 列在可视列中的位，不可见时为 0 @see table_draw_cells()
+*/
+static unsigned int table_cell_bit(struct table *table,int col)
+{
+	for (int i = 0; i < table->visible_cols; i++) {
+		if (table->visible[i]->index == col)
+			return TABLE_CELL_BIT(i);
+	}
+	return 0;
+}
+
+
+/**
+  * @brief    行内容已修改，更新索引，调用时表格已加锁
+  * @param    table : 目标表格
+  * @param    item : 内容改变的行
+  * @param    resort : 修改了排序键
+  * @note     排序键被修改时行移至有序位置，过滤时重新检索
+*/
+static void table_item_reindex(struct table *table,struct table_item *item,int resort)
+{
+	table_rcache_drop(table,item);
+
+	/* 移至过期队列末尾 */
+	item->touched = wg_time_ms();
+	wg_list_del(&item->expire);
+	wg_list_add_tail(&item->expire,&table->expire);
+
+	/* 修改了排序键，重新插入至有序位置 */
+	if (!resort) {
+		/* 未改变顺序 */
+	} else if (table->sort_pending) {
+		item->flags |= TABLE_ITEM_DIRTY;
+	} else {
+		wg_rank_erase(&table->index,&item->rank);
+		wg_rank_insert(&table->index,&item->rank,table_rank_cmp,table);
+		if (wg_rank_linked(&item->filter_rank) && !table->fuzzy) {
+			wg_rank_erase(&table->filter_index,&item->filter_rank);
+			wg_rank_insert(&table->filter_index,&item->filter_rank,table_filter_rank_cmp,table);
+		}
+	}
+	table_filter_recheck(table,item);
+}
+
+
+/**
+  * @brief    行内容已修改，更新索引并刷新显示，调用时表格已加锁
+  * @param    table : 目标表格
+  * @param    item : 内容改变的行
+  * @param    line : 修改前的行号
+  * @param    resort : 修改了排序键
+  * @param    cells : 修改了的可视列 @see table_draw_cells()
+  * @note     行号不变时只重绘改变的单元格；行移至新位置时选中行仍指向原来的行，
+  *           只重绘新旧位置之间的可视行
+*/
+static void table_item_changed(struct table *table,struct table_item *item,int line,int resort,unsigned int cells)
+{
+	int moved,first,last,visible_height,current = table->current_line;
+	long attr = table->wg.editing ? A_FOCUS : A_UNFOCUS;
+
+	table_item_reindex(table,item,resort);
+	moved = table_item_line(table,item);
+	if (line >= 0 && line == moved) {
+		table_redraw_cells(table,line,item,cells);
+		return;
+	}
+
+	/* 相当于在原位置摘下再插入新位置，选中的是该行时随之移动 */
+	if (current >= 0 && current == line && moved >= 0) {
+		table->current_line = moved;
+	} else if (current >= 0) {
+		if (line >= 0 && line < table->current_line)
+			table->current_line--;
+		if (moved >= 0 && moved <= table->current_line)
+			table->current_line++;
+	}
+
+	visible_height = table->wg.height - table->show_border - table->show_title;
+	if (table->current_line == moved && current == line && moved >= 0 &&
+		(moved < table->start_line || moved >= table->start_line + visible_height)) {
+		/* 选中行移出了可视区域，滚动至该行 */
+		table->start_line = moved < table->start_line ? moved : moved - visible_height + 1;
+		table_view_clamp(table);
+		table_refresh_raw(table,false);
+		return;
+	}
+	if (table_view_clamp(table) || line < 0 || moved < 0 || !table->window || !table->visible_cols) {
+		/* 进出了过滤视图 */
+		table_refresh_raw(table,false);
+		return;
+	}
+
+	/* 只有新旧位置之间的行改变了显示位置 */
+	first = line < moved ? line : moved;
+	last = line < moved ? moved : line;
+	if (first < table->start_line)
+		first = table->start_line;
+	if (last >= table->start_line + visible_height)
+		last = table->start_line + visible_height - 1;
+	desktop_lock();
+	for (int i = first; i <= last; i++)
+		table_draw_line(table,i,i == table->current_line ? attr : 0);
+	if (table->aggs && table->aggs->count && table->show_footer && table->wg.width > 24)
+		table_footer(table);
+	if (!table->wg.hidden)
+		desktop_refresh();
+	desktop_unlock();
+}
+
+
+/**
+  * @brief    更新一行中某个单元格的值，调用时表格已加锁
+  * @param    table : 目标表格
+  * @param    item : 目标行
+  * @param    col : 目标列
+  * @param    value : 内容
+  * @return   成功返回0 
+*/
+static int table_item_update(struct table *table,struct table_item *item,int col,const char *value)
+{
+	int ret,line = table_item_line(table,item);
+	int rekey = table->keys && table->keys->col == col;
+
+	if (rekey)
+		table_keys_remove(table,item);
+	ret = table_item_set(table,item,col,value);
+	if (rekey)
+		table_keys_insert(table,item);
+	if (ret) {
+		return -1;
+	}
+
+	table_item_changed(table,item,line,table_is_sort_key(table,col),table_cell_bit(table,col));
+	return 0;
+}
+
+
+/**
+  * @brief    更新单元格的值
+  * @param    table  : 目标窗体
+  * @param    line   : 目标行
+  * @param    col    : 目标列
+  * @param    value  : 内容
+  * @return   成功返回0 
+*/
+int wg_table_cell_update(struct table *table,int line,int col,const char *value)
+{
+	struct table_item *item;
+	int ret = -1;
+
+	assert(table && value);
+	if (line < 0 || col < 0 || col >= table->cols) {
+		return -1;
+	}
+
+	if (table_is_virtual(table)) {
+		return wg_table_virtual_fill(table,line,col,value);
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (NULL != (item = table_item_at(table,line))) {
+		ret = table_item_update(table,item,col,value);
+	}
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return ret;
+}
+
+
+/**
+  * @brief    按行句柄更新单元格的值
+  * @param    table : 目标表格
+  * @param    row   : 行句柄，即 wg_table_item_add() 的返回值
+  * @param    col   : 目标列
+  * @param    value : 内容
+  * @return   成功返回0 
+*/
+int wg_table_row_update(struct table *table,char **row,int col,const char *value)
+{
+	int ret;
+
+	assert(table && row && value);
+	if (col < 0 || col >= table->cols || table_is_virtual(table)) {
+		return -1;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	ret = table_item_update(table,table_row_item(row),col,value);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return ret;
+}
+
+
+/**
+  * @brief    获取行句柄在当前视图(过滤/排序)中的行号
+  * @param    table : 目标表格
+  * @param    row   : 行句柄
+  * @return   行号，被过滤时返回 -1
+*/
+int wg_table_row_line(struct table *table,char **row)
+{
+	int line;
+
+	assert(table && row);
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	line = table_item_line(table,table_row_item(row));
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return line;
+}
+
+
+/**
+  * @brief    按行句柄设置类型列的值，不经过字符串
+  * @param    table : 目标表格
+  * @param    row   : 行句柄
+  * @param    col   : 类型列 @see wg_table_column_type()
+  * @param    value : 值
+  * @return   成功返回0 
+*/
+int wg_table_row_set(struct table *table,char **row,int col,union table_value value)
+{
+	struct table_item *item;
+	struct table_type *type;
+	int line;
+
+	assert(table && row);
+	if (col < 0 || col >= table->cols) {
+		return -1;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	type = table_col_type(table,col);
+	if (!type || (type->dict && (value.i < -1 || value.i >= type->dict->count))) {
+		/* 字典列只能设为字典中已有的编码 */
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		return -1;
+	}
+	item = table_row_item(row);
+	line = table_item_line(table,item);
+	table_aggs_item(table,item,col,-1,table_aggs_of(item));
+	table_facets_item(table,item,col,-1);
+	type->data[item->slot] = value;
+	table_aggs_item(table,item,col,1,table_aggs_of(item));
+	table_facets_item(table,item,col,1);
+	table_item_changed(table,item,line,table_is_sort_key(table,col),table_cell_bit(table,col));
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return 0;
+}
+
+
+/**
+  * @brief    按行句柄获取类型列的值
+  * @return   成功返回0，不是类型列返回 -1
+*/
+int wg_table_row_get(struct table *table,char **row,int col,union table_value *value)
+{
+	struct table_type *type;
+	int ret = -1;
+
+	assert(table && row && value);
+	if (col < 0 || col >= table->cols) {
+		return -1;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (NULL != (type = table_col_type(table,col))) {
+		*value = type->data[table_row_item(row)->slot];
+		ret = 0;
+	}
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return ret;
+}
+
+
+/**
+  * @brief    指定键列并建立哈希索引，用于 wg_table_upsert() 和 wg_table_find()
+  * @param    table : 目标表格
+  * @param    col   : 键列，为 -1 时删除索引
+  * @return   成功返回0 
+*/
+int wg_table_key(struct table *table,int col)
+{
+	int ret;
+
+	if (!table || table_is_virtual(table) || col < -1 || col >= table->cols) {
+		return -1;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	ret = col >= 0 && table_col_type(table,col) ? -1 : table_keys_build(table,col);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return ret;
+}
+
+
+/**
+  * @brief    按键列查找行，存在则只更新内容改变的单元格，否则添加新行
+  * @param    table  : 目标表格，需先以 wg_table_key() 指定键列
+  * @param    values : 行内容，同 wg_table_item_add()
+  * @return   成功返回行句柄 @see wg_table_row_update()
+*/
+char **wg_table_upsert(struct table *table,char *values[])
+{
+	struct table_item *item;
+	unsigned int cells = 0;
+	int line,ret = 0,resort = 0,changed = 0;
+	const char *key,*value;
+
+	assert(table && values);
+	if (table_is_virtual(table)) {
+		return NULL;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (!table->keys) {
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		return NULL;
+	}
+
+	key = values[table->keys->col] ? values[table->keys->col] : "";
+	if (NULL == (item = table_keys_find(table,key))) {
+		item = table_item_add(table,values);
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		return item ? item->values : NULL;
+	}
+
+	/* 键相同，只更新内容改变的单元格 */
+	line = table_item_line(table,item);
+	for (int col = 0; col < table->cols; col++) {
+		value = values[col] ? values[col] : "";
+		if (table_cell_equal(table,item,col,value))
+			continue;
+		if (0 != (ret = table_item_set(table,item,col,value)))
+			break;
+		resort |= table_is_sort_key(table,col);
+		cells |= table_cell_bit(table,col);
+		changed++;
+	}
+
+	/* 内存不足时部分单元格可能已更新 */
+	if (changed)
+		table_item_changed(table,item,line,resort,cells);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return ret ? NULL : item->values;
+}
+
+
+/**
+  * @brief    按键查找行在当前视图中的行号
+  * @param    table : 目标表格
+  * @param    key   : 键列的内容
+  * @return   行号，不存在或被过滤时返回 -1
+*/
+int wg_table_find(struct table *table,const char *key)
+{
+	struct table_item *item;
+	int line = -1;
+
+	assert(table && key);
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (table->keys && NULL != (item = table_keys_find(table,key)))
+		line = table_item_line(table,item);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return line;
+}
+
+
+/**
+  * @brief    以一份完整快照替换表格内容，按键列比较，只增删改变的行和单元格
+  * @param    table : 目标表格
+  * @param    rows  : 快照的各行，rows[i] 同 wg_table_item_add() 的 values
+  * @param    n     : 快照行数
+  * @param    key_col : 键列，表格的键索引不是该列时重建
+  * @note     选中行仍指向原来的行；没有增删行或行移动时只重绘改变的单元格；
+              被删除的行的句柄随即失效 @see wg_table_on_evict()
+  * @return   成功返回0，内存不足时部分行未能更新或加入，返回 -1
+*/
+int wg_table_apply_snapshot(struct table *table,char **rows[],int n,int key_col)
+{
+	struct table_item *item,*current;
+	struct wg_list *node,*next;
+	unsigned int cells;
+	int line,offset,resort,changed,repaint,insert = 0,seen = 0,ret = 0;
+	const char *key,*value;
+
+	if (!table || table_is_virtual(table) || n < 0 || key_col < 0 || key_col >= table->cols) {
 		return -1;
 	}
 
-	if (0 != widget_init(&table->wg,parent,height,width,y,x)) {
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if ((!table->keys || table->keys->col != key_col) &&
+		(table_col_type(table,key_col) || table_keys_build(table,key_col))) {
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
 		return -1;
 	}
 
-	/* 填充背景色 */
-	if (table->wg.bkg)
-		wbkgd(table->wg.win,table->wg.bkg);
+	current = table_item_at(table,table->current_line);
+	offset = table->current_line - table->start_line;
+
+	/* 先标记快照中仍存在的行，得出是否有行增删 */
+	for (int i = 0; i < n; i++) {
+		key = rows[i][key_col] ? rows[i][key_col] : "";
+		if (NULL == (item = table_keys_find(table,key))) {
+			insert++;
+		} else if (!(item->flags & TABLE_ITEM_SEEN)) {
+			item->flags |= TABLE_ITEM_SEEN;
+			seen++;
+		}
+	}
+	repaint = insert || seen < table->lines;
+
+	/* 更新内容改变的单元格，加入新行 */
+	for (int i = 0; i < n; i++) {
+		key = rows[i][key_col] ? rows[i][key_col] : "";
+		if (NULL == (item = table_keys_find(table,key))) {
+			if (table->max > 0 && table->lines >= table->max) {
+				if (current && table->items.next == &current->node)
+					current = NULL;
+				item = table_item_recycle(table,rows[i],&line);
+			} else {
+				item = table_item_new(table,rows[i]);
+			}
+			if (!item) {
+				ret = -1;
+				continue;
+			}
+			table_item_link(table,item);
+			item->flags |= TABLE_ITEM_SEEN;
+			continue;
+		}
 
-	visible_column_checkout(table,0);
-	
-	y = x = 0;
-	if (table->show_border) {
-		x += 1;
-		y += 1;
-		width -= 2;
-		height -= 2;
-		wborder(table->wg.win,
-			table->ls,table->rs,table->ts,table->bs,
-			table->tl,table->tr,table->bl,table->br);
-		
+		line = table_item_line(table,item);
+		cells = resort = changed = 0;
+		for (int col = 0; col < table->cols; col++) {
+			value = rows[i][col] ? rows[i][col] : "";
+			if (table_cell_equal(table,item,col,value))
+				continue;
+			if (table_item_set(table,item,col,value)) {
+				ret = -1;
+				break;
+			}
+			resort |= table_is_sort_key(table,col);
+			cells |= table_cell_bit(table,col);
+			changed++;
+		}
+		if (!changed)
+			continue;
+
+		table_item_reindex(table,item,resort);
+		if (line != table_item_line(table,item))
+			repaint = 1;
+		else if (!repaint)
+			table_redraw_cells(table,line,item,cells);
 	}
 
-	if (table->show_title){
-		y += 2;
-		height -= 2;
-		table_column_title(table,true);
+	/* 删除快照中不存在的行 */
+	for (node = table->items.next; node != &table->items; node = next) {
+		next = node->next;
+		item = container_of(node,struct table_item,node);
+		if (item->flags & TABLE_ITEM_SEEN) {
+			item->flags &= ~TABLE_ITEM_SEEN;
+			continue;
+		}
+		if (item == current)
+			current = NULL;
+		table_item_evict(table,item);
+		table_item_discard(table,item);
 	}
 
-	if (!x && !y) {
-		table->window = table->wg.win;
-		table->panel = table->wg.panel;
+	/* 选中行仍指向原来的行，并保持其在可视区域中的位置 */
+	if (current && (line = table_item_line(table,current)) >= 0) {
+		table->current_line = line;
+		table->start_line = line - offset > 0 ? line - offset : 0;
+	}
+	if (table_view_clamp(table))
+		repaint = 1;
+
+	if (repaint && table->wg.win)
+		table_refresh_raw(table,false);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return ret;
+}
+
+
+/**
+  * @brief    按行句柄删除一行
+  * @param    table : 目标表格
+  * @param    row   : 行句柄，删除后失效
+  * @return   成功返回0 
+*/
+int wg_table_row_delete(struct table *table,char **row)
+{
+	struct table_item *item;
+	int line;
+
+	assert(table && row);
+	if (table_is_virtual(table)) {
+		return -1;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	item = table_row_item(row);
+	line = table_item_unlink(table,item);
+	table_item_discard(table,item);
+	table_refresh_removed(table,line);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return 0;
+}
+
+
+/**
+  * @brief    跳转至指定行
+  * @param    table       : 指定表格
+  * @param    target_line : 目标行数
+*/
+int wg_table_jump_to(struct table *table,int target_line)
+{
+	int visible_height,lines;
+	lines = table_filtering(table) ? table->filter : table->lines;
+	if (lines < 1 || target_line == table->current_line) {
+		return 0;
+	}
+
+	if (target_line >= lines) {
+		target_line = lines - 1;
+	} else if (target_line < 0) {
+		target_line = 0;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	visible_height = table->wg.height - table->show_border - table->show_title ;
+	if (target_line + visible_height > lines) {
+		table->start_line = lines - visible_height;
 	} else {
-		table->window = derwin(table->wg.win,height,width,y,x);
-		table->panel = new_panel(table->window);
-		if (table->wg.bkg)
-			wbkgd(table->window,table->wg.bkg);
+		table->start_line = target_line;
+	}
+	table->current_line = target_line;
+	table_refresh_raw(table,false);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	if (table->sig.changed) {
+		table->sig.changed(table,table->sig.changed_arg);
+	}
+	return 0;
+}
+
+
+/**
+  * @brief    清空表格内容
+  * @param    table : 目标控件
+  * @return   成功返回0 
+*/
+int wg_table_clear(wg_table_t *table)
+{
+	struct wg_arena arena;
+	if (table && table_is_virtual(table)) {
+		return wg_table_virtual_reset(table);
 	}
 
-	/* 如果使能了列隐藏功能，新增 '/' 键响应 */
-	if (table->option & TABLE_COL_HIDE) {
-		static const struct wghandler hide_handlers[] = {
-			{'/' ,table_column_hide},
-			{0,0}
-		};
-		handlers_update(&table->wg,hide_handlers);
+	if (!table) {
+		return 0;
 	}
 
-	/* table 控件会创建子窗体，需更新动作响应函数 */
-	handlers_update(&table->wg,table_handlers);
-	table->wg.handle_mouse_event = table_mousedown;
-	table->wg.focus = table_focus;
-	table->wg.blur = table_blur;
-	table->wg.destroy = table_destroy;
-	table->wg.preclose = table_preclose;
-	table->wg.move = table_move;
-	table->wg.hide = table_hide;
-	table->wg.tips = tips;
+	table_load_finish(table,1);
+	if (!table->lines) {
+		return 0;
+	}
 
-	lines = table->keyword[0] ? table->filter : table->lines;
-	if (lines > 0) {
-		/* 放置前已有数据，刷新 */
-		NWIDGET_MUTEX_LOCK(table->mutex);
-		table_refresh_raw(table,false,false);
+	table_sort_cancel(table);
+	table_fuzzy_cancel(table);
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	table->current_line = -1;
+	table->lines = table->filter = 0;
+	if (table->fuzzy)
+		table->fuzzy->count = 0;
+	table_fuzzy_stale(table);
+	wg_arena_move(&arena,&table->arena);
+	wg_list_init(&table->items);
+	wg_list_init(&table->filter_items);
+	wg_list_init(&table->graveyard);
+	wg_list_init(&table->expire);
+	wg_rank_init(&table->index);
+	wg_rank_init(&table->filter_index);
+	table_filter_drop(table,0);
+	table_keys_reset(table);
+	table_types_reset(table);
+	table_aggs_reset(table,TABLE_AGGS_ALL | TABLE_AGGS_VIEW);
+	table_facets_reset(table);
+	werase(table->window);
+	table_refresh_aggs(table);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+
+	/* 所有行都在内存池中，整体释放 */
+	wg_arena_release(&arena);
+
+	if (table->sig.changed)
+		table->sig.changed(table,table->sig.changed_arg);
+	return 0;
+}
+
+
+/**
+  * @brief    将表格设置为虚拟表格，数据由数据源按需提供
+  * @param    table  : 目标表格，必须为空表格
+  * @param    source : 数据源 @see struct table_source
+  * @return   成功返回0 
+*/
+int wg_table_virtual(struct table *table,const struct table_source *source)
+{
+	if (!table || !source || !source->rows || !source->fill) {
+		return -1;
+	}
+
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (!wg_list_empty(&table->items)) {
 		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		return -1;
 	}
+
+	table_vcache_free(table);
+	table->source = *source;
+	table->lines = table->source.rows(table,table->source.arg);
+	if (table->lines < 0)
+		table->lines = 0;
+	table->start_line = 0;
+	table_refresh_raw(table,false);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
 	return 0;
 }
 
 
 /**
-  * @brief    初始化一个 table 控件
-  * @param    table  : table 句柄
-  * @param    height : 控件高度
-  * @param    width  : 控件宽度
-  * @param    flags  : 控件参数 @see enum table_flags
-  * @return   成功返回 0
+  * @brief    数据源异步填充单元格，可在其他线程中调用
+  * @param    table : 目标表格
+  * @param    line  : 目标行
+  * @param    col   : 目标列
+  * @param    value : 内容
+  * @return   成功返回0，该行已不在缓存中返回 -1
 */
-int wg_table_init(struct table *table,int height,int width,int flags)
+int wg_table_virtual_fill(struct table *table,int line,int col,const char *value)
 {
-	if (height < 1) {
+	struct table_vcache *cache;
+	struct table_vrow *row;
+	int visible_height,ret = -1;
+
+	assert(table && value);
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	cache = table->vcache;
+	if (!cache || line < 0 || col < 0 || col >= cache->cols) {
+		goto unlock;
+	}
+
+	/* 该行已被移出缓存，下次显示时会重新请求 */
+	row = cache->slot[line % cache->rows];
+	if (row->line != line) {
+		goto unlock;
+	}
+
+	strncpy(row->values[col],value,cache->size-1);
+	if (row->state[col]) {
+		row->state[col] = 0;
+		row->pending--;
+	}
+	ret = 0;
+
+	/* 所填充的行在可视区域内，刷新该行 */
+	visible_height = table->wg.height - table->show_border - table->show_title;
+	line -= table->start_line;
+	if (table->window && table->visible_cols && line >= 0 && line < visible_height) {
+		long attr = table->wg.editing ? A_FOCUS : A_UNFOCUS;
+		desktop_lock();
+		table_draw_row(table,line,row->values,row->line == table->current_line ? attr : 0);
+		if (!table->wg.hidden)
+			desktop_refresh();
+		desktop_unlock();
+	}
+unlock:
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return ret;
+}
+
+
+/**
+  * @brief    数据源的内容或总行数发生改变，丢弃缓存并重新请求可视行
+  * @param    table : 目标表格
+  * @return   成功返回0 
+*/
+int wg_table_virtual_reset(struct table *table)
+{
+	int visible_height,lines;
+	if (!table || !table_is_virtual(table)) {
 		return -1;
 	}
-	memset(table, 0, sizeof(struct table));
-	NWIDGET_MUTEX_INIT(table->mutex);
-	
-	wg_list_init(&table->column);
-	wg_list_init(&table->items);
-	wg_list_init(&table->filter_items);
 
-	table->current_col = -1;
-	table->current_line = -1;
-	table->wg.height = height;
-	table->wg.width = width;
-	table->option = flags;
-	table->show_title = (flags & TABLE_TITLE) ? 2 : 0;
-	table->show_border = (flags & TABLE_BORDER) ? 2 : 0;
-	table->show_footer = (flags & TABLE_FOOTER) == TABLE_FOOTER;
-	
-	wg_table_border(table,wgtheme.ls,wgtheme.rs,wgtheme.ts,wgtheme.bs,
-		wgtheme.tl,wgtheme.tr,wgtheme.bl,wgtheme.br);
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	if (table->vcache) {
+		for (int i = 0; i < table->vcache->rows; i++) {
+			table->vcache->slot[i]->line = -1;
+		}
+	}
+
+	lines = table->source.rows(table,table->source.arg);
+	table->lines = lines = lines < 0 ? 0 : lines;
+	visible_height = table->wg.height - table->show_border - table->show_title;
+	if (table->current_line >= lines)
+		table->current_line = lines - 1;
+	if (table->start_line + visible_height > lines)
+		table->start_line = lines > visible_height ? lines - visible_height : 0;
+
+	table_refresh_raw(table,false);
+	NWIDGET_MUTEX_UNLOCK(table->mutex);
+	return 0;
+}
+
+
+/**
+  * @brief    向当前批次追加字段内容
+  * @return   成功返回 0，内存不足返回 -1
+*/
+static int table_load_append(struct table_loader *ld,const char *str,size_t len)
+{
+	if (ld->cells_used + len + 1 > ld->cells_size) {
+		size_t size = (ld->cells_used + len + 1) * 2;
+		char *cells = realloc(ld->cells,size);
+		if (!cells) {
+			return -1;
+		}
+		ld->cells = cells;
+		ld->cells_size = size;
+	}
+	memcpy(ld->cells + ld->cells_used,str,len);
+	ld->cells_used += len;
 	return 0;
 }
 
 
 /**
-  * @brief    创建一个 table 控件
-  * @param    height : 控件高度
-  * @param    width  : 控件宽度
-  * @param    flags  : 控件参数 @see enum table_flags
-  * @return   成功返回 table 句柄，否则返回 0
+  * @brief    当前批次新增一个字段，之后的内容由 table_load_append() 追加
+  * @return   成功返回 0，内存不足返回 -1
 */
-struct table *wg_table_create(int height,int width,int flags)
+static int table_load_field(struct table_loader *ld)
 {
-	struct table *table = malloc(sizeof(struct table));
-	if (table == NULL) {
-		return NULL;
+	if (ld->nfields == ld->fields_size) {
+		int size = ld->fields_size * 2 + 64;
+		int *fields = realloc(ld->fields,sizeof(int) * size);
+		if (!fields) {
+			return -1;
+		}
+		ld->fields = fields;
+		ld->fields_size = size;
 	}
-	
-	if (0 != wg_table_init(table,height,width,flags) ) {
-		free(table);
-		return NULL;
+	ld->fields[ld->nfields++] = ld->cells_used;
+	return 0;
+}
+
+
+/**
+  * @brief    解析一条记录至当前批次，字段可用双引号包含分隔符和换行，"" 表示一个双引号
+  * @param    ld : 加载任务
+  * @param    ptr : 记录的起始位置
+  * @param    end : 数据末尾
+  * @param    eof : end 之后是否已无数据
+  * @return   成功返回记录所占的字节数，数据不完整返回 0，内存不足返回 -1
+*/
+static int table_load_record(struct table_loader *ld,const char *ptr,const char *end,int eof)
+{
+	const char *start = ptr,*next;
+	size_t cells_used = ld->cells_used;
+	int nfields = ld->nfields;
+	size_t len;
+
+	if (ld->nrecords + 1 >= ld->records_size) {
+		int size = ld->records_size * 2 + 64;
+		int *records = realloc(ld->records,sizeof(int) * size);
+		if (!records) {
+			return -1;
+		}
+		ld->records = records;
+		ld->records_size = size;
 	}
 
-	table->created_by = wg_table_create;
-	DEBUG_MSG("%s(%p)",__FUNCTION__,table);
-	return table;
+	/* 跳过空行 */
+	if (*ptr == '\n')
+		return 1;
+	if (end - ptr >= 2 && ptr[0] == '\r' && ptr[1] == '\n')
+		return 2;
+
+	for (;;) {
+		if (table_load_field(ld)) {
+			return -1;
+		}
+
+		if (ptr < end && *ptr == '"') {
+			/* 引号字段，查找闭合的引号 */
+			for (ptr++; ; ptr = next + 2) {
+				if (NULL == (next = memchr(ptr,'"',end - ptr)))
+					goto incomplete;
+				if (next + 1 == end && !eof)
+					goto incomplete;
+				if (table_load_append(ld,ptr,next - ptr + (next + 1 < end && next[1] == '"')))
+					return -1;
+				if (next + 1 >= end || next[1] != '"')
+					break;
+			}
+			ptr = next + 1;
+		}
+
+		/* 非引号内容直至分隔符或换行 */
+		next = wg_memchr3(ptr,end - ptr,ld->delim,'\n',ld->delim);
+		if (!next) {
+			if (!eof)
+				goto incomplete;
+			next = end;
+		}
+		len = next - ptr;
+		if ((next == end || *next == '\n') && len && ptr[len-1] == '\r')
+			len--;
+		if (table_load_append(ld,ptr,len)) {
+			return -1;
+		}
+		ld->cells[ld->cells_used++] = '\0';
+
+		if (next == end) {
+			ptr = end;
+			break;
+		}
+		ptr = next + 1;
+		if (*next == '\n') {
+			break;
+		}
+	}
+
+	ld->records[ld->nrecords++] = nfields;
+	ld->records[ld->nrecords] = ld->nfields;
+	return ptr - start;
+
+incomplete:
+	ld->cells_used = cells_used;
+	ld->nfields = nfields;
+	return 0;
 }
 
 
 /**
-  * @brief    设置 table 控件的边框显示字符
+  * @brief    以首行创建列，首行为列名时将其从当前批次移除
   * @return   成功返回 0
 */
-int wg_table_border(struct table *table,chtype ls,chtype  rs,
-	chtype  ts,chtype  bs,chtype  tl,chtype  tr,chtype  bl,chtype  br)
+static int table_load_columns(struct table_loader *ld)
 {
-	table->ls = ls ? ls : ACS_VLINE;
-	table->rs = rs ? rs : ACS_VLINE;
-	table->ts = ts ? ts : ACS_HLINE;
-	table->bs = bs ? bs : ACS_HLINE;
-	table->tl = tl ? tl : ACS_ULCORNER;
-	table->tr = tr ? tr : ACS_URCORNER;
-	table->bl = bl ? bl : ACS_LLCORNER;
-	table->br = br ? br : ACS_LRCORNER;
-	return 0;
+	struct table *table = ld->table;
+	int count,width,ret = 0,*widths;
+	char *value,**names;
+
+	count = ld->records[1] - ld->records[0];
+	if (!table->cols && count > 0) {
+		names = malloc(sizeof(char *) * count);
+		widths = malloc(sizeof(int) * count);
+		if (!names || !widths) {
+			free(names);
+			free(widths);
+			return -1;
+		}
+		for (int i = 0; i < count; i++) {
+			value = ld->cells + ld->fields[ld->records[0] + i];
+			width = wstrlen(value) + 2;
+			widths[i] = width < 8 ? 8 : (width > 40 ? 40 : width);
+			names[i] = (ld->flags & TABLE_LOAD_HEADER) ? value : NULL;
+		}
+		ret = wg_table_columns_add(table,names,widths,count);
+		free(names);
+		free(widths);
+	}
+
+	if (ld->flags & TABLE_LOAD_HEADER) {
+		/* 首行为列名，不作为数据行 */
+		memmove(ld->records,ld->records + 1,sizeof(int) * ld->nrecords);
+		ld->nrecords--;
+	}
+	return ret;
 }
 
 
 /**
-  * @brief    table 控件添加一列
-  * @param    table : table 句柄
-  * @param    column_name : 新列列名
-  * @param    width : 列显示宽度
+  * @brief    将当前批次整批加入表格，并刷新页脚的加载进度
+  * @param    ld : 加载任务
+  * @param    done : 已解析的字节数
   * @return   成功返回 0
 */
-int wg_table_column_add(struct table *table,char *column_name,int width)
+static int table_load_flush(struct table_loader *ld,long long done)
 {
-	int size = 0;
-	struct table_column *newcol;
+	struct table *table = ld->table;
+	char ***rows = NULL,**values = NULL;
+	int cols,count,ret = 0;
 
-	if (width < 1) {
-		return 0;
+	if (ld->first && ld->nrecords) {
+		ld->first = 0;
+		ret = table_load_columns(ld);
 	}
 
-	size = column_name ? strlen(column_name) : 0;
-	size += sizeof(struct table_column);
-	if (NULL == (newcol = malloc(size))) {
-		return -1;
+	cols = table->cols;
+	if (ld->nrecords && cols) {
+		rows = malloc(sizeof(char **) * ld->nrecords);
+		values = malloc(sizeof(char *) * ld->nrecords * cols);
+		if (!rows || !values) {
+			ret = -1;
+			goto cleanup;
+		}
+		for (int i = 0; i < ld->nrecords; i++) {
+			rows[i] = &values[i * cols];
+			count = ld->records[i+1] - ld->records[i];
+			for (int col = 0; col < cols; col++)
+				rows[i][col] = col < count ? ld->cells + ld->fields[ld->records[i] + col] : NULL;
+		}
+		ld->rows += wg_table_items_add_batch(table,rows,ld->nrecords);
 	}
-	memset(newcol,0,size);
-	if (column_name) 
-		strcpy(newcol->title,column_name);
-
-	newcol->width = (width > table->wg.width) ? table->wg.width-3 : width;
 
 	NWIDGET_MUTEX_LOCK(table->mutex);
-	wg_list_add_tail(&newcol->node,&table->column);
-	newcol->index = table->cols++;
-
-	/* 已经放置了的控件，进行显示 */
-	if (table->wg.win && table->visible_cols < TAB_MAX_COL) {
-		if (table->visible_cols)
-			visible_column_cleanup(table);
-		table->start_col = -1;
-		visible_column_checkout(table,0);
-		table_refresh_raw(table,true,false);
+	ld->done = done;
+	if (table->wg.win && table->show_footer && table->wg.width > 24) {
+		desktop_lock();
+		table_footer(table);
+		desktop_refresh();
+		desktop_unlock();
 	}
 	NWIDGET_MUTEX_UNLOCK(table->mutex);
-	return 0;
+
+cleanup:
+	free(rows);
+	free(values);
+	ld->cells_used = 0;
+	ld->nfields = 0;
+	ld->nrecords = 0;
+	return ret;
 }
 
 
 /**
-  * @brief    向表格添加一行
-  * @param    table  : 目标窗体
-  * @param    values : 行内容
-  * @return   成功返回 table_item 中的 values 数组 
+  * @brief    解析缓冲中的完整记录，每满一批加入表格
+  * @param    ld : 加载任务
+  * @param    buf : 数据
+  * @param    len : 数据长度
+  * @param    eof : buf 之后是否已无数据
+  * @param    done : buf 之前已解析的字节数
+  * @return   已解析的字节数，出错返回 -1
 */
-char **wg_table_item_add(struct table *table,char *values[])
+static long long table_load_parse(struct table_loader *ld,const char *buf,size_t len,int eof,long long done)
 {
-	char *value ;
-	int size,visible_height,display,lines;
-	struct table_item *newitem;
+	const char *ptr = buf,*end = buf + len;
+	int ret;
 
-	size = sizeof(struct table_item) ;
-	size += sizeof(char *) * table->cols; /* for table_item->values[] */
-	size += (table->wg.width * 2) * table->cols ; 
-	
-	if (!(newitem = (struct table_item *)malloc(size))) {
-		return NULL;
+	while (ptr < end && !ld->cancel) {
+		if ((ret = table_load_record(ld,ptr,end,eof)) < 0) {
+			return -1;
+		}
+		if (!ret) {
+			break;
+		}
+		ptr += ret;
+		if (ld->nrecords >= TABLE_LOAD_BATCH && table_load_flush(ld,done + (ptr - buf))) {
+			return -1;
+		}
 	}
-	memset(newitem,0,size);
+	return ptr - buf;
+}
 
-	value = (char *)&newitem->values[table->cols] ;
-	for (int i = 0 ; i < table->cols ; i++) {
-		newitem->values[i] = value;
-		if (values[i])
-			strncpy(value,values[i],table->wg.width*2-1);
-		value += table->wg.width * 2;
+
+/**
+  * @brief    从 fd 读取数据，等待期间可被取消
+  * @return   读取的字节数，已到末尾返回 0，出错或被取消返回 -1
+*/
+static long table_load_read(struct table_loader *ld,char *buf,size_t size)
+{
+	#ifndef _WIN32
+	struct pollfd pfd = {ld->fd,POLLIN,0};
+	while (!ld->cancel) {
+		int ret = poll(&pfd,1,100);
+		if (ret > 0)
+			break;
+		if (ret < 0)
+			return -1;
 	}
+	#endif
+	if (ld->cancel) {
+		return -1;
+	}
+	return read(ld->fd,buf,size);
+}
 
-	NWIDGET_MUTEX_LOCK(table->mutex);
 
-	wg_list_init(&newitem->node);
-	wg_list_init(&newitem->filter);
-	wg_list_add_tail(&newitem->node,&table->items);
+/**
+  * @brief    后台加载线程
+*/
+static void *table_load_entry(void *arg)
+{
+	struct table_loader *ld = arg;
+	struct table *table = ld->table;
+	size_t size = TABLE_LOAD_BUFFER,fill = 0;
+	long long done = 0,ret;
+	char *buf,*grow;
+	long len;
+	int eof = 0;
+
+	if (ld->map) {
+		/* 文件已映射至内存，直接解析 */
+		ret = table_load_parse(ld,ld->map,ld->map_size,1,0);
+		done = ret < 0 ? ld->done : ret;
+	} else if (NULL != (buf = malloc(size))) {
+		while (!ld->cancel && !eof) {
+			if ((len = table_load_read(ld,buf + fill,size - fill)) < 0)
+				break;
+			eof = (len == 0);
+			fill += len;
 
-	visible_height = table->wg.height - table->show_border;
-	lines = table->keyword[0] ? table->filter : table->lines;
-	display = lines - table->start_line;
-	table->lines++;
+			/* 解析完整的记录，不完整的记录留待下次读取后继续 */
+			if ((ret = table_load_parse(ld,buf,fill,eof,done)) < 0)
+				break;
+			done += ret;
+			fill -= ret;
+			memmove(buf,buf + ret,fill);
+			if (table_load_flush(ld,done))
+				break;
 
-	if (NULL == table->wg.win) {
-		/* 未放置的控件 */
-	} else if (table->visible_cols && display <= visible_height) {
-		/* 在可视区域添加行，进行内容刷新 */
-		char value[256];
-		int id,width,x = 0;
-		struct table_column **column = table->visible;
-		
-		/* 可见范围内新增行 */
-		desktop_lock();
-		for (int i = 0; i < table->visible_cols ; i++){
-			id = column[i]->index;
-			width = column[i]->display_width;
-			wstrncpy(value,newitem->values[id],width);
-			mvwaddstr(table->window,display,x,value);
-			x += width;
+			/* 一条记录超过缓冲大小 */
+			if (fill == size) {
+				if (NULL == (grow = realloc(buf,size * 2)))
+					break;
+				buf = grow;
+				size *= 2;
+			}
 		}
-		desktop_refresh();
-		desktop_unlock();
-
-		table_scrollbar_update(table);
-	} else {
-		/* 在不可视区域添加行，只需刷新滚动条 */
-		table_scrollbar_update(table);
+		free(buf);
 	}
 
+	/* 加载结束，加入剩余的行并清除进度显示 */
+	ld->running = 0;
+	table_load_flush(ld,done);
+	NWIDGET_MUTEX_LOCK(table->mutex);
+	table_refresh_raw(table,false);
 	NWIDGET_MUTEX_UNLOCK(table->mutex);
-	return newitem->values;
+	return NULL;
 }
 
 
 /**
-  * @brief    更新单元格的值
-  * @param    table  : 目标窗体
-  * @param    line   : 目标行
-  * @param    col    : 目标列
-  * @param    value  : 内容
-  * @return   成功返回0 
+  * @brief    等待后台加载结束并释放加载任务
+  * @param    table : 目标表格
+  * @param    cancel : 不为 0 时先取消加载
+  * @return   加载的行数，无加载任务返回 -1
+  * @note     调用时不得持有表格锁，加载线程需要加锁
 */
-int wg_table_cell_update(struct table *table,int line,int col,const char *value)
+static int table_load_finish(struct table *table,int cancel)
 {
-	int visible_height,is_current_line,x = 0;
-	WINDOW *win;
-	struct wg_list *node;
-	struct table_item *item;
-	struct table_column *column;
-	
-	assert(table && value);
-	if (line > table->lines || col > table->cols) {
+	struct table_loader *ld = table->loader;
+	int rows;
+
+	if (!ld) {
 		return -1;
 	}
+	if (cancel)
+		ld->cancel = 1;
+	wg_thread_join(ld->thread);
 
 	NWIDGET_MUTEX_LOCK(table->mutex);
-	node = table->items.next;
-	for (int i = 0; i < line ; i++) {
-		node = node->next;
-	}
-	item = container_of(node,struct table_item,node);
-	strncpy(item->values[col],value,table->wg.width*2);
-
-	/* 如果表格未放置，退出 */
-	if (NULL == (win = table->window)) {
-		goto cleanup;
-	}
-
-	/* 移动至指定列 */
-	node = table->column.next;
-	for (int i = 0; i < col ; i++) {
-		column = container_of(node,struct table_column,node);
-		node = node->next;
-		x += column->display_width;
-	}
-
-	column = container_of(node,struct table_column,node);
-	
-	/* 可视区域高度 */
-	visible_height = table->wg.height - table->show_border - table->show_title;
-	
-	/* 得到所更新行在可视区域的高度，如果在可视化区域内则进行更新 */
-	is_current_line = line == table->current_line;
-	line -= table->start_line;
-	if (line >= 0 && line < visible_height) {
-		char str[256];
-		long attr = table->wg.editing ? A_FOCUS : A_UNFOCUS;
-		int width = column->display_width;
-		
-		wstrncpy(str,value,width);
-
-		desktop_lock();
-		if (is_current_line) {
-			wattron(win,attr);
-			mvwhline(win,line,x,' ',width);
-			mvwaddstr(win,line,x,str);
-			wattroff(win,attr);
-		} else {
-			mvwhline(win,line,x,' ',width);
-			mvwaddstr(win,line,x,str);
-		}
-		
-		if (!table->wg.hidden)
-			desktop_refresh();
-		desktop_unlock();
-	}
-cleanup:
+	table->loader = NULL;
 	NWIDGET_MUTEX_UNLOCK(table->mutex);
-	return 0;
+
+	#ifndef _WIN32
+	if (ld->map)
+		munmap((void *)ld->map,ld->map_size);
+	#endif
+	if (ld->close_fd)
+		close(ld->fd);
+	rows = ld->rows;
+	free(ld->cells);
+	free(ld->fields);
+	free(ld->records);
+	free(ld);
+	return rows;
 }
 
 
 /**
-  * @brief    跳转至指定行
-  * @param    table       : 指定表格
-  * @param    target_line : 目标行数
+  * @brief    创建并启动加载任务
+  * @return   成功返回 0
 */
-int wg_table_jump_to(struct table *table,int target_line)
+static int table_load_start(struct table *table,int fd,int close_fd,int delim,int flags)
 {
-	int visible_height,lines;
-	lines = table->keyword[0] ? table->filter : table->lines;
-	if (lines < 1 || target_line == table->current_line) {
-		return 0;
+	struct table_loader *ld;
+	struct stat st;
+
+	if (!table || fd < 0 || table_is_virtual(table)) {
+		return -1;
 	}
+	table_load_finish(table,1);
 
-	if (target_line >= lines) {
-		target_line = lines - 1;
-	} else if (target_line < 0) {
-		target_line = 0;
+	if (NULL == (ld = calloc(1,sizeof(struct table_loader)))) {
+		return -1;
+	}
+	ld->table = table;
+	ld->fd = fd;
+	ld->close_fd = close_fd;
+	ld->delim = delim ? delim : ',';
+	ld->flags = flags;
+	ld->first = 1;
+	ld->running = 1;
+
+	if (!fstat(fd,&st) && S_ISREG(st.st_mode) && st.st_size > 0) {
+		ld->total = st.st_size;
+		#ifndef _WIN32
+		/* 普通文件直接映射至内存，省去读缓冲的拷贝 */
+		if (close_fd) {
+			void *map = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+			if (map != MAP_FAILED) {
+				ld->map = map;
+				ld->map_size = st.st_size;
+			}
+		}
+		#endif
 	}
 
 	NWIDGET_MUTEX_LOCK(table->mutex);
-	visible_height = table->wg.height - table->show_border - table->show_title ;
-	if (target_line + visible_height > lines) {
-		table->start_line = lines - visible_height;
-	} else {
-		table->start_line = target_line;
-	}
-	table->current_line = target_line;
-	table_refresh_raw(table,false,false);
+	table->loader = ld;
 	NWIDGET_MUTEX_UNLOCK(table->mutex);
-	if (table->sig.changed) {
-		table->sig.changed(table,table->sig.changed_arg);
+	if (NULL == (ld->thread = wg_thread_create(table_load_entry,ld))) {
+		NWIDGET_MUTEX_LOCK(table->mutex);
+		table->loader = NULL;
+		NWIDGET_MUTEX_UNLOCK(table->mutex);
+		#ifndef _WIN32
+		if (ld->map)
+			munmap((void *)ld->map,ld->map_size);
+		#endif
+		free(ld);
+		return -1;
 	}
 	return 0;
 }
 
 
 /**
-  * @brief    清空表格内容
-  * @param    table : 目标控件
+  * @brief    在后台线程中从文件加载 CSV/TSV 数据
+  * @param    table : 目标表格
+  * @param    path  : 文件路径
+  * @param    delim : 字段分隔符，如 ',' 或 '\t'，为 0 时使用 ','
+  * @param    flags : @see enum table_load_flags
   * @return   成功返回0 
 */
-int wg_table_clear(wg_table_t *table)
+int wg_table_load_file(struct table *table,const char *path,int delim,int flags)
 {
-	struct wg_list *node,*next;
-	if (!table || !table->lines) {
-		return 0;
+	int fd;
+	if (!path || (fd = open(path,O_RDONLY)) < 0) {
+		return -1;
 	}
+	if (table_load_start(table,fd,1,delim,flags)) {
+		close(fd);
+		return -1;
+	}
+	return 0;
+}
 
-	NWIDGET_MUTEX_LOCK(table->mutex);
-	table->current_line = -1;
-	table->lines = 0;
-	node = table->items.next;
-	wg_list_init(&table->items);
-	wg_list_init(&table->filter_items);
-	werase(table->window);
-	NWIDGET_MUTEX_UNLOCK(table->mutex);
 
-	while(node != &table->items){
-		next = node->next;
-		free(container_of(node,struct table_item,node));
-		node = next;
-	}
+/**
+  * @brief    在后台线程中从 fd(如管道) 加载 CSV/TSV 数据，读取至文件末尾
+  * @param    table : 目标表格
+  * @param    fd    : 文件描述符，加载结束后不会被关闭
+  * @param    delim : 字段分隔符，如 ',' 或 '\t'，为 0 时使用 ','
+  * @param    flags : @see enum table_load_flags
+  * @return   成功返回0 
+*/
+int wg_table_load_fd(struct table *table,int fd,int delim,int flags)
+{
+	return table_load_start(table,fd,0,delim,flags);
+}
 
-	if (table->sig.changed)
-		table->sig.changed(table,table->sig.changed_arg);
-	return 0;
-}
\ No newline at end of file
+
+/**
+  * @brief    等待后台加载结束
+  * @param    table : 目标表格
+  * @return   加载的行数，无加载任务返回 -1
+*/
+int wg_table_load_wait(struct table *table)
+{
+	return table ? table_load_finish(table,0) : -1;
+}
@@ -212,6 +212,39 @@ static int textarea_refresh(struct textarea *area)
 }
 
 
+/**
+  * @brief    在窗口末尾输出追加的文本，由窗口自行滚动
+  * @param    area : 目标窗体
+  * @param    str : 追加的文本
+  * @param    newline : 是否先补上原最后一行末尾未输出的换行符
+  * @note     仅在窗口处于滚动模式且光标停在内容末尾时可用，@see textarea_refresh()
+*/
+static void textarea_put_tail(struct textarea *area,const char *str,int newline)
+{
+	const char *cr;
+	size_t len = strlen(str),n;
+
+	/* 与 textarea_refresh() 一致，最后一行的换行符不输出 */
+	if (len && str[len-1] == '\n')
+		len--;
+
+	desktop_lock();
+	if (newline)
+		waddch(area->win,'\n');
+	while (len) {
+		cr = memchr(str,'\r',len);
+		n = cr ? (size_t)(cr - str) : len;
+		waddnstr(area->win,str,n);
+		if (!cr)
+			break;
+		len -= n + 1;
+		str = cr + 1;
+	}
+	desktop_refresh();
+	desktop_unlock();
+}
+
+
 static int textarea_redraw(struct nwidget *wg)
 {
 	return textarea_refresh(container_of(wg, struct textarea,wg));
@@ -477,14 +510,15 @@ static int textarea_destroy(struct nwidget *wg_entry)
   * @brief  文本显示追加
   * @param  area : 目标窗体
   * @param  str : 追加字符串
-  * @note   原理上 scrollok(WINDOW*) 后窗体可实现自动滚动,
-  *         但在有背景色的情况下追加 '\n' 的字符串会导致背景色割裂，
-  *         所以此处对字符串按照 '\n' 分割，并对每行的空白处进行空字符串填补
+  * @note   文本按 '\n' 分割储存；窗口停在底部时 scrollok(WINDOW*) 后直接在末尾输出，
+  *         由窗体自动滚动。背景色以 wbkgd() 设置，滚动露出的行和 '\n' 清除的行尾
+  *         均以背景填充，不会割裂
   * @return 返回是否需要刷新
 */
 int wg_textarea_append(struct textarea *area, const char *str)
 {
-	int scroll = 0,visible,len,height,append = 0;
+	int scroll = 0,visible,len,height,eol,append = 0;
+	const char *text = str;
 	char *tail;
 	struct textline *newline,*line;
 	struct wg_list *node;
@@ -501,6 +535,7 @@ int wg_textarea_append(struct textarea *area, const char *str)
 
 	/* 如果当前最后一行文本不是以 '\n' 结尾，把追加的 str 添加至最后一行文本后面 */
 	line = container_of(area->values.prev,struct textline,node);
+	eol = area->lines && line->end == '\n';
 	if (area->lines && line->end != '\n') {
 		tail = strchr(str, '\n');
 		len = tail ? (tail - str + 1) : strlen(str);
@@ -557,6 +592,11 @@ int wg_textarea_append(struct textarea *area, const char *str)
 
 	if (!area->win) {
 		/* 未放置的控件 */
+	} else if (visible && area->scrollok == 1) {
+		/* 窗口停在底部，直接在末尾输出新内容，滚动时只需输出新露出的行 */
+		textarea_put_tail(area,text,eol);
+		textarea_lines_info(area);
+		textarea_scrollbar_update(area);
 	} else if (!visible){
 		/* 在不可视区域内添加内容，只需刷新页脚和滚动条 */
 		textarea_lines_info(area);
@@ -200,6 +200,9 @@ typedef struct nwidget {
 	/* 请求在桌面刷新之后重绘制控件 */
 	int (*redraw)(struct nwidget *self);
 
+	/* 桌面每轮循环(至多间隔 REFRESH_DELAY_MS)调用一次，用于控件的定时任务，默认为 NULL */
+	int (*tick)(struct nwidget *self);
+
 	/** 当前控件所支持的快捷键 */
 	long shortcuts[MAX_HANDLERS];
 
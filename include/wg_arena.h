@@ -0,0 +1,71 @@
+/**
+  ******************************************************************************
+  * @file
+  * @author      GoodMorning
+  * @brief       分块内存池，按块连续分配，整体一次释放
+  ******************************************************************************
+  *
+  * COPYRIGHT(c) GoodMorning
+  *
+  ******************************************************************************
+  */
+#ifndef _WG_ARENA_H_
+#define _WG_ARENA_H_
+
+#include <stddef.h>
+#include "wg_list.h"
+
+/* Global  macro ------------------------------------------------------------*/
+
+/** 默认的块大小 */
+#define WG_ARENA_CHUNK (64 * 1024)
+
+/* Global  types ------------------------------------------------------------*/
+
+/** 内存池，分配的内存在块内连续存放 */
+struct wg_arena {
+	struct wg_list chunks;/**< 所有块，最后一块为当前分配的块 */
+	size_t chunk_size;/**< 块大小，超过块大小的分配单独成块 */
+	size_t reserved;/**< 向系统申请的总字节数 */
+	size_t live;/**< 仍在使用的字节数，不含已释放的 */
+};
+
+/* Global  variables --------------------------------------------------------*/
+/* Global  function prototypes ----------------------------------------------*/
+
+/**
+  * @brief    初始化内存池
+  * @param    chunk_size : 块大小，为 0 时使用 WG_ARENA_CHUNK
+*/
+void wg_arena_init(struct wg_arena *arena,size_t chunk_size);
+
+/**
+  * @brief    从内存池中分配内存
+  * @return   成功返回内存，否则返回 NULL
+*/
+void *wg_arena_alloc(struct wg_arena *arena,size_t size);
+
+/**
+  * @brief    释放一块由 wg_arena_alloc() 分配的内存
+  * @note     块内的内存全部释放后该块归还系统
+*/
+void wg_arena_free(struct wg_arena *arena,void *ptr);
+
+
+/**
+  * @brief    获取一块由 wg_arena_alloc() 分配的内存的可用大小，不小于申请的大小
+*/
+size_t wg_arena_size(void *ptr);
+
+/**
+  * @brief    将所有块移交给 dst，arena 变为空池，
+  *           用于在加锁时摘下内存，解锁后再调用 wg_arena_release(dst)
+*/
+void wg_arena_move(struct wg_arena *dst,struct wg_arena *arena);
+
+/**
+  * @brief    释放内存池中的所有内存，耗时只与块数有关
+*/
+void wg_arena_release(struct wg_arena *arena);
+
+#endif /* _WG_ARENA_H_ */
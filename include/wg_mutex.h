@@ -20,6 +20,11 @@ void wg_mutex_destroy(void *mutex);
 void wg_mutex_lock(void *mutex);
 void wg_mutex_unlock(void *mutex);
 
+void *wg_thread_create(void *(*entry)(void *),void *arg);
+void wg_thread_join(void *thread);
+int wg_cpu_count(void);
+long long wg_time_ms(void);/* 单调时钟，单位毫秒 */
+
 
 #define NWIDGET_MUTEX_INIT(x)   do{ (x) = wg_mutex_create();}while(0)
 #define NWIDGET_MUTEX_LOCK(x)   do{if (x) wg_mutex_lock(x);}while(0)
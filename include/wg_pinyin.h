@@ -0,0 +1,43 @@
+/**
+  ******************************************************************************
+  * @file
+  * @author      GoodMorning
+  * @brief       汉字拼音：汉字至拼音的对照表，生成含全拼和拼音首字母的检索键
+  ******************************************************************************
+  *
+  * COPYRIGHT(c) GoodMorning
+  *
+  ******************************************************************************
+  */
+#ifndef _WG_PINYIN_H_
+#define _WG_PINYIN_H_
+
+#include <stddef.h>
+
+/* Global  macro ------------------------------------------------------------*/
+/* Global  types ------------------------------------------------------------*/
+/* Global  variables --------------------------------------------------------*/
+/* Global  function prototypes ----------------------------------------------*/
+
+/**
+  * @brief    获取汉字的拼音，不含声调，ü 记为 u
+  * @param    ch : Unicode 码点，对照表覆盖 CJK 统一汉字 U+4E00 ~ U+9FA5
+  * @note     多音字取最常用的读音
+  * @return   小写拼音，不是汉字或没有读音返回 NULL
+*/
+const char *wg_pinyin(unsigned int ch);
+
+
+/**
+  * @brief    生成 UTF-8 字符串的检索键，以小写关键词在其中查找子串即可按拼音检索
+  * @param    str : 字符串
+  * @param    key : 输出缓冲，为 NULL 时只计算长度
+  * @param    size : 缓冲大小，包括结尾的 '\0'
+  * @note     含大写字母时为字符串的小写形式，含汉字时再接全拼和拼音首字母，各部分以 '\n' 分隔，
+  *           如 "张三A" 为 "张三a\nzhangsana\nzsa"，"张三" 为 "zhangsan\nzs"；
+  *           均不含时返回 0 且 key 为空字符串，以小写关键词在原字符串中查找即可
+  * @return   检索键的长度，不包括结尾的 '\0'
+*/
+size_t wg_pinyin_key(const char *str,char *key,size_t size);
+
+#endif /* _WG_PINYIN_H_ */
@@ -0,0 +1,97 @@
+/**
+  ******************************************************************************
+  * @file
+  * @author      GoodMorning
+  * @brief       带序号索引的平衡树(treap)，用于按行号 O(log n) 查找表格行
+  ******************************************************************************
+  *
+  * COPYRIGHT(c) GoodMorning
+  *
+  ******************************************************************************
+  */
+#ifndef _WG_RANK_H_
+#define _WG_RANK_H_
+
+/* Global  types ------------------------------------------------------------*/
+
+/** 平衡树节点，与 struct wg_list 一样嵌入到用户结构体中使用 */
+struct wg_rank_node {
+	struct wg_rank_node *parent,*left,*right;
+	unsigned int size;/**< 以当前节点为根的子树节点数 */
+	unsigned int prio;/**< treap 堆优先级 */
+};
+
+/** 平衡树，树的中序遍历顺序即为行顺序 */
+struct wg_rank_tree {
+	struct wg_rank_node *root;
+	unsigned int seed;/**< 生成优先级的随机种子 */
+};
+
+/** 节点比较函数，a < b 返回负数，相等返回 0 */
+typedef int (*wg_rank_cmp_t)(const struct wg_rank_node *a,const struct wg_rank_node *b,void *arg);
+
+/* Global  macro ------------------------------------------------------------*/
+/* Global  variables --------------------------------------------------------*/
+/* Global  function prototypes ----------------------------------------------*/
+
+/* 初始化一棵空树 */
+static inline void wg_rank_init(struct wg_rank_tree *tree)
+{
+	tree->root = NULL;
+	tree->seed = 0x2545f491;
+}
+
+/* 树的节点总数 */
+static inline int wg_rank_count(const struct wg_rank_tree *tree)
+{
+	return tree->root ? (int)tree->root->size : 0;
+}
+
+/* 节点是否已在树中，节点移出树后 size 置 0 */
+static inline int wg_rank_linked(const struct wg_rank_node *node)
+{
+	return node->size != 0;
+}
+
+/**
+  * @brief    获取第 index 个节点
+  * @return   成功返回节点，越界返回 NULL
+*/
+struct wg_rank_node *wg_rank_at(const struct wg_rank_tree *tree,int index);
+
+/**
+  * @brief    获取节点在树中的序号
+  * @return   节点序号，从 0 开始
+*/
+int wg_rank_of(const struct wg_rank_node *node);
+
+/**
+  * @brief    插入节点，使之成为树的第 index 个节点
+  * @note     index 大于等于节点总数时插入至末尾
+*/
+void wg_rank_insert_at(struct wg_rank_tree *tree,struct wg_rank_node *node,int index);
+
+/**
+  * @brief    按比较函数有序插入节点，相等的节点插入至其后
+  * @return   节点插入后的序号
+*/
+int wg_rank_insert(struct wg_rank_tree *tree,struct wg_rank_node *node,wg_rank_cmp_t cmp,void *arg);
+
+/**
+  * @brief    从树中删除节点
+*/
+void wg_rank_erase(struct wg_rank_tree *tree,struct wg_rank_node *node);
+
+/**
+  * @brief    以已排好序的节点数组重建整棵树，O(n)
+  * @param    nodes : 节点数组
+  * @param    n : 节点数
+*/
+void wg_rank_build(struct wg_rank_tree *tree,struct wg_rank_node **nodes,int n);
+
+struct wg_rank_node *wg_rank_first(const struct wg_rank_tree *tree);
+struct wg_rank_node *wg_rank_last(const struct wg_rank_tree *tree);
+struct wg_rank_node *wg_rank_next(const struct wg_rank_node *node);
+struct wg_rank_node *wg_rank_prev(const struct wg_rank_node *node);
+
+#endif /* _WG_RANK_H_ */
@@ -0,0 +1,64 @@
+/**
+  ******************************************************************************
+  * @file
+  * @author      GoodMorning
+  * @brief       检索相关：向量化子串查找，多线程分段执行
+  ******************************************************************************
+  *
+  * COPYRIGHT(c) GoodMorning
+  *
+  ******************************************************************************
+  */
+#ifndef _WG_SEARCH_H_
+#define _WG_SEARCH_H_
+
+#include <stddef.h>
+
+/* Global  macro ------------------------------------------------------------*/
+
+/** wg_parallel_for() 最多使用的线程数 */
+#define WG_PARALLEL_MAX 16
+
+/* Global  types ------------------------------------------------------------*/
+/* Global  variables --------------------------------------------------------*/
+/* Global  function prototypes ----------------------------------------------*/
+
+/**
+  * @brief    在 haystack 中查找子串 needle
+  * @param    haystack : 被查找的内存
+  * @param    hlen : haystack 长度
+  * @param    needle : 子串
+  * @param    nlen : 子串长度
+  * @note     运行时根据 CPU 选择 AVX2/SSE2 实现，否则使用标量实现
+  * @return   找到返回子串在 haystack 中的位置，否则返回 NULL
+*/
+const char *wg_memmem(const char *haystack,size_t hlen,const char *needle,size_t nlen);
+
+
+/**
+  * @brief    查找 a,b,c 三个字符中最先出现的一个，用于分隔符与引号的扫描
+  * @param    s : 被查找的内存
+  * @param    len : s 的长度
+  * @note     与 wg_memmem() 使用同一套 AVX2/SSE2/标量实现
+  * @return   找到返回其位置，否则返回 NULL
+*/
+const char *wg_memchr3(const char *s,size_t len,int a,int b,int c);
+
+
+/**
+  * @brief    当前 wg_memmem() 所使用的实现
+  * @return   "avx2","sse2" 或 "scalar"
+*/
+const char *wg_memmem_impl(void);
+
+
+/**
+  * @brief    将 [0,count) 分段交由多个线程并行执行，返回时所有分段已执行完毕
+  * @param    count : 总数
+  * @param    min_chunk : 每个线程最少处理的数目，总数较少时只在当前线程执行
+  * @param    func : 分段处理函数，处理 [start,end)
+  * @param    arg : func 的参数
+*/
+void wg_parallel_for(int count,int min_chunk,void (*func)(void *arg,int start,int end),void *arg);
+
+#endif /* _WG_SEARCH_H_ */
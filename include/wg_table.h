@@ -18,13 +18,21 @@
 /* Includes -----------------------------------------------------------------*/
 #include "nwidget.h"
 #include "wg_list.h"
+#include "wg_rank.h"
+#include "wg_arena.h"
 
 /* Global macro -------------------------------------------------------------*/
 
 #define VISIBLE_PANEL (1)
 
-/* 表格可视窗口同时可显示的最大列数，超过这个列数将需要用 ctrl+left 和 ctrl+right 横向滚动显示 */
-#define TAB_MAX_COL     16
+/* 过滤结果的缓存层数，关键词增长时在上一层结果中检索，回退时直接复用 */
+#define TABLE_FILTER_DEPTH 8
+
+/* 多列排序时最多的排序键数 */
+#define TABLE_SORT_KEYS 4
+
+/* 模糊匹配默认保留的行数 @see wg_table_fuzzy() */
+#define TABLE_FUZZY_TOPK 200
 
 
 enum table_flags {
@@ -35,14 +43,119 @@ enum table_flags {
 	TABLE_JUMPTO = 0x10,
 	TABLE_FILTER = 0x20,
 	TABLE_COL_HIDE = 0x40,
+	TABLE_FACET = 0x80,
+};
+
+/** 虚拟表格单元格占位符，在数据源异步填充完成前显示 */
+#define TABLE_PLACEHOLDER "..."
+
+/** 虚拟表格数据源 fill() 的返回值 */
+enum table_fill_state {
+	TABLE_FILL_DONE = 0,/**< 单元格已填充 */
+	TABLE_FILL_PENDING = 1,/**< 数据稍后由 wg_table_virtual_fill() 异步给出 */
+};
+
+/** 排序时单元格的比较方式 */
+enum table_sort_type {
+	TABLE_SORT_STRING = 0,/**< 按字节比较 */
+	TABLE_SORT_INT,/**< 按整数比较 */
+	TABLE_SORT_FLOAT,/**< 按浮点数比较 */
+	TABLE_SORT_COLLATE,/**< 按当前 locale 的排序规则比较(strcoll)，适用于 UTF-8 文本 */
+};
+
+/** 后台加载的参数 @see wg_table_load_file() */
+enum table_load_flags {
+	TABLE_LOAD_HEADER = 0x01,/**< 首行为列名：表格无列时以其创建列，已有列时跳过首行 */
+};
+
+/** 列的数据类型 @see wg_table_column_type() */
+enum table_column_type {
+	TABLE_COL_STRING = 0,/**< 字符串，默认 */
+	TABLE_COL_INT,/**< 64 位整数 */
+	TABLE_COL_DOUBLE,/**< 浮点数 */
+	TABLE_COL_TIME,/**< 时间戳，自 1970-01-01 起的秒数 */
+	TABLE_COL_ENUM,/**< 枚举序号，默认显示为 arg 所指的以 NULL 结尾的名称数组中的名称 */
+	TABLE_COL_DICT,/**< 字典编码的字符串，适用于取值种类少的列，相同的字符串只存放一份 */
+};
+
+/** 页脚的列聚合 @see wg_table_aggregate() */
+enum table_aggregate {
+	TABLE_AGG_NONE = 0,
+	TABLE_AGG_SUM,/**< 数值之和 */
+	TABLE_AGG_MIN,/**< 最小值 */
+	TABLE_AGG_MAX,/**< 最大值 */
+	TABLE_AGG_MEAN,/**< 数值的平均值 */
+	TABLE_AGG_COUNT,/**< 非空单元格数 */
+};
+
+/** 表格行状态 */
+enum table_item_flags {
+	TABLE_ITEM_DIRTY = 0x01,/**< 后台排序期间排序键被修改，排序完成后需重新插入 */
+	TABLE_ITEM_DELETED = 0x02,/**< 后台排序期间被删除，排序完成后释放 */
+	TABLE_ITEM_SEEN = 0x04,/**< wg_table_apply_snapshot() 中在快照里找到的行 */
+	TABLE_ITEM_CHANGED = 0x08,/**< 模糊匹配的候选行快照生成后被修改，快照中的文本已过期 */
 };
 
 /* Global type  -------------------------------------------------------------*/
 
-/** 表格每行的内容，双向链表 */
+/** 类型列的单元格值，整数、时间戳和枚举使用 i，浮点数使用 f */
+union table_value {
+	long long i;
+	double f;
+};
+
+/** 类型列的显示格式化函数，只对可视的单元格调用
+    @return 写入 buf 的长度，buf 以 '\0' 结尾 */
+typedef int (*table_format_t)(char *buf,int size,union table_value value,void *arg);
+
+/** 排序键 */
+struct table_sort_key {
+	int col;/**< 列序号 */
+	int type;/**< 比较方式 @see enum table_sort_type */
+	int descending;/**< 不为 0 时降序 */
+};
+
+struct table;
+struct table_sort_job;
+struct table_vcache;
+struct table_rcache;
+struct table_loader;
+struct table_filter_level;
+struct table_keys;
+struct table_types;
+struct table_aggs;
+struct table_where;
+struct table_fuzzy;
+struct table_search;
+struct table_facets;
+
+/** 
+  * 虚拟表格数据源，表格不保存行数据，只在显示时向数据源请求可视范围内的行.
+  * 回调函数在表格加锁时调用，回调内不得再调用该表格的 wg_table_* 接口
+*/
+struct table_source {
+	/** 返回数据源的总行数 */
+	int (*rows)(struct table *table,void *arg);
+
+	/** 将第 line 行第 col 列的内容填入 value(缓冲大小为 size)，
+	    返回 TABLE_FILL_DONE 或 TABLE_FILL_PENDING @see enum table_fill_state */
+	int (*fill)(struct table *table,int line,int col,char *value,int size,void *arg);
+	void *arg;
+};
+
+/** 表格每行的内容，双向链表；各单元格只占用实际长度 */
 struct table_item {
 	struct wg_list node;
 	struct wg_list filter;
+	struct wg_list expire;/**< 在 table->expire 中的节点 */
+	struct table_item *key_next;/**< 键索引中同一桶的下一行 */
+	struct wg_rank_node rank;/**< 在 table->index 中的节点，用于按行号查找 */
+	struct wg_rank_node filter_rank;/**< 在 table->filter_index 中的节点 */
+	unsigned int seq;/**< 插入序号，即未排序时的顺序 */
+	unsigned int flags;/**< @see enum table_item_flags */
+	int slot;/**< 在类型列数组中的下标，表格没有类型列时为 -1 */
+	long long touched;/**< 最近一次加入或更新的时间(ms)，@see wg_time_ms() */
+	char *heap;/**< 单元格内容变长后重新打包的存储，为 NULL 时内容紧随 values[] 存放 */
 	char *values[1];
 };
 
@@ -68,30 +181,70 @@ typedef struct table {
 
 	struct wg_list items;
 	struct wg_list filter_items;
+	struct wg_list graveyard;/**< 后台排序期间删除的行 */
+	struct wg_list expire;/**< 按最近一次加入或更新的时间排列的行，最早的在队首 */
 	struct wg_list column;
 
+	struct wg_rank_tree index;/**< items 的行号索引 */
+	struct wg_rank_tree filter_index;/**< filter_items 的行号索引 */
+
+	unsigned int seq;/**< 下一个新增行的插入序号 */
+
+	/** 行内存池，所有行及其单元格都在其中分配，清空表格时整体释放；
+	    arena.reserved 为已申请的字节数，arena.live 为仍在使用的字节数 */
+	struct wg_arena arena;
+
+	/** 排序，index/filter_index 按排序键的顺序排列，items 始终保持插入顺序 */
+	struct table_sort_key sort_keys[TABLE_SORT_KEYS];
+	int sort_nkeys;/**< 排序键数，为 0 时按插入顺序显示 */
+	int sort_pending;/**< 后台排序进行中，index 仍为旧的顺序 */
+	int sort_generation;/**< 每次请求排序时递增，用于丢弃过期的排序结果 */
+	struct table_sort_job *sort_job;/**< 进行中的后台排序 */
+	void *sort_thread;
+
+	struct table_source source;/**< 虚拟表格数据源，@see wg_table_virtual() */
+	struct table_vcache *vcache;/**< 虚拟表格的可视行缓存 */
+	struct table_rcache *rcache;/**< 已截断至列宽的行显示内容缓存 */
+	struct table_loader *loader;/**< 后台加载任务 @see wg_table_load_file() */
+	struct table_keys *keys;/**< 键列的哈希索引 @see wg_table_key() */
+	struct table_types *types;/**< 类型列的值，按列存放 @see wg_table_column_type() */
+	struct table_aggs *aggs;/**< 页脚的列聚合 @see wg_table_aggregate() */
+	struct table_where *where;/**< 列条件过滤 @see wg_table_where() */
+	struct table_fuzzy *fuzzy;/**< 模糊匹配 @see wg_table_fuzzy() */
+	struct table_search *search;/**< 检索索引列 @see wg_table_column_search() */
+	struct table_facets *facets;/**< 分面列 @see wg_table_facet() */
+	unsigned int layout;/**< 可视列布局的版本，列宽或可视列改变时递增 */
+
 	WINDOW *window;/**< 可视区域子窗口 */
 	
 	#ifdef VISIBLE_PANEL
 		PANEL *panel;/**< 可视区域子窗口面板 */
 	#endif
 	
-	struct table_column *visible[TAB_MAX_COL];/**< 当前表格窗口的可视列 */
+	struct table_column **shown;/**< 未隐藏的列，按列顺序排列，增加列或改变隐藏状态时重建 */
+	int shown_cols;/**< shown[] 的列数 */
+	struct table_column **visible;/**< 当前表格窗口的可视列，为 shown[] 中自 start_col 起的一段 */
 	int visible_cols;/**< 当前表格窗口的可视列列数 */
 
 	char keyword[128];/**< 表格条目过滤词 */
-	int filter;
+	int filter;/**< 过滤后的行数 */
+	int filter_depth;/**< filter_cache 的层数 */
+	struct table_filter_level *filter_cache[TABLE_FILTER_DEPTH];/**< 过滤结果缓存 */
 	int option;
 	int show_footer;
 	int show_title;/**< 显示列标题 */
 	int show_border;/**< 显示边框 */
 	int show_scrollbar;
 	int lines;/**< 当前表格总条目行数 */
+	int max;/**< 最大行数，超过时淘汰最早加入的行，为 0 时不限制 */
+	int ttl;/**< 行的存活时间(ms)，为 0 时不过期 */
+	int (*evicted)(struct table *table,char **row,void *arg);/**< 行被淘汰前的回调 @see wg_table_on_evict() */
+	void *evicted_arg;
 	int cols;/**< 当前表格总列数 */
 	int current_line;/**< 当前选中行 */
 	int current_col;/**< 当前选中列 */
 	int start_line;/**< 当前界面下第一条显示的行 */
-	int start_col;/**< 当前界面下第一条显示的列 */
+	int start_col;/**< 当前界面下第一条显示的列，为 shown[] 的下标 */
 	int has_prev_column,has_next_column;
 	chtype ls, rs, ts, bs, tl, tr, bl, br;
 	
@@ -128,7 +281,7 @@ int wg_table_put(struct table *table,struct nwidget *parent,int y,int x);
 
 /**
   * @brief    table 控件添加一列
-  * @param    table  : table 句柄
+  * @param    table : table 句柄
   * @param    column_name : 新列列名
   * @param    width : 列显示宽度
   * @return   成功返回 0
@@ -137,14 +290,55 @@ int wg_table_column_add(struct table *table,char *column_name,int width);
 
 
 /**
-  * @brief    table 控件搜索检出
+  * @brief    table 控件一次添加多列，只计算一次可视列并刷新一次
+  * @param    table : table 句柄
+  * @param    column_names : 各列列名
+  * @param    widths : 各列显示宽度，小于 1 的列被忽略
+  * @param    n : 列数
+  * @return   成功返回 0
+*/
+int wg_table_columns_add(struct table *table,char *column_names[],const int widths[],int n);
+
+
+/**
+  * @brief    table 控件搜索检出，任意一列包含关键词的行被检出
   * @param    table  : table 句柄
-  * @param    filter : 关键词，检索词
-  * @return   成功返回 检出数
+  * @param    filter : 关键词，检索词，为空字符串或 NULL 时取消过滤
+  * @note     关键词在上一次关键词的基础上增长时只检索上一次的结果，
+  *           回退至之前输入过的关键词时复用缓存的结果；
+  *           过滤期间新增的行会即时检索并加入过滤结果
+  * @return   成功返回 检出数，失败返回 -1
 */
 int wg_table_filter(struct table *table,const char *filter);
 
 
+/**
+  * @brief    按列条件过滤，与关键词过滤同时生效，结果同样显示于过滤视图
+  * @param    table : 目标表格
+  * @param    expr  : 条件表达式，为空字符串或 NULL 时取消条件过滤
+  * @note     比较为 列 op 值，op 为 = == != < <= > >=，或 列 in (值,值...)；
+  *           列为列名或 $列序号；未加引号的数值按数值比较，否则按字符串比较；
+  *           比较之间以 && || ! 和括号组合，如 cpu>=10 && state in (R,D)
+  * @return   成功返回检出数，表达式有误或内存不足返回 -1
+*/
+int wg_table_where(struct table *table,const char *expr);
+
+
+/**
+  * @brief    模糊匹配，按得分从高到低只显示得分最高的 top_k 行
+  * @param    table   : 目标表格
+  * @param    pattern : 匹配串，各字符依次出现在一行中即为匹配，为空字符串或 NULL 时取消
+  * @param    top_k   : 保留的行数，为 0 时使用 TABLE_FUZZY_TOPK
+  * @note     与 fzf 相近，连续匹配和位于单词开头、驼峰处的字符得分更高；
+  *           匹配串含大写字母时区分大小写。只在满足关键词和条件过滤的行中匹配。
+  *           计分在后台线程中分段并行进行，完成后替换过滤视图，期间显示上一次的结果；
+  *           再次调用会取消进行中的检索。匹配期间新增或修改的行即时计分，
+  *           视图中的行被删除或不再匹配后在后台重新检索，补足 top_k 行
+  * @return   成功返回0 
+*/
+int wg_table_fuzzy(struct table *table,const char *pattern,int top_k);
+
+
 static inline int wg_table_current_line(struct table *table)
 {
 	return table->current_line;
@@ -159,6 +353,75 @@ int wg_table_border(struct table *table,chtype ls,chtype  rs,
 	chtype  ts,chtype  bs,chtype  tl,chtype  tr,chtype  bl,chtype  br);
 
 
+/**
+  * @brief    将一列设为类型列，其值按列存放，只在绘制可视单元格时格式化
+  * @param    table  : 目标表格，必须为空表格
+  * @param    col    : 目标列，不能为键列
+  * @param    type   : 列类型 @see enum table_column_type
+  * @param    format : 格式化函数，为 NULL 时按类型使用默认格式
+  * @param    arg    : 格式化函数的参数，TABLE_COL_ENUM 的默认格式为名称数组
+  * @note     以字符串加入或更新类型列时按类型解析一次；排序按原始值比较，
+  *           过滤按格式化后的内容检索。
+  *           TABLE_COL_DICT 不使用 format，各行只存放编码，排序按字符串比较，
+  *           过滤时每个不同的字符串只检索一次；字典随表格清空而清空
+  * @return   成功返回0 
+*/
+int wg_table_column_type(struct table *table,int col,int type,table_format_t format,void *arg);
+
+
+/**
+  * @brief    设置一列在页脚显示的聚合，需要 TABLE_FOOTER
+  * @param    table : 目标表格
+  * @param    col   : 目标列
+  * @param    agg   : 聚合方式 @see enum table_aggregate，TABLE_AGG_NONE 为取消
+  * @note     字符串按开头的数值参与计算，非数值只计入 TABLE_AGG_COUNT；
+  *           随行的增删改增量更新，过滤时为过滤视图中的行的聚合
+  * @return   成功返回0 
+*/
+int wg_table_aggregate(struct table *table,int col,int agg);
+
+
+/**
+  * @brief    获取一列在当前视图下的聚合结果
+  * @param    value : 输出聚合结果
+  * @return   成功返回0，未设置聚合或没有数值时返回 -1
+*/
+int wg_table_aggregate_value(struct table *table,int col,double *value);
+
+
+/**
+  * @brief    设置一列是否维护分面，即各个不同值的行数，随行的增删改增量更新
+  * @param    table  : 目标表格
+  * @param    col    : 目标列
+  * @param    enable : 为 0 时取消
+  * @note     创建时带 TABLE_FACET 的表格按 'f' 弹出首个可视的分面列的各个值及其行数，
+  *           选中一个值即按该值进行条件过滤 @see wg_table_where()，选中第一行取消
+  * @return   成功返回0 
+*/
+int wg_table_facet(struct table *table,int col,int enable);
+
+
+/**
+  * @brief    获取分面列中一个值的行数
+  * @param    value : 单元格的显示内容
+  * @return   行数，该列未设置分面时返回 -1
+*/
+long long wg_table_facet_count(struct table *table,int col,const char *value);
+
+
+/**
+  * @brief    设置一列是否建立检索索引，行加入时为单元格生成检索键，可按拼音检索中文
+  * @param    table  : 目标表格
+  * @param    col    : 目标列，须为字符串列
+  * @param    enable : 为 0 时取消
+  * @note     检索键含小写形式、全拼和拼音首字母 @see wg_pinyin_key()，
+  *           如输入 "zs" 或 "zhangsan" 均可检出 "张三"；
+  *           多音字只取常用读音，ü 以 u 输入
+  * @return   成功返回0 
+*/
+int wg_table_column_search(struct table *table,int col,int enable);
+
+
 /**
   * @brief    向表格添加一行
   * @param    field  : 目标窗体
@@ -168,6 +431,55 @@ int wg_table_border(struct table *table,chtype ls,chtype  rs,
 char **wg_table_item_add(struct table *table,char *values[]) ;
 
 
+/**
+  * @brief    向表格一次添加多行，只加锁一次，所有行加入后只刷新一次
+  * @param    table  : 目标表格
+  * @param    rows : 各行内容，rows[i] 同 wg_table_item_add() 的 values
+  * @param    n : 行数
+  * @return   成功加入的行数
+*/
+int wg_table_items_add_batch(struct table *table,char **rows[],int n);
+
+
+/**
+  * @brief    设置表格的最大行数，超过时淘汰最早加入的行，被淘汰的行的存储用于新行
+  * @param    table : 目标表格
+  * @param    max_rows : 最大行数，为 0 时不限制
+  * @note     被淘汰的行的句柄随即失效，其存储可能已属于新行 @see wg_table_on_evict()
+  * @return   成功返回0 
+*/
+int wg_table_max_rows(struct table *table,int max_rows);
+
+
+/**
+  * @brief    设置行的存活时间，行在最近一次加入或更新后超过该时间即被删除
+  * @param    table : 目标表格
+  * @param    ttl_ms : 存活时间(毫秒)，为 0 时不过期
+  * @note     放置于桌面的表格在桌面每轮循环中自动删除过期的行，过期的行的句柄随即失效
+  * @return   成功返回0 
+*/
+int wg_table_ttl(struct table *table,int ttl_ms);
+
+
+/**
+  * @brief    删除所有已过期的行，只刷新一次
+  * @param    table : 目标表格
+  * @return   删除的行数
+*/
+int wg_table_expire(struct table *table);
+
+
+/**
+  * @brief    设置行被淘汰前的回调，超过最大行数、过期或不在快照中的行被删除前调用
+  * @param    table : 目标表格
+  * @param    evicted : 回调函数，row 为被淘汰的行句柄，回调返回后失效；为 NULL 时取消
+  * @param    arg : 回调参数
+  * @note     回调时表格已加锁，回调中不能再调用该表格的接口
+  * @return   成功返回0 
+*/
+int wg_table_on_evict(struct table *table,int (*evicted)(struct table *table,char **row,void *arg),void *arg);
+
+
 /**
   * @brief    跳转至指定行
   * @param    field       : 指定表格
@@ -188,6 +500,7 @@ int table_clear(struct table *table);
   * @brief    获取表格行数据
   * @param    field   : 目标表格
   * @param    line    : 指定行
+  * @note     类型列的单元格为空字符串，使用 wg_table_value() 或 wg_table_row_get()
   * @return   行数据，如 values[0] 为指定行第一列数据
 */
 char **wg_table_values(struct table *field,int line);
@@ -198,6 +511,7 @@ char **wg_table_values(struct table *field,int line);
   * @param    field   : 目标表格
   * @param    line    : 指定行
   * @param    column  : 指定列
+  * @note     类型列返回格式化后的内容，存放于表格内的缓冲，下次调用前有效
   * @return   单元数据
 */
 char *wg_table_value(struct table *field,int line,int column);
@@ -209,11 +523,100 @@ char *wg_table_value(struct table *field,int line,int column);
   * @param    lines  : 目标行
   * @param    cols   : 目标列
   * @param    value  : 内容
+  * @note     内容变长时该行的单元格会被重新存放，此前取得的 values[i] 指针失效，
+  *           wg_table_item_add() 返回的 values 数组本身仍有效
   * @return   成功返回0 
 */
 int wg_table_cell_update(struct table *table,int lines,int cols,const char *value);
 
 
+/**
+  * @brief    按行句柄更新单元格的值，行被排序或过滤移动后句柄仍有效
+  * @param    table : 目标表格
+  * @param    row   : 行句柄，即 wg_table_item_add() 的返回值
+  * @param    col   : 目标列
+  * @param    value : 内容
+  * @return   成功返回0 
+*/
+int wg_table_row_update(struct table *table,char **row,int col,const char *value);
+
+
+/**
+  * @brief    按行句柄删除一行
+  * @param    table : 目标表格
+  * @param    row   : 行句柄，删除后失效
+  * @return   成功返回0 
+*/
+int wg_table_row_delete(struct table *table,char **row);
+
+
+/**
+  * @brief    获取行句柄在当前视图(过滤/排序)中的行号
+  * @param    table : 目标表格
+  * @param    row   : 行句柄
+  * @return   行号，被过滤时返回 -1
+*/
+int wg_table_row_line(struct table *table,char **row);
+
+
+/**
+  * @brief    按行句柄设置类型列的值，不经过字符串
+  * @param    table : 目标表格
+  * @param    row   : 行句柄
+  * @param    col   : 类型列 @see wg_table_column_type()
+  * @param    value : 值，字典列为字典中已有字符串的编码
+  * @return   成功返回0 
+*/
+int wg_table_row_set(struct table *table,char **row,int col,union table_value value);
+
+
+/**
+  * @brief    按行句柄获取类型列的值
+  * @return   成功返回0，不是类型列返回 -1
+*/
+int wg_table_row_get(struct table *table,char **row,int col,union table_value *value);
+
+
+/**
+  * @brief    指定键列并建立哈希索引，用于 wg_table_upsert() 和 wg_table_find()
+  * @param    table : 目标表格
+  * @param    col   : 键列，为 -1 时删除索引
+  * @return   成功返回0 
+*/
+int wg_table_key(struct table *table,int col);
+
+
+/**
+  * @brief    按键列查找行，存在则只更新内容改变的单元格，否则添加新行
+  * @param    table  : 目标表格，需先以 wg_table_key() 指定键列
+  * @param    values : 行内容，同 wg_table_item_add()
+  * @return   成功返回行句柄 @see wg_table_row_update()
+*/
+char **wg_table_upsert(struct table *table,char *values[]);
+
+
+/**
+  * @brief    按键查找行在当前视图中的行号
+  * @param    table : 目标表格
+  * @param    key   : 键列的内容
+  * @return   行号，不存在或被过滤时返回 -1
+*/
+int wg_table_find(struct table *table,const char *key);
+
+
+/**
+  * @brief    以一份完整快照替换表格内容，按键列比较，只增删改变的行和单元格
+  * @param    table : 目标表格
+  * @param    rows  : 快照的各行，rows[i] 同 wg_table_item_add() 的 values
+  * @param    n     : 快照行数
+  * @param    key_col : 键列，表格的键索引不是该列时重建 @see wg_table_key()
+  * @note     选中行仍指向原来的行；没有增删行或行移动时只重绘改变的单元格；
+              被删除的行的句柄随即失效 @see wg_table_on_evict()
+  * @return   成功返回0，内存不足时部分行未能更新或加入，返回 -1
+*/
+int wg_table_apply_snapshot(struct table *table,char **rows[],int n,int key_col);
+
+
 /**
   * @brief    清空表格内容
   * @param    table : 目标控件
@@ -221,4 +624,81 @@ int wg_table_cell_update(struct table *table,int lines,int cols,const char *valu
 */
 int wg_table_clear(wg_table_t *table);
 
+
+/**
+  * @brief    按一列或多列排序
+  * @param    table : 目标表格
+  * @param    keys  : 排序键，keys[0] 为主键 @see struct table_sort_key
+  * @param    nkeys : 排序键数，不超过 TABLE_SORT_KEYS；为 0 时恢复插入顺序
+  * @note     排序在后台线程中进行，完成后一次性替换显示顺序，期间表格可正常操作；
+  *           排序后新增的行和排序键被修改的行会被直接插入到有序位置，为 O(log n)，
+  *           选中行仍指向原来的行，只重绘显示位置改变了的行；
+  *           对空表格排序即可使表格在行持续加入时始终保持有序，如排行榜
+  * @return   成功返回0 
+*/
+int wg_table_sort(struct table *table,const struct table_sort_key *keys,int nkeys);
+
+
+/**
+  * @brief    将表格设置为虚拟表格，数据由数据源按需提供
+  * @param    table  : 目标表格，必须为空表格
+  * @param    source : 数据源 @see struct table_source
+  * @note     虚拟表格不支持 wg_table_item_add() 和过滤，
+  *           wg_table_values() 返回的数据在行被移出缓存前有效
+  * @return   成功返回0 
+*/
+int wg_table_virtual(struct table *table,const struct table_source *source);
+
+
+/**
+  * @brief    数据源异步填充单元格，可在其他线程中调用
+  * @param    table : 目标表格
+  * @param    line  : 目标行
+  * @param    col   : 目标列
+  * @param    value : 内容
+  * @return   成功返回0，该行已不在缓存中返回 -1
+*/
+int wg_table_virtual_fill(struct table *table,int line,int col,const char *value);
+
+
+/**
+  * @brief    数据源的内容或总行数发生改变，丢弃缓存并重新请求可视行
+  * @param    table : 目标表格
+  * @return   成功返回0 
+*/
+int wg_table_virtual_reset(struct table *table);
+
+
+/**
+  * @brief    在后台线程中从文件加载 CSV/TSV 数据
+  * @param    table : 目标表格
+  * @param    path  : 文件路径
+  * @param    delim : 字段分隔符，如 ',' 或 '\t'，为 0 时使用 ','
+  * @param    flags : @see enum table_load_flags
+  * @note     表格无列时以首行创建列；数据分批加入表格，加载期间表格可正常操作，
+  *           页脚显示加载进度。普通文件以 mmap 映射后解析
+  * @return   成功返回0 
+*/
+int wg_table_load_file(struct table *table,const char *path,int delim,int flags);
+
+
+/**
+  * @brief    在后台线程中从 fd(如管道) 加载 CSV/TSV 数据，读取至文件末尾
+  * @param    table : 目标表格
+  * @param    fd    : 文件描述符，加载结束后不会被关闭
+  * @param    delim : 字段分隔符，如 ',' 或 '\t'，为 0 时使用 ','
+  * @param    flags : @see enum table_load_flags
+  * @return   成功返回0 
+*/
+int wg_table_load_fd(struct table *table,int fd,int delim,int flags);
+
+
+/**
+  * @brief    等待后台加载结束
+  * @param    table : 目标表格
+  * @note     wg_table_clear() 和销毁表格时会取消进行中的加载
+  * @return   加载的行数，无加载任务返回 -1
+*/
+int wg_table_load_wait(struct table *table);
+
 #endif /* __CURSES_GRID_ */
@@ -88,9 +88,9 @@ int wg_textarea_put(struct textarea *area,struct nwidget *parent,int y,int x);
   * @brief  文本显示追加
   * @param  area : 目标窗体
   * @param  str : 追加字符串
-  * @note   原理上 scrollok(WINDOW*) 后窗体可实现自动滚动,
-  *         但在有背景色的情况下追加 '\n' 的字符串会导致背景色割裂，
-  *         所以此处对字符串按照 '\n' 分割，并对每行的空白处进行空字符串填补
+  * @note   文本按 '\n' 分割储存；窗口停在底部时 scrollok(WINDOW*) 后直接在末尾输出，
+  *         由窗体自动滚动。背景色以 wbkgd() 设置，滚动露出的行和 '\n' 清除的行尾
+  *         均以背景填充，不会割裂
   * @return 返回是否需要刷新
 */
 int wg_textarea_append(struct textarea *area, const char *str);
@@ -0,0 +1,1038 @@
+/* table 控件各接口的自检，不需交互，返回值为未通过的检查数 */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "wg_component.h"
+#include "wg_search.h"
+
+static int checks,failures;
+static char report[8192];
+
+#define CHECK(cond) do { \
+	checks++; \
+	if (!(cond)) { \
+		failures++; \
+		snprintf(report + strlen(report),sizeof(report) - strlen(report), \
+			"%s:%d: %s\n",__FUNCTION__,__LINE__,#cond); \
+	} \
+} while (0)
+
+
+/**
+  * @brief    创建一个已放置的表格，列名为 c0,c1...
+*/
+static struct table *table_new(int cols,int flags)
+{
+	static char *names[] = {"c0","c1","c2","c3"};
+	struct table *table = wg_table_create(12,60,flags | TABLE_BORDER | TABLE_TITLE);
+
+	for (int i = 0; i < cols; i++)
+		wg_table_column_add(table,names[i],12);
+	wg_table_put(table,&desktop,0,0);
+	return table;
+}
+
+
+static char **row_add(struct table *table,const char *a,const char *b)
+{
+	char *values[] = {(char *)a,(char *)b};
+	return wg_table_item_add(table,values);
+}
+
+
+static void test_rank(void)
+{
+	struct table *table = table_new(2,0);
+	char name[16];
+
+	for (int i = 0; i < 1000; i++) {
+		snprintf(name,sizeof(name),"r%04d",i);
+		row_add(table,name,i % 2 ? "odd" : "even");
+	}
+	CHECK(table->lines == 1000);
+	CHECK(!strcmp(wg_table_values(table,0)[0],"r0000"));
+	CHECK(!strcmp(wg_table_values(table,500)[0],"r0500"));
+	CHECK(!strcmp(wg_table_value(table,999,1),"odd"));
+	CHECK(wg_table_values(table,1000) == NULL);
+
+	wg_table_jump_to(table,700);
+	CHECK(wg_table_current_line(table) == 700);
+	CHECK(!wg_table_cell_update(table,700,1,"x"));
+	CHECK(!strcmp(wg_table_value(table,700,1),"x"));
+
+	wg_table_clear(table);
+	CHECK(table->lines == 0 && wg_table_values(table,0) == NULL);
+	row_add(table,"after","clear");
+	CHECK(table->lines == 1 && !strcmp(wg_table_values(table,0)[0],"after"));
+	widget_delete(&table->wg);
+}
+
+
+static int source_rows(struct table *table,void *arg)
+{
+	return *(int *)arg;
+}
+
+
+static int source_fill(struct table *table,int line,int col,char *value,int size,void *arg)
+{
+	if (col == 1 && line % 2)
+		return TABLE_FILL_PENDING;
+	snprintf(value,size,"v%d.%d",line,col);
+	return TABLE_FILL_DONE;
+}
+
+
+static void test_virtual(void)
+{
+	static int rows = 100000;
+	struct table_source source = {source_rows,source_fill,&rows};
+	struct table *table = table_new(2,0);
+
+	CHECK(!wg_table_virtual(table,&source));
+	CHECK(table->lines == 100000);
+	CHECK(!strcmp(wg_table_values(table,99998)[1],"v99998.1"));
+	CHECK(!strcmp(wg_table_values(table,99999)[1],TABLE_PLACEHOLDER));
+	CHECK(!wg_table_virtual_fill(table,99999,1,"late"));
+	CHECK(!strcmp(wg_table_value(table,99999,1),"late"));
+	CHECK(wg_table_item_add(table,(char *[]){"a","b"}) == NULL);
+
+	/* 数据源行数改变 */
+	rows = 10;
+	CHECK(!wg_table_virtual_reset(table));
+	CHECK(table->lines == 10 && wg_table_values(table,10) == NULL);
+	CHECK(!strcmp(wg_table_value(table,9,0),"v9.0"));
+	widget_delete(&table->wg);
+}
+
+
+static void test_filter(void)
+{
+	struct table *table = table_new(2,0);
+	char name[16];
+
+	for (int i = 0; i < 1000; i++) {
+		snprintf(name,sizeof(name),"item%d",i);
+		row_add(table,name,i % 2 ? "odd" : "even");
+	}
+	CHECK(wg_table_filter(table,"item1") == 111);
+	CHECK(wg_table_filter(table,"item12") == 11);
+	CHECK(!strcmp(wg_table_values(table,0)[0],"item12"));
+	CHECK(wg_table_filter(table,"item1") == 111);
+	CHECK(wg_table_filter(table,"nothing") == 0);
+
+	/* 过滤期间新增的行即时检索 */
+	CHECK(wg_table_filter(table,"item12") == 11);
+	row_add(table,"item1200","odd");
+	CHECK(table->filter == 12);
+	row_add(table,"other","odd");
+	CHECK(table->filter == 12);
+	CHECK(!wg_table_cell_update(table,0,0,"renamed"));
+	CHECK(wg_table_filter(table,"item1") == 111);
+	CHECK(wg_table_filter(table,NULL) == 1002);
+	CHECK(!strcmp(wg_table_values(table,12)[0],"renamed"));
+	widget_delete(&table->wg);
+}
+
+
+static void test_scan(void)
+{
+	static const char text[] = "the quick brown fox jumps over the lazy dog";
+	struct table *table = table_new(2,0);
+	char name[32];
+
+	CHECK(wg_memmem(text,sizeof(text) - 1,"lazy",4) == strstr(text,"lazy"));
+	CHECK(wg_memmem(text,sizeof(text) - 1,"dog!",4) == NULL);
+	CHECK(wg_memmem(text,sizeof(text) - 1,"t",1) == text);
+
+	/* 多个线程分段检索，结果保持显示顺序 */
+	for (int i = 0; i < 100000; i++) {
+		snprintf(name,sizeof(name),"node-%05d",i);
+		row_add(table,name,i % 7 ? "up" : "down");
+	}
+	CHECK(wg_table_filter(table,"down") == 14286);
+	CHECK(!strcmp(wg_table_values(table,1)[0],"node-00007"));
+	CHECK(wg_table_filter(table,"node-999") == 100);
+	CHECK(!strcmp(wg_table_values(table,99)[0],"node-99999"));
+	wg_table_filter(table,NULL);
+	widget_delete(&table->wg);
+}
+
+
+/**
+  * @brief    等待后台排序结束
+*/
+static void sort_wait(struct table *table)
+{
+	for (int i = 0; i < 2000 && table->sort_pending; i++)
+		usleep(1000);
+}
+
+
+static void test_sort(void)
+{
+	struct table *table = table_new(2,0);
+	struct table_sort_key keys[2] = {{1,TABLE_SORT_INT,1},{0,TABLE_SORT_STRING,0}};
+	char name[16],score[16];
+
+	for (int i = 0; i < 5000; i++) {
+		snprintf(name,sizeof(name),"p%d",i);
+		snprintf(score,sizeof(score),"%d",(i * 7919) % 5000);
+		row_add(table,name,score);
+	}
+	CHECK(!wg_table_sort(table,keys,1));
+	sort_wait(table);
+	CHECK(!table->sort_pending);
+	CHECK(!strcmp(wg_table_values(table,0)[1],"4999"));
+	CHECK(!strcmp(wg_table_values(table,4999)[1],"0"));
+
+	/* 次排序键 */
+	for (int i = 0; i < 3; i++)
+		row_add(table,i == 1 ? "a" : "b","4999");
+	CHECK(!wg_table_sort(table,keys,2));
+	sort_wait(table);
+	CHECK(!strcmp(wg_table_values(table,0)[0],"a"));
+	CHECK(!strcmp(wg_table_values(table,2)[0],"b"));
+	CHECK(wg_table_values(table,3)[0][0] == 'p');
+	CHECK(!strcmp(wg_table_values(table,4)[1],"4998"));
+
+	/* 过滤视图同样有序 */
+	CHECK(wg_table_filter(table,"p1") > 0);
+	CHECK(atoi(wg_table_values(table,0)[1]) >= atoi(wg_table_values(table,1)[1]));
+	wg_table_filter(table,NULL);
+
+	/* 恢复插入顺序 */
+	CHECK(!wg_table_sort(table,NULL,0));
+	CHECK(!strcmp(wg_table_values(table,0)[0],"p0"));
+	CHECK(!strcmp(wg_table_values(table,5002)[0],"b"));
+	widget_delete(&table->wg);
+}
+
+
+static void test_batch(void)
+{
+	static char *names[] = {"c0","c1","c2","c3"};
+	static const int widths[] = {8,8,0,8};
+	struct table *table = wg_table_create(12,60,TABLE_BORDER | TABLE_TITLE);
+	char *cells[500][4],**rows[500],name[500][16];
+
+	CHECK(!wg_table_columns_add(table,names,widths,4));
+	CHECK(table->cols == 3);
+	wg_table_put(table,&desktop,0,0);
+	for (int i = 0; i < 500; i++) {
+		snprintf(name[i],sizeof(name[i]),"b%d",i);
+		cells[i][0] = name[i];
+		cells[i][1] = "x";
+		cells[i][2] = "y";
+		rows[i] = cells[i];
+	}
+	CHECK(wg_table_items_add_batch(table,rows,500) == 500);
+	CHECK(table->lines == 500);
+	CHECK(!strcmp(wg_table_values(table,0)[0],"b0"));
+	CHECK(!strcmp(wg_table_value(table,499,2),"y"));
+	CHECK(wg_table_items_add_batch(table,rows,0) == 0);
+	widget_delete(&table->wg);
+}
+
+
+static void test_packed(void)
+{
+	struct table *table = table_new(3,0);
+	char *values[3],longer[400];
+
+	memset(longer,'L',sizeof(longer) - 1);
+	longer[sizeof(longer) - 1] = '\0';
+	values[0] = "";
+	values[1] = longer;
+	values[2] = "tail";
+	wg_table_item_add(table,values);
+	values[0] = "next";
+	values[1] = "row";
+	values[2] = "";
+	wg_table_item_add(table,values);
+
+	/* 单元格不再按表格宽度截断 */
+	CHECK(strlen(wg_table_value(table,0,1)) == sizeof(longer) - 1);
+	CHECK(!strcmp(wg_table_value(table,0,0),""));
+
+	/* 变短原地写入，变长重新存放，其他单元格不变 */
+	CHECK(!wg_table_cell_update(table,0,1,"short"));
+	CHECK(!strcmp(wg_table_value(table,0,1),"short"));
+	CHECK(!wg_table_cell_update(table,0,0,longer));
+	CHECK(!strcmp(wg_table_value(table,0,0),longer));
+	CHECK(!strcmp(wg_table_value(table,0,1),"short"));
+	CHECK(!strcmp(wg_table_value(table,0,2),"tail"));
+	CHECK(!strcmp(wg_table_value(table,1,0),"next"));
+	widget_delete(&table->wg);
+}
+
+
+static void test_arena(void)
+{
+	struct table *table = table_new(2,0);
+	size_t live;
+	char name[16];
+
+	for (int i = 0; i < 5000; i++) {
+		snprintf(name,sizeof(name),"a%d",i);
+		row_add(table,name,"value");
+	}
+	live = table->arena.live;
+	CHECK(live > 0 && table->arena.reserved >= live);
+
+	/* 行及变长后的单元格均从内存池中分配和释放 */
+	CHECK(!wg_table_cell_update(table,0,1,"a value longer than the one before"));
+	CHECK(table->arena.live > live);
+	CHECK(!wg_table_cell_update(table,0,1,"v"));
+
+	/* 清空表格时整体释放 */
+	wg_table_clear(table);
+	CHECK(table->arena.live == 0 && table->arena.reserved == 0);
+	row_add(table,"again","1");
+	CHECK(table->arena.live > 0 && !strcmp(wg_table_values(table,0)[0],"again"));
+	widget_delete(&table->wg);
+}
+
+
+/**
+  * @brief    读出表格可视区域第 y 行已绘制的内容
+*/
+static char *screen_line(struct table *table,int y,char *buf,int size)
+{
+	buf[0] = '\0';
+	mvwinnstr(table->window,y,0,buf,size - 1);
+	return buf;
+}
+
+
+static void test_rcache(void)
+{
+	struct table *table = table_new(2,0);
+	char buf[128];
+
+	row_add(table,"first","1");
+	row_add(table,"second","2");
+	CHECK(strstr(screen_line(table,0,buf,sizeof(buf)),"first"));
+
+	/* 内容改变后缓存的显示内容随之失效 */
+	CHECK(!wg_table_cell_update(table,0,0,"changed"));
+	CHECK(strstr(screen_line(table,0,buf,sizeof(buf)),"changed"));
+	CHECK(!strstr(buf,"first"));
+	CHECK(strstr(screen_line(table,1,buf,sizeof(buf)),"second"));
+
+	/* 超过列宽的内容截断显示 */
+	CHECK(!wg_table_cell_update(table,1,0,"a value much wider than the column"));
+	CHECK(strstr(screen_line(table,1,buf,sizeof(buf)),"a value") && !strstr(buf,"column"));
+	widget_delete(&table->wg);
+}
+
+
+/**
+  * @brief    模拟按键，调用控件对应的快捷键处理函数
+*/
+static void press(struct nwidget *wg,long key)
+{
+	for (int i = 0; i < MAX_HANDLERS && wg->handlers[i]; i++) {
+		if (wg->shortcuts[i] == key) {
+			wg->handlers[i](wg,key);
+			return;
+		}
+	}
+}
+
+
+static void test_scroll(void)
+{
+	struct table *table = table_new(2,0);
+	struct textarea *area;
+	int visible_height = table->wg.height - table->show_border - table->show_title;
+	char name[16],buf[128];
+	int filled = 1;
+
+	for (int i = 0; i < 50; i++) {
+		snprintf(name,sizeof(name),"s%02d",i);
+		row_add(table,name,"");
+	}
+	wg_table_jump_to(table,0);
+
+	/* 逐行下移越过可视区域底部时滚动一行，新露出的行为下一行 */
+	for (int i = 0; i < visible_height; i++)
+		press(&table->wg,KEY_DOWN);
+	CHECK(table->current_line == visible_height && table->start_line == 1);
+	snprintf(name,sizeof(name),"s%02d",visible_height);
+	CHECK(strstr(screen_line(table,visible_height - 1,buf,sizeof(buf)),name));
+	CHECK(strstr(screen_line(table,0,buf,sizeof(buf)),"s01"));
+	for (int i = 0; i < visible_height; i++)
+		press(&table->wg,KEY_UP);
+	CHECK(table->current_line == 0 && table->start_line == 0);
+	CHECK(strstr(screen_line(table,0,buf,sizeof(buf)),"s00"));
+	widget_delete(&table->wg);
+
+	/* 文本框停在底部时追加内容，窗口滚动后末行为新内容 */
+	area = wg_textarea_create(5,30,100,0);
+	wg_textarea_put(area,&desktop,0,0);
+	wbkgd(area->win,A_REVERSE);
+	for (int i = 0; i < 20; i++) {
+		snprintf(name,sizeof(name),"line%d\n",i);
+		wg_textarea_append(area,name);
+	}
+	buf[0] = '\0';
+	mvwinnstr(area->win,getmaxy(area->win) - 1,0,buf,sizeof(buf) - 1);
+	CHECK(strstr(buf,"line19"));
+	mvwinnstr(area->win,getmaxy(area->win) - 2,0,buf,sizeof(buf) - 1);
+	CHECK(strstr(buf,"line18"));
+
+	/* 滚动露出的行整行为背景色，行尾的空白处没有割裂 */
+	for (int y = 0; y < getmaxy(area->win); y++) {
+		for (int x = 0; x < getmaxx(area->win); x++)
+			filled = filled && (mvwinch(area->win,y,x) & A_REVERSE);
+	}
+	CHECK(filled);
+	widget_delete(&area->wg);
+}
+
+
+static void test_load(void)
+{
+	static const char csv[] =
+		"name,note\r\n"
+		"plain,one\r\n"
+		"\"quoted, comma\",\"say \"\"hi\"\"\"\r\n"
+		"\"multi\nline\",last\n";
+	char path[] = "/tmp/nwidget_table_XXXXXX";
+	struct table *table = wg_table_create(12,60,TABLE_BORDER|TABLE_TITLE);
+	int fd = mkstemp(path);
+
+	CHECK(fd >= 0 && write(fd,csv,sizeof(csv) - 1) == sizeof(csv) - 1);
+	close(fd);
+	CHECK(!wg_table_load_file(table,path,',',TABLE_LOAD_HEADER));
+	CHECK(wg_table_load_wait(table) == 3);
+	CHECK(table->cols == 2 && table->lines == 3);
+	CHECK(!strcmp(wg_table_values(table,0)[1],"one"));
+	CHECK(!strcmp(wg_table_values(table,1)[0],"quoted, comma"));
+	CHECK(!strcmp(wg_table_values(table,1)[1],"say \"hi\""));
+	CHECK(!strcmp(wg_table_values(table,2)[0],"multi\nline"));
+
+	/* 无表头时第一行也是数据，TSV 以制表符分隔 */
+	fd = open(path,O_WRONLY | O_TRUNC);
+	CHECK(fd >= 0 && write(fd,"a\tb\nc\td\n",8) == 8);
+	close(fd);
+	wg_table_clear(table);
+	CHECK(!wg_table_load_file(table,path,'\t',0));
+	CHECK(wg_table_load_wait(table) == 2);
+	CHECK(!strcmp(wg_table_values(table,0)[0],"a") && !strcmp(wg_table_values(table,1)[1],"d"));
+	CHECK(wg_table_load_file(table,"/nonexistent/file.csv",',',0) == -1);
+	unlink(path);
+	widget_delete(&table->wg);
+}
+
+
+static void test_rows(void)
+{
+	struct table *table = table_new(2,0);
+	char **first,**row = NULL;
+	char name[16];
+
+	first = row_add(table,"a","1");
+	for (int i = 1; i < 1000; i++) {
+		snprintf(name,sizeof(name),"r%04d",i);
+		row = row_add(table,name,"2");
+	}
+	CHECK(wg_table_row_line(table,first) == 0);
+	CHECK(wg_table_row_line(table,row) == 999);
+
+	/* 内容变长时重新存放，句柄仍有效 */
+	CHECK(!wg_table_row_update(table,first,0,"a much longer value than before"));
+	CHECK(!strcmp(first[0],"a much longer value than before"));
+	CHECK(wg_table_row_update(table,first,2,"x") == -1);
+
+	/* 被过滤掉的行没有行号 */
+	CHECK(wg_table_filter(table,"r0999") == 1);
+	CHECK(wg_table_row_line(table,first) == -1);
+	CHECK(wg_table_row_line(table,row) == 0);
+	wg_table_filter(table,NULL);
+
+	CHECK(!wg_table_row_delete(table,first));
+	CHECK(table->lines == 999);
+	CHECK(!strcmp(wg_table_values(table,0)[0],"r0001"));
+	CHECK(wg_table_row_line(table,row) == 998);
+	widget_delete(&table->wg);
+}
+
+
+static int evictions;
+
+/**
+  * @brief    记录被淘汰的行数和最后一行的内容，句柄只在回调中有效
+*/
+static int evicted_count(struct table *table,char **row,void *arg)
+{
+	snprintf(arg,16,"%s",row[0]);
+	evictions++;
+	return 0;
+}
+
+
+static void test_max_rows(void)
+{
+	struct table *table = table_new(2,0);
+	char name[16],last[16] = "",**row;
+
+	evictions = 0;
+	CHECK(!wg_table_on_evict(table,evicted_count,last));
+	CHECK(!wg_table_max_rows(table,100));
+	for (int i = 0; i < 250; i++) {
+		snprintf(name,sizeof(name),"e%d",i);
+		row_add(table,name,"");
+	}
+	CHECK(table->lines == 100);
+	CHECK(!strcmp(wg_table_values(table,0)[0],"e150"));
+	CHECK(evictions == 150 && !strcmp(last,"e149"));
+
+	/* 缩小上限时立即淘汰 */
+	CHECK(!wg_table_max_rows(table,10));
+	CHECK(table->lines == 10 && evictions == 240 && !strcmp(last,"e239"));
+	CHECK(!wg_table_max_rows(table,0));
+	row = row_add(table,"unbounded","");
+	CHECK(table->lines == 11 && evictions == 240);
+
+	/* 手动删除不是淘汰，不通知 */
+	CHECK(!wg_table_row_delete(table,row));
+	CHECK(evictions == 240);
+	CHECK(!wg_table_on_evict(table,NULL,NULL));
+	CHECK(wg_table_max_rows(table,-1) == -1);
+	widget_delete(&table->wg);
+}
+
+
+static void test_ttl(void)
+{
+	struct table *table = table_new(2,0);
+	char name[16],last[16] = "",**kept;
+
+	for (int i = 0; i < 100; i++) {
+		snprintf(name,sizeof(name),"t%d",i);
+		row_add(table,name,"");
+	}
+	kept = wg_table_values(table,50);
+	evictions = 0;
+	CHECK(!wg_table_on_evict(table,evicted_count,last));
+	CHECK(!wg_table_ttl(table,50));
+	CHECK(table->lines == 100);
+	usleep(30 * 1000);
+
+	/* 更新过的行重新计时 */
+	CHECK(!wg_table_row_update(table,kept,1,"touched"));
+	usleep(30 * 1000);
+	row_add(table,"fresh","");
+	CHECK(wg_table_expire(table) == 99);
+	CHECK(table->lines == 2 && evictions == 99 && !strcmp(last,"t99"));
+	CHECK(!strcmp(wg_table_values(table,0)[0],"t50"));
+	CHECK(wg_table_expire(table) == 0);
+
+	CHECK(!wg_table_ttl(table,0));
+	usleep(60 * 1000);
+	CHECK(wg_table_expire(table) == 0 && table->lines == 2);
+	widget_delete(&table->wg);
+}
+
+
+static void test_keys(void)
+{
+	struct table *table = table_new(2,0);
+	char *values[2];
+	char **row;
+
+	row_add(table,"old","0");
+	CHECK(!wg_table_key(table,0));
+	CHECK(wg_table_find(table,"old") == 0);
+	values[0] = "a";
+	values[1] = "1";
+	row = wg_table_upsert(table,values);
+	values[1] = "2";
+	CHECK(wg_table_upsert(table,values) == row);
+	CHECK(!strcmp(row[1],"2"));
+	values[0] = "b";
+	CHECK(wg_table_upsert(table,values) != row);
+	CHECK(table->lines == 3);
+	CHECK(wg_table_find(table,"b") == 2);
+	CHECK(wg_table_find(table,"z") == -1);
+
+	/* 键列内容改变或行被删除时索引随之更新 */
+	CHECK(!wg_table_row_update(table,row,0,"z"));
+	CHECK(wg_table_find(table,"a") == -1 && wg_table_find(table,"z") == 1);
+	CHECK(!wg_table_row_delete(table,row));
+	CHECK(wg_table_find(table,"z") == -1);
+	CHECK(wg_table_find(table,"b") == 1);
+	widget_delete(&table->wg);
+}
+
+
+static void test_snapshot(void)
+{
+	struct table *table = table_new(2,0);
+	char *snap[3][2] = {{"a","1"},{"c","3"},{"d","4"}};
+	char *values[2],**rows[3],**row,last[16] = "";
+
+	values[0] = "a";
+	values[1] = "1";
+	row_add(table,"b","2");
+	row = row_add(table,values[0],values[1]);
+	for (int i = 0; i < 2 && wg_table_current_line(table) < 1; i++)
+		press(&table->wg,KEY_DOWN);
+	CHECK(wg_table_current_line(table) == 1);
+
+	/* 快照中没有的行被删除，新行被加入，已有的行保持句柄 */
+	for (int i = 0; i < 3; i++)
+		rows[i] = snap[i];
+	evictions = 0;
+	CHECK(!wg_table_on_evict(table,evicted_count,last));
+	CHECK(!wg_table_apply_snapshot(table,rows,3,0));
+	CHECK(table->lines == 3);
+	CHECK(evictions == 1 && !strcmp(last,"b"));
+	CHECK(wg_table_find(table,"b") == -1);
+	CHECK(wg_table_row_line(table,row) == 0 && !strcmp(row[1],"1"));
+	CHECK(wg_table_current_line(table) == 0);
+	CHECK(wg_table_find(table,"d") == 2);
+
+	/* 只有单元格改变 */
+	snap[1][1] = "30";
+	CHECK(!wg_table_apply_snapshot(table,rows,3,0));
+	CHECK(!strcmp(wg_table_value(table,1,1),"30") && evictions == 1);
+	CHECK(!wg_table_apply_snapshot(table,rows,0,0));
+	CHECK(table->lines == 0 && evictions == 4);
+	CHECK(wg_table_apply_snapshot(table,rows,3,5) == -1);
+	widget_delete(&table->wg);
+}
+
+
+/**
+  * @brief    以千分位显示整数列
+*/
+static int format_k(char *buf,int size,union table_value value,void *arg)
+{
+	return snprintf(buf,size,"%lldk",value.i / 1000);
+}
+
+
+static void test_typed(void)
+{
+	static const char *states[] = {"idle","busy",NULL};
+	struct table *table = table_new(4,0);
+	char *values[4],num[16],mem[16];
+	union table_value value;
+	char **row = NULL;
+
+	CHECK(!wg_table_column_type(table,1,TABLE_COL_INT,NULL,NULL));
+	CHECK(!wg_table_column_type(table,2,TABLE_COL_ENUM,NULL,(void *)states));
+	CHECK(!wg_table_column_type(table,3,TABLE_COL_INT,format_k,NULL));
+	for (int i = 0; i < 100; i++) {
+		snprintf(num,sizeof(num),"%d",i);
+		snprintf(mem,sizeof(mem),"%d",i * 1000);
+		values[0] = num;
+		values[1] = num;
+		values[2] = i % 2 ? "1" : "0";
+		values[3] = mem;
+		row = wg_table_item_add(table,values);
+	}
+	/* 表格非空时不能改变列类型 */
+	CHECK(wg_table_column_type(table,0,TABLE_COL_INT,NULL,NULL) == -1);
+
+	CHECK(!wg_table_row_get(table,row,1,&value) && value.i == 99);
+	CHECK(!strcmp(wg_table_value(table,99,2),"busy"));
+	CHECK(!strcmp(wg_table_value(table,98,2),"idle"));
+	CHECK(!strcmp(wg_table_value(table,42,3),"42k"));
+	value.i = 1000;
+	CHECK(!wg_table_row_set(table,row,1,value));
+	CHECK(!strcmp(wg_table_value(table,99,1),"1000"));
+	CHECK(wg_table_row_get(table,row,0,&value) == -1);
+	CHECK(!wg_table_row_update(table,row,1,"7"));
+	CHECK(!wg_table_row_get(table,row,1,&value) && value.i == 7);
+
+	/* 类型列按数值检索显示的内容 */
+	CHECK(wg_table_filter(table,"busy") == 50);
+	wg_table_filter(table,NULL);
+	widget_delete(&table->wg);
+}
+
+
+static void test_dict(void)
+{
+	static const char *regions[] = {"us-east","eu-west","ap-south"};
+	struct table *table = table_new(2,0);
+	union table_value value;
+	char name[16],**row = NULL;
+
+	CHECK(!wg_table_column_type(table,1,TABLE_COL_DICT,NULL,NULL));
+	for (int i = 0; i < 3000; i++) {
+		snprintf(name,sizeof(name),"h%d",i);
+		row = row_add(table,name,regions[i % 3]);
+	}
+	CHECK(!strcmp(wg_table_value(table,0,1),"us-east"));
+	CHECK(!strcmp(wg_table_value(table,2999,1),"ap-south"));
+
+	/* 各行只存放编码，相同的字符串编码相同 */
+	CHECK(!wg_table_row_get(table,row,1,&value) && value.i == 2);
+	CHECK(!wg_table_row_update(table,row,1,"new-region"));
+	CHECK(!wg_table_row_get(table,row,1,&value) && value.i == 3);
+	CHECK(!strcmp(wg_table_value(table,2999,1),"new-region"));
+
+	/* 检索时每个字典字符串只匹配一次 */
+	CHECK(wg_table_filter(table,"west") == 1000);
+	CHECK(wg_table_filter(table,"region") == 1);
+	wg_table_filter(table,NULL);
+	widget_delete(&table->wg);
+}
+
+
+static void test_aggregate(void)
+{
+	struct table *table = table_new(2,TABLE_FOOTER);
+	char num[16],**row = NULL,**rows[100];
+	double result;
+	int ok = 1;
+
+	CHECK(!wg_table_column_type(table,1,TABLE_COL_INT,NULL,NULL));
+	for (int i = 0; i < 100; i++) {
+		snprintf(num,sizeof(num),"%d",i);
+		rows[i] = row = row_add(table,"n",num);
+	}
+	CHECK(!wg_table_aggregate(table,1,TABLE_AGG_MAX));
+	CHECK(!wg_table_aggregate_value(table,1,&result) && result == 99);
+	CHECK(!wg_table_row_update(table,row,1,"1000"));
+	CHECK(!wg_table_aggregate_value(table,1,&result) && result == 1000);
+	CHECK(!wg_table_row_delete(table,row));
+	CHECK(!wg_table_aggregate_value(table,1,&result) && result == 98);
+
+	CHECK(!wg_table_aggregate(table,1,TABLE_AGG_SUM));
+	CHECK(!wg_table_aggregate_value(table,1,&result) && result == 4851);
+	CHECK(!wg_table_aggregate(table,1,TABLE_AGG_MEAN));
+	CHECK(!wg_table_aggregate_value(table,1,&result) && result == 49);
+	CHECK(!wg_table_aggregate(table,1,TABLE_AGG_MIN));
+	CHECK(!wg_table_row_delete(table,rows[0]));
+	CHECK(!wg_table_aggregate_value(table,1,&result) && result == 1);
+
+	/* 字符串列按开头的数值计算 */
+	CHECK(!wg_table_aggregate(table,0,TABLE_AGG_COUNT));
+	CHECK(!wg_table_aggregate_value(table,0,&result) && result == 98);
+
+	/* 过滤时只聚合检出的行 */
+	CHECK(wg_table_filter(table,"5") > 0);
+	CHECK(!wg_table_aggregate(table,1,TABLE_AGG_SUM));
+	CHECK(!wg_table_aggregate_value(table,1,&result) && result == 990);
+	wg_table_filter(table,NULL);
+	CHECK(!wg_table_aggregate(table,1,TABLE_AGG_NONE));
+	CHECK(wg_table_aggregate_value(table,1,&result) == -1);
+	widget_delete(&table->wg);
+
+	/* 按先进先出淘汰最小值时随之更新，相等的值逐个移出 */
+	table = table_new(2,TABLE_FOOTER);
+	CHECK(!wg_table_max_rows(table,10));
+	CHECK(!wg_table_aggregate(table,1,TABLE_AGG_MIN));
+	for (int i = 0; i < 100; i++) {
+		snprintf(num,sizeof(num),"%d",i / 2);
+		row_add(table,"n",num);
+		ok = ok && !wg_table_aggregate_value(table,1,&result) && result == (i < 10 ? 0 : (i - 9) / 2);
+	}
+	CHECK(ok);
+	CHECK(!wg_table_aggregate(table,1,TABLE_AGG_MAX));
+	CHECK(wg_table_filter(table,"n") == 10);
+	CHECK(!wg_table_aggregate_value(table,1,&result) && result == 49);
+	CHECK(!wg_table_row_delete(table,row_add(table,"n","200")));
+	CHECK(!wg_table_aggregate_value(table,1,&result) && result == 49);
+	wg_table_filter(table,NULL);
+	widget_delete(&table->wg);
+}
+
+
+static void test_columns(void)
+{
+	struct table *table = wg_table_create(12,60,TABLE_BORDER | TABLE_TITLE);
+	char *names[40],*values[40],title[40][8];
+	int widths[40];
+
+	for (int i = 0; i < 40; i++) {
+		snprintf(title[i],sizeof(title[i]),"k%d",i);
+		names[i] = values[i] = title[i];
+		widths[i] = 4;
+	}
+	CHECK(!wg_table_columns_add(table,names,widths,40));
+	wg_table_put(table,&desktop,0,0);
+	wg_table_item_add(table,values);
+	CHECK(table->cols == 40 && table->shown_cols == 40);
+
+	/* 逐列右移直至最后一列可见，超过 16 列后仍可继续 */
+	for (int i = 0; i < 40; i++)
+		press(&table->wg,'>');
+	CHECK(table->start_col > 16);
+	CHECK(table->visible_cols > 0 && table->visible[table->visible_cols - 1]->index == 39);
+	CHECK(!strcmp(wg_table_value(table,0,39),"k39"));
+	for (int i = 0; i < 40; i++)
+		press(&table->wg,'<');
+	CHECK(table->start_col == 0 && table->visible[0]->index == 0);
+	widget_delete(&table->wg);
+}
+
+
+static void test_where(void)
+{
+	struct table *table = table_new(3,0);
+	char *values[3],name[16],num[16];
+
+	CHECK(!wg_table_column_type(table,2,TABLE_COL_INT,NULL,NULL));
+	for (int i = 0; i < 1000; i++) {
+		snprintf(name,sizeof(name),"item%d",i);
+		snprintf(num,sizeof(num),"%d",i);
+		values[0] = name;
+		values[1] = i % 2 ? "odd" : "even";
+		values[2] = num;
+		wg_table_item_add(table,values);
+	}
+
+	/* 条件过滤，与关键词过滤同时生效 */
+	CHECK(wg_table_where(table,"c1 == even") == 500);
+	CHECK(wg_table_filter(table,"item1") == 55);
+	CHECK(wg_table_where(table,"c1 in (odd,even) && !(c0 == item10)") == 110);
+	CHECK(wg_table_where(table,"c1 ==") == -1);
+	CHECK(wg_table_where(table,"nocol == 1") == -1);
+	wg_table_filter(table,NULL);
+	CHECK(wg_table_where(table,"c2 >= 990 || c0 == item5") == 11);
+	CHECK(wg_table_where(table,"c2 < 10") == 10);
+
+	/* 新增的行同样按条件过滤 */
+	values[0] = "late";
+	values[2] = "3";
+	wg_table_item_add(table,values);
+	CHECK(table->filter == 11);
+	CHECK(wg_table_where(table,NULL) == 1001);
+	widget_delete(&table->wg);
+}
+
+
+/**
+  * @brief    等待后台模糊匹配的结果，直至视图中有 count 行
+*/
+static void fuzzy_wait(struct table *table,int count)
+{
+	for (int i = 0; i < 2000 && table->filter != count; i++)
+		usleep(1000);
+}
+
+
+static void test_fuzzy(void)
+{
+	struct table *table = table_new(2,0);
+	char name[32],**rows[100];
+
+	for (int i = 0; i < 3000; i++) {
+		snprintf(name,sizeof(name),"host-%d.example.com",i);
+		row_add(table,name,i % 2 ? "prod" : "dev");
+	}
+	row_add(table,"webprod","");
+	CHECK(!wg_table_fuzzy(table,"webprod",5));
+	fuzzy_wait(table,1);
+	CHECK(table->filter == 1);
+	CHECK(!strcmp(wg_table_values(table,0)[0],"webprod"));
+
+	/* 子序列匹配，紧凑的匹配排在前面 */
+	CHECK(!wg_table_fuzzy(table,"h1ex",10));
+	fuzzy_wait(table,10);
+	CHECK(table->filter == 10);
+	CHECK(!strncmp(wg_table_values(table,0)[0],"host-1.",7));
+
+	CHECK(!wg_table_fuzzy(table,"host",10));
+	fuzzy_wait(table,10);
+	CHECK(table->filter == 10);
+	CHECK(!wg_table_fuzzy(table,NULL,0));
+	CHECK(table->filter == 0 && table->lines == 3001);
+	widget_delete(&table->wg);
+
+	/* 删除视图中的行或其不再匹配后在后台补足 top_k 行 */
+	table = table_new(2,0);
+	for (int i = 0; i < 100; i++) {
+		snprintf(name,sizeof(name),"host%02d",i);
+		rows[i] = row_add(table,name,"x");
+	}
+	CHECK(!wg_table_fuzzy(table,"host",10));
+	fuzzy_wait(table,10);
+	CHECK(!strcmp(wg_table_values(table,0)[0],"host00"));
+	CHECK(!wg_table_row_delete(table,rows[0]));
+	fuzzy_wait(table,10);
+	CHECK(table->filter == 10);
+	CHECK(!strcmp(wg_table_values(table,9)[0],"host10"));
+	CHECK(!wg_table_row_update(table,rows[1],0,"zzz"));
+	fuzzy_wait(table,10);
+	CHECK(table->filter == 10);
+	CHECK(!strcmp(wg_table_values(table,9)[0],"host11"));
+
+	/* 快照在增删改后沿用，修改和新增的行按当前内容计分，不重复出现 */
+	CHECK(!wg_table_row_update(table,rows[99],0,"host"));
+	row_add(table,"hos","x");
+	CHECK(!wg_table_fuzzy(table,"ho",10));
+	for (int i = 0; i < 2000 && strcmp(wg_table_values(table,0)[0],"hos"); i++)
+		usleep(1000);
+	CHECK(!strcmp(wg_table_values(table,0)[0],"hos"));
+	CHECK(!strcmp(wg_table_values(table,1)[0],"host"));
+	CHECK(!strcmp(wg_table_values(table,2)[0],"host02"));
+	widget_delete(&table->wg);
+}
+
+
+static void test_pinyin(void)
+{
+	struct table *table = table_new(2,0);
+	char longkey[200];
+	char **row;
+
+	row_add(table,"张三","a");
+	row = row_add(table,"李四","b");
+	CHECK(!wg_table_column_search(table,0,1));
+	CHECK(wg_table_filter(table,"zs") == 1);
+	CHECK(wg_table_filter(table,"lisi") == 1);
+	CHECK(wg_table_filter(table,"LS") == 1);
+	row_add(table,"Zhang Wei","c");
+	CHECK(wg_table_filter(table,"zhang") == 2);
+	CHECK(!wg_table_row_update(table,row,0,"重庆银行"));
+	CHECK(wg_table_filter(table,"zqyx") == 1);
+	CHECK(wg_table_filter(table,"ls") == 0);
+
+	/* 超过 table->keyword 长度的关键词截断后检索 */
+	memset(longkey,'z',sizeof(longkey) - 1);
+	longkey[sizeof(longkey) - 1] = '\0';
+	CHECK(wg_table_filter(table,longkey) == 0);
+	CHECK(strlen(table->keyword) == sizeof(table->keyword) - 1);
+	CHECK(wg_table_filter(table,"ZHANG") == 2);
+	wg_table_filter(table,NULL);
+
+	/* 关闭索引后只按原内容检索 */
+	CHECK(!wg_table_column_search(table,0,0));
+	CHECK(wg_table_filter(table,"zs") == 0);
+	wg_table_filter(table,NULL);
+	CHECK(wg_table_column_type(table,0,TABLE_COL_INT,NULL,NULL) == -1);
+	widget_delete(&table->wg);
+}
+
+
+static void test_facet(void)
+{
+	struct table *table = table_new(2,TABLE_FACET);
+	char **rows[10],**many[200],buf[16];
+
+	for (int i = 0; i < 10; i++)
+		rows[i] = row_add(table,i % 3 ? "eu" : "us","x");
+	CHECK(!wg_table_facet(table,0,1));
+	CHECK(wg_table_facet_count(table,0,"us") == 4);
+	CHECK(wg_table_facet_count(table,0,"eu") == 6);
+	CHECK(wg_table_facet_count(table,0,"cn") == 0);
+	CHECK(wg_table_facet_count(table,1,"x") == -1);
+
+	CHECK(!wg_table_row_update(table,rows[0],0,"cn"));
+	CHECK(!wg_table_row_delete(table,rows[1]));
+	CHECK(wg_table_facet_count(table,0,"us") == 3);
+	CHECK(wg_table_facet_count(table,0,"eu") == 5);
+	CHECK(wg_table_facet_count(table,0,"cn") == 1);
+
+	wg_table_clear(table);
+	CHECK(wg_table_facet_count(table,0,"eu") == 0);
+
+	/* 删除过半取值触发压缩，之后继续写入 */
+	for (int i = 0; i < 200; i++) {
+		snprintf(buf,sizeof(buf),"v%d",i);
+		many[i] = row_add(table,buf,"x");
+	}
+	for (int i = 0; i < 140; i++)
+		CHECK(!wg_table_row_delete(table,many[i]));
+	for (int i = 200; i < 300; i++) {
+		snprintf(buf,sizeof(buf),"v%d",i);
+		row_add(table,buf,"x");
+	}
+	row_add(table,"v150","x");
+	CHECK(wg_table_facet_count(table,0,"v10") == 0);
+	CHECK(wg_table_facet_count(table,0,"v150") == 2);
+	CHECK(wg_table_facet_count(table,0,"v299") == 1);
+	CHECK(table->lines == 161);
+	widget_delete(&table->wg);
+}
+
+
+static void test_sorted_insert(void)
+{
+	struct table *table = table_new(2,0);
+	struct table_sort_key key = {1,TABLE_SORT_INT,1};
+	char name[16],score[16];
+	char **row = NULL;
+
+	for (int i = 0; i < 5000; i++) {
+		snprintf(name,sizeof(name),"p%d",i);
+		snprintf(score,sizeof(score),"%d",(i * 7919) % 5000);
+		row = row_add(table,name,score);
+	}
+	CHECK(!wg_table_sort(table,&key,1));
+	sort_wait(table);
+
+	/* 排序键被修改的行和新增的行直接插入有序位置 */
+	CHECK(!wg_table_row_update(table,row,1,"100000"));
+	CHECK(wg_table_row_line(table,row) == 0);
+	row = row_add(table,"last","-1");
+	CHECK(wg_table_row_line(table,row) == 5000);
+
+	/* 选中行随行移动 */
+	wg_table_jump_to(table,10);
+	row = wg_table_values(table,10);
+	CHECK(!wg_table_row_update(table,row,1,"200000"));
+	CHECK(wg_table_current_line(table) == 0);
+	CHECK(wg_table_values(table,wg_table_current_line(table)) == row);
+
+	/* 空表格排序后持续保持有序 */
+	wg_table_clear(table);
+	key.descending = 0;
+	CHECK(!wg_table_sort(table,&key,1));
+	CHECK(!table->sort_pending);
+	for (int i = 0; i < 100; i++) {
+		snprintf(score,sizeof(score),"%d",(i * 37) % 100);
+		row_add(table,"x",score);
+	}
+	for (int i = 0; i < 100; i++) {
+		snprintf(score,sizeof(score),"%d",i);
+		CHECK(!strcmp(wg_table_values(table,i)[1],score));
+	}
+	widget_delete(&table->wg);
+}
+
+
+int main(int argc, char *argv[])
+{
+	desktop_init(NULL);
+
+	test_rank();
+	test_virtual();
+	test_filter();
+	test_scan();
+	test_sort();
+	test_batch();
+	test_packed();
+	test_arena();
+	test_rcache();
+	test_scroll();
+	test_load();
+	test_rows();
+	test_max_rows();
+	test_ttl();
+	test_keys();
+	test_snapshot();
+	test_typed();
+	test_dict();
+	test_aggregate();
+	test_columns();
+	test_where();
+	test_fuzzy();
+	test_pinyin();
+	test_facet();
+	test_sorted_insert();
+
+	endwin();
+	printf("%s%d/%d checks passed\n",report,checks - failures,checks);
+	return failures;
+}